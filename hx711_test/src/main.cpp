@@ -1,36 +1,26 @@
 #include <Arduino.h>
 #include "HX711.h"
+#include <StabilityDetector.h>
 
 // Adjust pins if your wiring uses different GPIOs
 #define LOADCELL_DOUT_PIN 16
 #define LOADCELL_SCK_PIN 18
 #define SCALE_FACTOR 4264.66  // Calibrated with 48.1g reference weight on 2025-10-28
-#define HISTORY_SIZE 20       // Number of samples to keep for stability detection
-#define STABLE_THRESHOLD 2000  // Max variation in raw counts to consider stable (about 0.5g)
+#define STABLE_WINDOW_MS 10000 // Readings considered for stability detection (~20)
+#define STABLE_STDDEV 500      // Max standard deviation in raw counts to consider stable (about 0.1g)
+#define STABLE_SLOPE 100       // Max drift in raw counts per second
 #define STABLE_REQUIRED 5     // Number of consecutive stable readings required
 #define MOVEMENT_THRESHOLD 4000  // Raw count difference that indicates movement
+#define MOVEMENT_LAG 20          // ...against the reading this many readings back
 
 HX711 loadcell;
 
 // forward declaration for manual bit-bang read used in setup
 long manual_read_hx711(int doutPin, int sckPin);
 
-bool checkStability(long* samples, int count, float* average) {
-    if (count < HISTORY_SIZE) return false;
-    
-    long sum = 0;
-    long min_val = samples[0];
-    long max_val = samples[0];
-    
-    for(int i = 0; i < count; i++) {
-        sum += samples[i];
-        min_val = min(min_val, samples[i]);
-        max_val = max(max_val, samples[i]);
-    }
-    
-    *average = sum / (float)count;
-    return (max_val - min_val) < STABLE_THRESHOLD;
-}
+// Same detector as the firmware (lib/StabilityDetector), on raw counts
+StabilityDetector stability({STABLE_WINDOW_MS, STABLE_WINDOW_MS * 4 / 5, 10, STABLE_STDDEV / 4.0f, STABLE_STDDEV,
+                             STABLE_SLOPE, 3.0f});
 
 void printHelp() {
     Serial.println("\nCommands:");
@@ -114,8 +104,8 @@ long manual_read_hx711(int doutPin, int sckPin) {
   }
   return (long)value;
 }
-// Circular buffer for raw readings and stability detection
-long raw_history[HISTORY_SIZE];
+// Recent raw readings for the movement check
+long raw_history[MOVEMENT_LAG];
 int history_index = 0;
 unsigned long last_reading_time = 0;
 unsigned long readings_count = 0;
@@ -211,16 +201,17 @@ void loop() {
         
         // Seed history buffer on first read to avoid large initial deltas
         if (!history_seeded) {
-            for (int i = 0; i < HISTORY_SIZE; ++i) raw_history[i] = raw;
+            for (int i = 0; i < MOVEMENT_LAG; ++i) raw_history[i] = raw;
             history_seeded = true;
         }
-        // Store raw reading in history
+        // Movement is measured against the reading MOVEMENT_LAG back (~10 s),
+        // so a slow load change adds up instead of hiding under the threshold
         long prev_raw = raw_history[history_index];
         raw_history[history_index] = raw;
-        history_index = (history_index + 1) % HISTORY_SIZE;
+        history_index = (history_index + 1) % MOVEMENT_LAG;
         
-        float average;
-        bool is_stable = checkStability(raw_history, (int)min((long)readings_count + 1, (long)HISTORY_SIZE), &average);
+        bool is_stable = stability.push(now, (float)raw);
+        float average = stability.mean();
         
         // Check for movement
         if (abs(raw - prev_raw) > MOVEMENT_THRESHOLD) {
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+#include <DualHx711.h>
+#include <SampleRing.h>
+
+// One HX711 conversion of both load cells, shifted out on the same SCK pulses.
+// The timestamp is taken when the pair became available (the DOUT falling-edge
+// ISR, or the moment sensor2 caught up if it was later).
+struct RawSample {
+    int64_t timestampUs;
+    long raw1;
+    long raw2;
+};
+
+#define ACQUISITION_RING_SIZE 64 // must be a power of two (~6 s at 10 SPS, ~0.8 s at 80 SPS)
+// SCK pulses after the 24 data bits: 1 = channel A gain 128 (HX711 default),
+// 2 = channel B gain 32, 3 = channel A gain 64
+#define HX711_GAIN_PULSES 1
+
+// Conversions discarded after a rate switch or power-up: the HX711 output
+// needs 4 conversions to settle (400 ms at 10 SPS, 50 ms at 80 SPS)
+#define HX711_SETTLE_CONVERSIONS 4
+
+// Conversion period at each rate; sensor2 may lag sensor1 by up to one
+// period, which also bounds the wait for it
+#define HX711_PERIOD_IDLE_US 100000 // 10 SPS
+#define HX711_PERIOD_FAST_US 12500  // 80 SPS
+
+// HX711 operating modes, switched by the acquisition task
+enum SampleRate : uint8_t {
+    RATE_IDLE,  // 10 SPS (RATE pin low)
+    RATE_FAST,  // 80 SPS (RATE pin high), needs HX711_RATE_PIN
+    RATE_OFF    // powered down (SCK held high)
+};
+
+// Counters exposed for the serial status command
+struct AcquisitionStats {
+    IntervalStats intervals; // samples pushed into the ring, time between them
+    uint32_t dropped;       // samples lost because the consumer fell behind
+    uint32_t missedEdges;   // DOUT edges where the HX711 was no longer ready
+    uint32_t pairTimeouts;  // sensor1 conversions skipped because sensor2 was not ready within a period
+    uint32_t rateSwitches;  // modes applied (including power down/up)
+    uint32_t settling;      // conversions discarded while the output settled
+    SampleRate rate;        // mode in effect
+};
+
+// Starts the DOUT edge interrupt and the acquisition task. Must be called
+// after loadcell/loadcell2 have been initialized with begin().
+void setupAcquisition();
+
+// Consumer side (scale task): pop the next sample, waiting up to timeoutMs.
+bool acquisitionNextSample(RawSample &sample, uint32_t timeoutMs);
+// Drop everything queued so far (e.g. after a tare changed the offsets)
+void acquisitionFlush();
+
+AcquisitionStats acquisitionGetStats();
+
+// Request a mode; the acquisition task applies it before its next read and
+// drops the conversions taken while the output settles. Direct HX711 users
+// (hx711Lock) power the modules up on their own if they are powered down.
+void acquisitionSetRate(SampleRate rate);
+// True while no samples are expected (powered down or settling), so the
+// consumer does not treat the silence as a missing HX711
+bool acquisitionSettling();
+
+// Serializes direct HX711 access (read_average, calibration) with the
+// acquisition task; both modules share the SCK line, so a concurrent clock
+// train would corrupt both readings. Powers the modules up if the
+// acquisition task had powered them down.
+void hx711Lock();
+void hx711Unlock();
+
+struct Hx711Guard {
+    Hx711Guard() { hx711Lock(); }
+    ~Hx711Guard() { hx711Unlock(); }
+};
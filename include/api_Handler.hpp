@@ -1,5 +0,0 @@
-#pragma once
-
-#include <ESPAsyncWebServer.h>
-
-void setupApiEndpoints(AsyncWebServer& server);
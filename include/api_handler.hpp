@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+
+// REST API (JSON), next to the WiFi configuration page (POST /updateSettings):
+//   GET        /api/v1/state     status, weight, stability, cup, target,
+//                                settled weight of the last grind, ...
+//   GET        /api/v1/settings  {"settings":{<key>:<value>,...},"readOnly":[<key>,...]}
+//   PUT / POST /api/v1/settings  JSON object with some of the settings;
+//                                answers like GET. All keys are checked
+//                                before any is applied.
+//   GET        /api/v1/wifi      provisioning state (wifi_provisioning.hpp):
+//                                {"state","address","ssid","sinceMs",
+//                                "connects","saving","restartInMs"}
+//   PUT / POST /api/v1/wifi      {"ssid":"...","password":"..."}; 202, the
+//                                web task saves them and restarts
+//   POST       /api/v1/restart   202; restarts after WIFI_RESTART_DELAY_MS
+// Settings, WiFi and restart requests are refused while grinding, and a
+// restart that comes due then waits until the grinder is idle.
+// Setting keys are the NVS keys (settings.cpp). Errors answer
+// {"error":"...","key":"..."} with 400 (unknown key, wrong type, out of
+// range), 403 (read-only), 409 (while grinding) or 413 (body too large).
+//
+// Documents are StaticJsonDocument on the handler's stack and serialize
+// into a stack buffer, so a GET allocates nothing beyond AsyncWebServer's
+// own response (measured per request, ApiStats). An update holds its body in
+// the request until it is parsed; only one document is on the stack at a time.
+
+#define API_JSON_CAPACITY 1024 // ArduinoJson pool per document
+#define API_BODY_MAX 1024      // largest response and request body
+
+struct ApiStats {
+    uint32_t requests;     // API responses sent
+    uint32_t errors;       // of which 4xx
+    uint32_t overflows;    // responses cut short by API_JSON_CAPACITY or API_BODY_MAX
+    uint32_t largestBody;  // bytes
+    int32_t lastHeapDelta;    // free heap taken by the last send(), bytes
+    int32_t largestHeapDelta;
+};
+
+void setupApiEndpoints(AsyncWebServer& server);
+ApiStats apiStats();
@@ -1,8 +1,8 @@
 #pragma once
 
-#include <SimpleKalmanFilter.h>
 #include "HX711.h"
 #include <MathBuffer.h>
+#include <MultiChannelBuffer.h>
 #include <AiEsp32RotaryEncoder.h>
 #include <Preferences.h>
 #include <SPI.h>
@@ -13,7 +13,6 @@
 extern Preferences preferences;       // Preferences object
 extern HX711 loadcell;                // HX711 load cell object
 extern HX711 loadcell2;               // Optional second HX711 load cell object
-extern SimpleKalmanFilter kalmanFilter; // Kalman filter for smoothing weight measurements
 
 extern TaskHandle_t ScaleTask;        // Task handle for the scale task
 extern TaskHandle_t ScaleStatusTask;  // Task handle for the scale status task
@@ -28,6 +27,7 @@ extern TaskHandle_t ScaleStatusTask;  // Task handle for the scale status task
 #define STATUS_GRINDING_FAILED 3
 #define STATUS_IN_MENU 4
 #define STATUS_IN_SUBMENU 5
+#define STATUS_RELAY_TEST 6
 #define STATUS_INFO_MENU 8
 
 #define CUP_WEIGHT 70
@@ -41,9 +41,33 @@ extern TaskHandle_t ScaleStatusTask;  // Task handle for the scale status task
 #define LOADCELL2_DOUT_PIN 16 // secondary HX711 DOUT (sensor2) -> use GPIO16
 // Use same SCK pin for both HX711 modules (shared clock)
 #define LOADCELL2_SCK_PIN LOADCELL_SCK_PIN
+// HX711 RATE input of both modules (low = 10 SPS, high = 80 SPS). Most
+// breakout boards tie RATE to GND; with -1 the scale stays at 10 SPS and
+// only powers the HX711s down while the display sleeps.
+#define HX711_RATE_PIN -1
+// 80 SPS from grind start until the weight has settled after the stop, at
+// most this long, so the end of the grind and the settled weight are sampled
+// finely (see scaleStatusLoop)
+#define SAMPLE_RATE_FAST_HOLD_MS 3000
+
 #define LOADCELL2_SCALE_FACTOR 4362.59 // Default fallback, can be calibrated separately
 
-#define TARE_MEASURES 20 // use the average of measure for taring
+// Tare averages the next samples of the normal stream (see updateScale):
+// done once both cells are stable (STABILITY_TARE) and the standard error of
+// the mean is below TARE_SETTLED_G after at least TARE_MIN_SAMPLES, or after
+// TARE_MEASURES samples regardless
+#define TARE_MEASURES 20
+#define TARE_MIN_SAMPLES 4
+#define TARE_SETTLED_G 0.02
+#define TARE_TIMEOUT_MS 3000 // give up if the stream delivers no samples this long
+// Stability detectors (StabilityDetector.h), in grams: {window ms, min span
+// ms, min samples, min std dev, max std dev, max slope g/s, noise factor}.
+// Fused weight, for cup detection and the settled weight after a grind:
+#define STABILITY_WEIGHT {1000, 800, 5, 0.02f, 0.3f, 0.5f, 3.0f}
+// Each cell near zero, for auto-zero tracking:
+#define STABILITY_AZT {2000, 1500, 8, 0.01f, 0.1f, 0.05f, 3.0f}
+// Each cell during a tare (the whole tare fits in the window):
+#define STABILITY_TARE {3000, 0, TARE_MIN_SAMPLES, 0.05f, 0.5f, 1.0f, 3.0f}
 #define SIGNIFICANT_WEIGHT_CHANGE 5 // 5 grams changes are used to detect a significant change
 #define COFFEE_DOSE_WEIGHT 18
 #define COFFEE_DOSE_OFFSET -2.5
@@ -55,6 +79,43 @@ extern TaskHandle_t ScaleStatusTask;  // Task handle for the scale status task
 #define GRIND_BUTTON_PIN 25
 #define DEFAULT_GRIND_TRIGGER_MODE true  // true = use button, false = cup detection
 #define AUTO_OFFSET_ADJUSTMENT true     // Enable automatic offset adjustment after grinding
+// Predictive stop: cut the relay when weight + flow * latency + in-flight mass
+// reaches the target, and learn latency/mass after each grind (replaces the
+// shotOffset auto-adjustment while enabled)
+#define PREDICTIVE_STOP true
+#define PREDICTOR_DEFAULT_LATENCY_S 0.25f
+#define PREDICTOR_DEFAULT_IN_FLIGHT_G 0.3f
+// Relay characterisation ('X' serial command, see relay_test.hpp): pulse
+// lengths spread the flow at cut-off so latency and in-flight mass separate
+#define RELAY_TEST_PULSES_MS {600, 900, 1200, 1500}
+#define RELAY_TEST_SETTLE_MS 2500
+#define RELAY_TEST_MIN_CUP_G 20
+// Counts to grams in integer milligrams through precomputed reciprocals
+// (CountScale.h) instead of double divides, which the ESP32 does in
+// software. 'B' serial command compares the cycles per sample of both.
+#define WEIGHT_FIXED_POINT true
+// Weight filter pipeline per scale state (spec syntax in WeightFilter.h,
+// 'F' serial command to inspect and change at runtime). Grinding keeps the
+// plain Kalman the predictor model was learned with; idle and finished add
+// a median stage so single HX711 spikes never reach the display or AZT.
+#define FILTER_IDLE "median:5 kalman:0.5,0.01,0.01"
+#define FILTER_GRINDING "kalman:0.5,0.01,0.01"
+#define FILTER_FINISHED "median:5 kalman:0.5,0.01,0.01"
+// Record every grind (raw counts, fused weight, state) to LittleFS, see grind_trace.hpp
+#define GRIND_TRACE_ENABLED true
+// WiFi (stored network, or the configuration AP) and the web server. Off by
+// default: the radio shares core 0 with the UI and display.
+#define WEB_SERVER_ENABLED false
+// Period of the web task: weight stream batches and event pushes
+#define WEB_TASK_INTERVAL_MS 25 // at most 40 stream messages/s per client
+// Live weight WebSocket, see weight_stream.hpp
+#define WEB_STREAM_PATH "/ws/weight"
+#define WEB_STREAM_MAX_CLIENTS 4
+// Grind lifecycle Server-Sent Events, see grind_events.hpp
+#define WEB_EVENTS_PATH "/events"
+// WiFi provisioning, see wifi_provisioning.hpp
+#define WIFI_CONNECT_TIMEOUT_MS 10000 // then the configuration AP
+#define WIFI_RESTART_DELAY_MS 1000    // lets the response reach the client first
 
 #define TARE_MIN_INTERVAL 10 * 1000 // auto-tare at most once every 10 seconds
 
@@ -63,10 +124,52 @@ extern TaskHandle_t ScaleStatusTask;  // Task handle for the scale status task
 #define ROTARY_ENCODER_BUTTON_PIN 27
 #define ROTARY_ENCODER_VCC_PIN -1
 #define ROTARY_ENCODER_STEPS 4
+#define UI_POLL_MS 20 // rotary/button polling period of the UI task
+
+// Task topology
+//
+// Core 1 runs the weighing path, highest priority first, so the grind-stop
+// decision is never waiting behind UI work:
+//   Acquisition (5)  HX711 clock-out, woken by the DOUT interrupt
+//   Scale       (4)  filtering, per-sample stop decision, trace recording
+//   ScaleStatus (3)  status state machine (grind start, finish, timeouts)
+//   Arduino loop(1)  serial commands, settings/trace flushes
+// Core 0 runs everything that talks to slow buses or is purely cosmetic:
+//   UI (2) rotary encoder and menus, Display (1) I2C OLED, Log (1) UART
+//   drain, plus WiFi/web when enabled: Web (1) weight stream and events.
+// Stack sizes are in bytes; check them with the 'P' serial command.
+#define TASK_ACQUISITION_CORE 1
+#define TASK_ACQUISITION_PRIORITY 5
+#define TASK_ACQUISITION_STACK 4096
+#define TASK_SCALE_CORE 1
+#define TASK_SCALE_PRIORITY 4
+#define TASK_SCALE_STACK 20000
+#define TASK_STATUS_CORE 1
+#define TASK_STATUS_PRIORITY 3
+#define TASK_STATUS_STACK 20000
+#define TASK_UI_CORE 0
+#define TASK_UI_PRIORITY 2
+#define TASK_UI_STACK 8192
+#define TASK_DISPLAY_CORE 0
+#define TASK_DISPLAY_PRIORITY 1
+#define TASK_DISPLAY_STACK 10000
+#define TASK_LOG_CORE 0
+#define TASK_LOG_PRIORITY 1
+#define TASK_LOG_STACK 3072
+#define TASK_WEB_CORE 0
+#define TASK_WEB_PRIORITY 1
+#define TASK_WEB_STACK 4096
+// Sample age (DOUT edge to processed by the scale task) counted as late
+#define TASK_LATENCY_BUDGET_US 20000
 
 // Screen 
 #define OLED_SDA 21
 #define OLED_SCL 22
+#define DISPLAY_MAX_FPS 20 // frame-rate cap for the display task
+#define DISPLAY_MAX_AGE_MS 1000UL // redraw at least this often without notifications
+#define DISPLAY_QUEUE_LENGTH 8
+#define DISPLAY_WEIGHT_STEP_G 0.1 // weight change that triggers a redraw
+#define INFO_MENU_SHOW_MS 3000UL
 
 // External User Variables
 extern volatile bool displayLock; // Add this declaration
@@ -5,6 +5,23 @@ void showErrorMessage(const char* message);
 #include <SPI.h>
 #include <U8g2lib.h>
 
+struct DisplayStats {
+    uint32_t frames;          // frames presented
+    uint32_t unchangedFrames; // frames where no tile differed
+    uint32_t tilesSent;       // 8x8 tiles pushed over I2C
+    uint32_t bytesPerSecond;  // tile bytes sent over the last second
+    uint32_t eventWakeups;    // redraws triggered by displayNotify()
+    uint32_t deadlineWakeups; // redraws triggered by the max-age deadline
+    uint32_t coalescedEvents; // notifications dropped because a redraw was already queued
+};
+
+// What changed; the display task redraws the current screen either way
+enum DisplayEvent : uint8_t {
+    DISPLAY_WEIGHT, // weight moved by at least DISPLAY_WEIGHT_STEP_G
+    DISPLAY_STATE,  // scaleStatus changed, drawn without waiting for the frame cap
+    DISPLAY_MENU,   // encoder or button input
+};
+
 void setupDisplay();
 void showCupWeightSetScreen(double cupWeight);
 void showInfoMenu();
@@ -13,4 +30,6 @@ void showConfigMenu();
 void wakeScreen();
 void showIpAddress();
 void showTaringMessage();
-void showModeChangeMessage(const char* mode, const char* status);
\ No newline at end of file
+void showModeChangeMessage(const char* mode, const char* status);
+void displayNotify(DisplayEvent event);
+DisplayStats displayGetStats();
\ No newline at end of file
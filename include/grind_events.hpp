@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// Grind lifecycle events as Server-Sent Events (WEB_EVENTS_PATH)
+//
+// The status loop publishes an event at grind start, stop, failure and once
+// the weight has settled. Each gets the next id and goes into a small RAM
+// log; the web task pushes new ones to the connected clients. A client that
+// reconnects with Last-Event-ID (browsers send it on their own) is replayed
+// the logged events after that id, so a shot logger catches up without
+// polling. If the log no longer holds all it missed, a "gap" event (no id)
+// says how many were lost. An id is a random per-boot epoch (bits 20-30)
+// above a sequence number that restarts at 1 after a reboot: a Last-Event-ID
+// from another boot replays the whole log. New clients get no replay.
+//
+// Event data is JSON; weights in grams without the cup, times in ms:
+//   grind_start    {"grind":3,"target":18.00,"cup":70.12,"trigger":"button","mode":"weight"}
+//   grind_stop     {"grind":3,"weight":17.62,"flow":1.85,"predicted":18.01,"by":"prediction","ms":8123}
+//   grind_failed   {"grind":3,"reason":"no_flow","text":"No weight increase","weight":0.12,"ms":5003}
+//   grind_settled  {"grind":3,"weight":18.05,"target":18.00,"error":0.05,"settleMs":1400}
+//   gap            {"missed":4}
+// trigger is "button" or "cup", mode "weight" or "scale" (scale only), by
+// "prediction" or "threshold"; reason is GrindSession::failureKey(). Every
+// event is also logged (Web tag).
+
+#define GRIND_EVENT_LOG 16   // events kept for replay
+#define GRIND_EVENT_DATA 160 // bytes of JSON per event
+
+enum GrindEventType : uint8_t { GRIND_EVENT_START, GRIND_EVENT_STOP, GRIND_EVENT_FAILED, GRIND_EVENT_SETTLED };
+
+// Registers the endpoint
+void setupGrindEvents(AsyncWebServer &server);
+// Web task: push events published since the last call
+void grindEventsService();
+// Status loop: log an event with printf-style JSON data; never waits for the
+// network
+void grindEventPublish(GrindEventType type, const char *format, ...) __attribute__((format(printf, 2, 3)));
+// Events published since boot (last id)
+uint32_t grindEventsPublished();
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+#include <GrindTrace.h>
+
+// Grind trace recorder
+//
+// Every sample from the start of a grind until the scale leaves the
+// finished/failed state is encoded into a RAM buffer (GrindTrace format) and
+// written to LittleFS as one file per shot once the grind is over. Files
+// form a ring of TRACE_SLOTS; the oldest shot is overwritten.
+
+#define TRACE_SLOTS 64            // shots kept in flash
+#define TRACE_BUFFER_BYTES 16384  // per shot, ~2000 samples (~25 s at 80 SPS)
+#define TRACE_DIR "/traces"
+
+// Mounts LittleFS and finds the newest stored shot
+void setupGrindTrace();
+// Called by the scale task for every acquired sample
+void grindTraceSample(uint32_t timeMs, long raw1, long raw2, double fusedGrams, int state);
+// Writes a finished trace to flash; call from a low-priority context (loop())
+void grindTraceService();
+// Prints all stored traces as hex lines for tools/decode_traces.py
+void grindTraceDump(Stream &out);
+// Reads the stored trace with the given age (0 = newest) into buffer;
+// returns its size or 0 if there is none
+size_t grindTraceLoad(uint8_t age, uint8_t *buffer, size_t capacity);
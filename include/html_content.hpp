@@ -1,5 +0,0 @@
-#pragma once
-
-#include <string>
-
-extern const std::string html_page;
\ No newline at end of file
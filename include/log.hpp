@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Non-blocking serial log
+//
+// A log call formats the message into a stack buffer and copies it into a
+// RAM ring; a low-priority task drains the ring to the UART. The calling
+// task never waits for the UART, so logging from the scale task costs a few
+// microseconds. When the ring is full new messages are dropped and counted.
+//
+// Every message has a tag and a level. Messages above the tag's level are
+// rejected before formatting, and each tag can be limited to a number of
+// messages per second (token bucket); suppressed messages are reported with
+// the next one that gets through. Both are adjustable at runtime with the
+// 'L' serial command.
+
+enum LogLevel : uint8_t { LOG_NONE, LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG };
+
+enum LogTag : uint8_t {
+    TAG_SCALE,     // status loop, grind start/finish
+    TAG_HX711,     // per-sample raw readings
+    TAG_TARE,
+    TAG_AZT,
+    TAG_PREDICTOR,
+    TAG_TRACE,
+    TAG_UI,        // rotary encoder and menus
+    TAG_SYSTEM,
+    TAG_WEB,       // WiFi, web server and streams
+    TAG_COUNT
+};
+
+#define LOG_RING_BYTES 4096
+#define LOG_LINE_MAX 192 // longer messages are truncated
+
+struct LogStats {
+    uint32_t written;      // messages queued
+    uint32_t droppedFull;  // lost because the ring was full
+    uint32_t suppressed;   // rejected by the rate limits
+    uint32_t bytes;        // bytes sent to the UART
+    uint16_t highWater;    // most bytes ever queued
+};
+
+void setupLog();
+
+// Level check without formatting, used by the macros below
+bool logEnabled(LogTag tag, LogLevel level);
+void logWrite(LogTag tag, LogLevel level, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+void logSetLevel(LogTag tag, LogLevel level);
+void logSetRate(LogTag tag, uint16_t perSecond); // 0 = unlimited
+LogStats logGetStats();
+
+// Serial CLI: "L" status, "L <tag|all> <none|error|warn|info|debug>",
+// "L <tag|all> rate <n>"
+void logCommand(const String &args, Stream &out);
+
+#define LOG_AT(tag, level, ...) do { if (logEnabled(tag, level)) logWrite(tag, level, __VA_ARGS__); } while (0)
+#define LOGE(tag, ...) LOG_AT(tag, LOG_ERROR, __VA_ARGS__)
+#define LOGW(tag, ...) LOG_AT(tag, LOG_WARN, __VA_ARGS__)
+#define LOGI(tag, ...) LOG_AT(tag, LOG_INFO, __VA_ARGS__)
+#define LOGD(tag, ...) LOG_AT(tag, LOG_DEBUG, __VA_ARGS__)
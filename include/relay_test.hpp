@@ -0,0 +1,16 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Relay characterisation ('X' serial command)
+//
+// With an empty cup on the scale, runs RELAY_TEST_PULSES_MS grind pulses,
+// records the weight response of each from the scale task and fits the
+// relay/motor stop latency and the in-flight mass (RelayCharacterizer). A
+// valid fit replaces the predictor model, so the stop threshold uses it
+// from the next grind on, and is persisted with the other settings.
+// Blocks the calling task for the duration of the test (~15 s).
+void runRelayTest(Stream &out);
+
+// Called by the scale task for every sample (fused grams)
+void relayTestSample(uint32_t timestampMs, float grams);
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Replays a stored grind trace (0 = newest) through the grind logic with a
+// virtual clock and a relay that is never driven, using a copy of the
+// current predictor model, and prints stop time and weight compared with
+// the recorded grind.
+void replayStoredTrace(uint8_t age, Stream &out);
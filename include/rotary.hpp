@@ -4,6 +4,8 @@
 
 void rotary_onButtonClick();
 void rotary_loop();
+// Runs rotary_loop() every UI_POLL_MS in its own task
+void setupRotaryTask();
 void readEncoderISR();
 void exitToMenu();
 
@@ -1,8 +1,47 @@
 #pragma once
 
+#include <MultiChannelBuffer.h>
+#include <GrindPredictor.h>
+#include <GrindSession.h>
+#include <StabilityDetector.h>
+
+// Channels of the scale history; one row per acquired sample
+enum HistoryChannel {
+    HISTORY_RAW1,     // sensor1 raw counts (float holds 24-bit counts exactly)
+    HISTORY_RAW2,     // sensor2 raw counts
+    HISTORY_FUSED,    // combined grams before filtering
+    HISTORY_ESTIMATE, // filtered grams (what scaleWeight shows)
+    HISTORY_CHANNELS
+};
+typedef MultiChannelBuffer<float, 100, HISTORY_CHANNELS, 8> ScaleHistory;
+extern ScaleHistory weightHistory;
+extern GrindPredictor grindPredictor;
+extern GrindSession grindSession;
+
+// True while the relay may be on: a grind or the relay test is running, or
+// the grinder was switched on outside a session (manual grind, auto-vibe)
+bool grinderBusy();
+// Copy of the predictor taken under the session lock (for replays)
+GrindPredictor grindPredictorSnapshot();
+// Replace the predictor model under the session lock and mark it for saving
+void grindPredictorSetModel(float latencyS, float inFlightG);
+
 //Methods
 void setupScale();
+// Starts a tare; the scale task averages the following samples while
+// acquisition continues. Never blocks; false while grinding, when a new zero
+// would eat into the dose. A tare already running is restarted.
 bool tareScale();
+// True from tareScale() until the new zero is applied or the tare failed
+bool tareInProgress();
+// Waits for the tare requested last (an older one finishing does not count);
+// true if it succeeded. timeoutMs counts from when the scale task starts the
+// tare, like its own TARE_TIMEOUT_MS, not from the request (0 polls the result)
+bool tareWait(uint32_t timeoutMs);
+// Stability of the fused weight as of the last sample (scale task)
+StabilityState scaleStability();
+// Weight the scale settled at after the last grind; false until it has
+bool grindSettledWeight(double &grams);
 // Apply shot offset adjustment when the user exits the finished screen.
 // This was previously triggered by a timer; the adjustment now runs when
 // the user presses the button to leave the "Grinding finished" state.
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+#include <GrindSession.h>
+
+// Device implementations of the GrindSession seams
+
+class MillisClock : public GrindClock {
+public:
+    uint32_t nowMs() override { return millis(); }
+};
+
+// Grinder relay on GRINDER_ACTIVE_PIN (active low). Keeps grinderActive in
+// sync so the rest of the firmware sees the real relay state.
+class GpioRelay : public GrindRelay {
+public:
+    void set(bool on) override;
+};
+
+extern MillisClock systemClock;
+extern GpioRelay grinderRelay;
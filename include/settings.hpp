@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Write-coalescing settings store over Preferences ("scale" namespace)
+//
+// Every persisted setting lives in its runtime global as before; the store
+// knows where each global is and keeps a shadow of the value last written
+// to NVS. Code that changes a setting assigns the global and calls
+// settingsTouch(); nothing is written at that point. settingsService()
+// (called from loop()) writes all dirty settings in one NVS session once
+// no setting changed for SETTINGS_QUIET_MS, and skips values that ended up
+// equal to what is already stored (e.g. an encoder turned back and forth).
+// settingsFlush() writes immediately, for calibration results and before
+// the display goes to sleep.
+
+enum SettingKey : uint8_t {
+    SET_CALIBRATION,      // scaleFactor
+    SET_CALIBRATION2,     // scaleFactor2
+    SET_OFFSET1,          // loadcell_offset
+    SET_OFFSET2,          // loadcell2_offset
+    SET_SET_WEIGHT,       // setWeight
+    SET_SHOT_OFFSET,      // shotOffset
+    SET_CUP_WEIGHT,       // setCupWeight
+    SET_SCALE_MODE,       // scaleMode
+    SET_GRIND_MODE,       // grindMode
+    SET_SHOT_COUNT,       // shotCount
+    SET_SLEEP_TIME,       // sleepTime
+    SET_GRIND_TRIGGER,    // useButtonToGrind
+    SET_MANUAL_GRIND,     // manualGrindMode
+    SET_DISPLAY_COMP,     // display_compensation_g
+    SET_AUTO_VIBE,        // auto_vibe_after_grind
+    SET_PRED_LATENCY,     // predictorLatencyS
+    SET_PRED_IN_FLIGHT,   // predictorInFlightG
+    SETTING_COUNT
+};
+
+#define SETTINGS_QUIET_MS 2000 // flush once settings stopped changing for this long
+
+struct SettingsStats {
+    uint32_t touches;     // settingsTouch() calls
+    uint32_t flushes;     // NVS sessions opened
+    uint32_t writes;      // keys actually written
+    uint32_t unchanged;   // dirty keys skipped because NVS already held the value
+};
+
+// Load all settings into their globals (applies defaults and the legacy
+// "offset" -> "shotOffset" migration)
+void settingsLoad();
+// Mark a setting changed after assigning its global
+void settingsTouch(SettingKey key);
+// Restore a setting's default value and mark it changed
+void settingsReset(SettingKey key);
+// Write dirty settings if they have been quiet long enough
+void settingsService();
+// Write dirty settings now
+void settingsFlush();
+
+bool settingsDirty();
+SettingsStats settingsGetStats();
+
+// Access by key for the web API: the NVS key is the name, numbers are
+// passed as double and bools as 0/1
+const char *settingsName(SettingKey key);
+SettingKey settingsFind(const char *name); // SETTING_COUNT if unknown
+bool settingsIsBool(SettingKey key);
+double settingsGet(SettingKey key);
+// Assign the global (converted to its type) and mark it changed
+void settingsSet(SettingKey key, double value);
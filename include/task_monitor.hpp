@@ -0,0 +1,31 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Task monitor
+//
+// Reports, for every task in the topology described in config.hpp, its
+// core, priority and stack high-water mark, and its CPU share since the
+// previous report when FreeRTOS run-time stats are compiled in. It also
+// tracks how old each HX711 sample is when the scale task has processed it
+// (DOUT edge to grind session), which is the number that shows whether the
+// grind-stop path is ever starved.
+
+struct SampleLatencyStats {
+    uint32_t samples;
+    uint32_t late;           // samples older than TASK_LATENCY_BUDGET_US
+    int64_t lastUs;
+    int64_t maxUs;
+    int64_t maxGrindingUs;   // worst case while the grinder was running
+    uint32_t stops;          // stop/failure decisions taken by the scale task
+    int64_t stopLastUs;      // DOUT edge of the deciding sample to relay write
+    int64_t stopMaxUs;
+};
+
+// Called by the scale task once a sample has been fed to the grind session
+void taskMonitorSampleProcessed(int64_t sampleTimestampUs, bool grinding);
+// Called right after the sample at sampleTimestampUs stopped the grinder
+void taskMonitorStopDecision(int64_t sampleTimestampUs);
+SampleLatencyStats taskMonitorGetLatency();
+// Serial CLI 'P': task table and sample latency; resets the CPU window
+void taskMonitorReport(Stream &out);
@@ -0,0 +1,67 @@
+// Generated by tools/embed_web.py from web/; do not edit.
+#pragma once
+
+#include <Arduino.h>
+
+struct WebAsset {
+    const char *url;
+    const char *contentType;
+    const char *etag;        // quoted, as sent in the ETag header
+    const uint8_t *data;     // gzip
+    size_t length;
+};
+
+// index.html: 2034 bytes, 749 gzip'd
+static const uint8_t WEB_INDEX_HTML[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8d, 0x55, 0x5b, 0x6f, 0x9b, 0x30,
+    0x14, 0x7e, 0xef, 0xaf, 0xf0, 0xa8, 0x26, 0xb6, 0xaa, 0x94, 0x90, 0x34, 0x5d, 0x44, 0x21, 0xd2,
+    0xb4, 0xae, 0xd2, 0x9e, 0x5a, 0x29, 0x9d, 0xaa, 0x3d, 0x1e, 0xb0, 0x03, 0x56, 0x8d, 0xcd, 0x6c,
+    0x93, 0xcb, 0xa6, 0xfd, 0xf7, 0xd9, 0x40, 0x2e, 0xd0, 0x24, 0x2d, 0x28, 0xc1, 0xf8, 0xdc, 0xbe,
+    0xf3, 0x9d, 0xe3, 0x43, 0xf4, 0xe1, 0xee, 0xe1, 0xdb, 0xd3, 0xaf, 0xc7, 0xef, 0x28, 0xd7, 0x05,
+    0x9b, 0x9e, 0x45, 0xf6, 0x81, 0x18, 0xf0, 0x2c, 0x76, 0x08, 0x77, 0xec, 0x06, 0x01, 0x3c, 0x3d,
+    0x43, 0xe6, 0x8a, 0x0a, 0xa2, 0x01, 0xa5, 0x39, 0x48, 0x45, 0x74, 0xec, 0xfc, 0x7c, 0xba, 0xf7,
+    0x26, 0xce, 0xbe, 0x88, 0x43, 0x41, 0x62, 0x67, 0x41, 0xc9, 0xb2, 0x14, 0x52, 0x3b, 0x28, 0x15,
+    0x5c, 0x13, 0x6e, 0x54, 0x97, 0x14, 0xeb, 0x3c, 0xc6, 0x64, 0x41, 0x53, 0xe2, 0xd5, 0x2f, 0x97,
+    0x88, 0x72, 0xaa, 0x29, 0x30, 0x4f, 0xa5, 0xc0, 0x48, 0x1c, 0x5c, 0x0d, 0x36, 0xae, 0x34, 0xd5,
+    0x8c, 0x4c, 0x9f, 0xa9, 0x77, 0x4f, 0xd1, 0x37, 0xc1, 0xe7, 0x34, 0xab, 0x24, 0x68, 0x2a, 0x78,
+    0xe4, 0x37, 0xa2, 0x46, 0x4d, 0xe9, 0xf5, 0x66, 0x6d, 0xaf, 0x44, 0xe0, 0x35, 0xfa, 0xbb, 0x7d,
+    0xb5, 0xd7, 0xdc, 0x84, 0xf7, 0xe6, 0x50, 0x50, 0xb6, 0x0e, 0xd1, 0x57, 0x69, 0x82, 0x5d, 0x22,
+    0x05, 0x5c, 0x79, 0x8a, 0x48, 0x3a, 0xbf, 0xed, 0xe8, 0x26, 0x90, 0xbe, 0x64, 0x52, 0x54, 0x1c,
+    0x7b, 0xa9, 0x60, 0x42, 0x86, 0xe8, 0x3c, 0x48, 0xed, 0x7d, 0x8b, 0xfc, 0x0b, 0x74, 0x07, 0xf2,
+    0x05, 0x65, 0x12, 0xd6, 0x7b, 0x7a, 0xe8, 0xc2, 0xef, 0x78, 0x68, 0xcd, 0x96, 0x39, 0xd5, 0xa4,
+    0x36, 0x7a, 0xb6, 0x2b, 0xa4, 0xc9, 0x4a, 0xf7, 0x55, 0xed, 0x9e, 0x07, 0x8c, 0x66, 0x3c, 0x44,
+    0xa9, 0x21, 0x88, 0xc8, 0x2e, 0x98, 0x12, 0x30, 0xa6, 0x3c, 0x0b, 0xd1, 0x70, 0x50, 0xae, 0x76,
+    0xa2, 0x7f, 0xdb, 0xd5, 0x95, 0x65, 0x16, 0x28, 0x27, 0xb2, 0x97, 0xf2, 0x0e, 0x9e, 0x49, 0x60,
+    0x08, 0xf6, 0xae, 0xb1, 0xcc, 0x4c, 0xb0, 0x5c, 0xb3, 0x35, 0xaa, 0x9f, 0xc6, 0xac, 0x4e, 0xa6,
+    0x07, 0xeb, 0x48, 0xd8, 0x86, 0x5d, 0x89, 0x89, 0xf4, 0x24, 0x60, 0x5a, 0xa9, 0x10, 0x4d, 0x5e,
+    0xcb, 0x57, 0x9e, 0xca, 0x01, 0x8b, 0x65, 0x88, 0x8c, 0x71, 0xfd, 0x0b, 0xec, 0x9f, 0xcc, 0x12,
+    0xf8, 0x34, 0x1c, 0x8f, 0x2f, 0x37, 0xbf, 0xc1, 0x55, 0xf0, 0xb9, 0x6b, 0x5b, 0xf7, 0x83, 0xf1,
+    0x39, 0xf8, 0xd8, 0xdd, 0x2f, 0x60, 0xe5, 0xb5, 0xb2, 0xeb, 0xc1, 0x2b, 0x44, 0x05, 0xc8, 0x8c,
+    0x1a, 0xfe, 0xa0, 0xd2, 0xe2, 0x10, 0x45, 0x79, 0xd0, 0xa3, 0xa6, 0x53, 0x9f, 0x03, 0x06, 0x0c,
+    0x12, 0xc2, 0x0e, 0x75, 0x90, 0xa2, 0x7f, 0x48, 0x88, 0x82, 0x9b, 0x3e, 0x02, 0x4c, 0x55, 0xc9,
+    0xc0, 0xb4, 0x56, 0xc2, 0x44, 0xfa, 0x72, 0x7b, 0xb4, 0xc2, 0x8c, 0xcc, 0xf5, 0x61, 0xec, 0x35,
+    0x43, 0x03, 0x34, 0xee, 0x7b, 0x7e, 0x0b, 0x2a, 0xe5, 0x65, 0xa5, 0x7b, 0x50, 0x5b, 0xa6, 0x82,
+    0x41, 0x9f, 0xc6, 0x6d, 0x55, 0x83, 0x23, 0x1c, 0x7a, 0x89, 0xd0, 0x5a, 0x14, 0x46, 0x61, 0x7c,
+    0xb8, 0xec, 0x46, 0x62, 0x70, 0x2a, 0xc1, 0x28, 0x46, 0xe7, 0x37, 0x37, 0x37, 0x27, 0x5b, 0xe3,
+    0xb5, 0x8f, 0xfd, 0x96, 0x1c, 0x8d, 0x46, 0xdb, 0x03, 0x65, 0xba, 0xb0, 0x49, 0x64, 0x4e, 0x09,
+    0x3b, 0x7d, 0x9c, 0x0e, 0x70, 0x90, 0x54, 0x06, 0x34, 0x3f, 0xda, 0xfe, 0xdb, 0x53, 0x3c, 0x9c,
+    0xc0, 0x97, 0xeb, 0xf1, 0x7b, 0xf8, 0xdd, 0x4f, 0x98, 0x0b, 0x4e, 0xde, 0x4d, 0xe3, 0x51, 0xea,
+    0xdf, 0xa2, 0xe6, 0x64, 0x7b, 0xa5, 0x95, 0x54, 0x16, 0x65, 0x29, 0x68, 0x77, 0x42, 0xf4, 0x39,
+    0x08, 0x73, 0xb1, 0x38, 0x31, 0x08, 0x76, 0x4c, 0x04, 0x93, 0xc9, 0x68, 0xd2, 0xf7, 0x13, 0xf9,
+    0xed, 0x20, 0x8d, 0xfc, 0x66, 0xd2, 0x47, 0x76, 0x92, 0xb6, 0x33, 0x16, 0xd3, 0x05, 0x4a, 0x19,
+    0x28, 0x15, 0x3b, 0xdb, 0x89, 0xe3, 0xec, 0x66, 0x6e, 0x94, 0x07, 0x87, 0xe7, 0xb4, 0xd9, 0xdf,
+    0x29, 0xcd, 0x85, 0x2c, 0x90, 0xf9, 0x3e, 0xe4, 0x02, 0xc7, 0xee, 0xe3, 0xc3, 0xec, 0xc9, 0x45,
+    0x90, 0x5a, 0xbd, 0xd8, 0xf5, 0xab, 0x12, 0x83, 0x26, 0x33, 0xa2, 0xb5, 0xe1, 0x56, 0xb9, 0xd3,
+    0x4e, 0x0e, 0x51, 0x73, 0x24, 0x8d, 0x7d, 0xec, 0x28, 0x45, 0xb1, 0xd3, 0x06, 0x9b, 0xcd, 0x7e,
+    0xdc, 0x85, 0x91, 0x5f, 0x4b, 0x7b, 0x16, 0x4d, 0x43, 0xe9, 0x75, 0x49, 0x62, 0xd7, 0x9e, 0x41,
+    0x17, 0x51, 0xdc, 0x1a, 0x37, 0x5f, 0x27, 0xd7, 0xae, 0x5d, 0x24, 0xc9, 0xef, 0x8a, 0x4a, 0x62,
+    0xd2, 0x3d, 0x1a, 0xb1, 0x34, 0x69, 0x2f, 0x4d, 0x01, 0x37, 0x51, 0x1f, 0xdb, 0xf7, 0x77, 0x44,
+    0xde, 0x98, 0x36, 0xd1, 0xb7, 0x8e, 0x5a, 0x04, 0x3b, 0xe9, 0x31, 0x14, 0x6d, 0x6f, 0x37, 0xce,
+    0x54, 0x95, 0x14, 0x54, 0xbb, 0xd3, 0x19, 0x2c, 0x08, 0x6a, 0x09, 0x68, 0xf9, 0x8a, 0xfc, 0x46,
+    0x73, 0x8f, 0x6c, 0xdf, 0xb2, 0xdd, 0x56, 0xcf, 0x37, 0xe5, 0xb3, 0x75, 0x6d, 0x0a, 0x6a, 0xaa,
+    0x52, 0x7f, 0xe1, 0xff, 0x03, 0x8e, 0x0f, 0xa3, 0xdf, 0xf2, 0x07, 0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+    {"/", "text/html", "\"3b8c0cbe330d7911\"", WEB_INDEX_HTML, sizeof(WEB_INDEX_HTML)},
+};
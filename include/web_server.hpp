@@ -1,5 +1,10 @@
 #pragma once
 #include <ESPAsyncWebServer.h>
 
-// Function to initialize the web server
+// Starts connecting WiFi without waiting (wifi_provisioning.hpp), the web
+// server with the UI, the API endpoints, the weight stream and the grind
+// events, and the web task that services them (WEB_SERVER_ENABLED)
 void setupWebServer();
+// Serial CLI 'W': WiFi state, address, weight stream, grind event and API
+// statistics
+void webServerReport(Stream &out);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Weight filter stage of the scale task
+//
+// The fused weight of every sample runs through a FilterPipeline (see
+// WeightFilter.h) chosen by the scale state: FILTER_GRINDING while a grind
+// is running, FILTER_FINISHED after it stopped or failed, FILTER_IDLE
+// otherwise. On a profile switch the new pipeline starts at the last output,
+// so the displayed weight does not jump. Profiles can be changed at runtime
+// with the 'F' serial command; they are not persisted, the defaults live in
+// config.hpp.
+
+enum FilterProfile : uint8_t {
+    FILTER_PROFILE_IDLE,
+    FILTER_PROFILE_GRINDING,
+    FILTER_PROFILE_FINISHED,
+    FILTER_PROFILE_COUNT
+};
+
+void weightFilterSetup();
+// Scale task: filter one fused sample for the given scaleStatus
+float weightFilterUpdate(uint32_t timestampMs, float fusedG, int status);
+// Restart the active pipeline at value (after a tare)
+void weightFilterReset(double value);
+// Replace a profile; false if the spec does not parse
+bool weightFilterSetProfile(FilterProfile profile, const char *spec);
+// Copy of a profile as configured, for offline use (trace replay)
+bool weightFilterGetProfile(FilterProfile profile, char *spec, size_t size);
+// Serial CLI 'F': "F" prints profiles and per-stage metrics,
+// "F <idle|grinding|finished> <spec>" replaces a profile
+void weightFilterCommand(const String &args, Stream &out);
+// Serial CLI 'B': CPU cycles per sample of the double and the fixed-point
+// counts-to-grams path (WEIGHT_FIXED_POINT) and of the active filter
+// profile, on synthetic counts around the current offsets
+void weightPathBenchmark(Stream &out);
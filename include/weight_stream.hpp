@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// Live weight over WebSocket (WEB_STREAM_PATH)
+//
+// The scale task hands every fused sample to a lock-free ring and returns;
+// it never touches the network. The web task drains the ring every
+// WEB_TASK_INTERVAL_MS and sends the batch to each connected client as one
+// binary message. A client whose send queue is full is skipped and the
+// samples it missed are counted in its next message, so a slow dashboard
+// gets fewer, fresher updates instead of slowing anything down.
+//
+// Message layout, little-endian:
+//   u8  version (WEB_STREAM_VERSION)
+//   u8  sample count n
+//   u16 samples dropped for this client since its previous message
+//   n x 10 bytes:
+//     u32 timestamp (ms since boot)
+//     i32 fused weight (mg)
+//     u8  scaleStatus (STATUS_* in config.hpp)
+//     u8  flags, bit 0 = weight stable (scaleStability())
+//
+// tools/ws_load_test.py decodes the stream and loads it with many clients.
+
+#define WEB_STREAM_VERSION 1
+#define WEB_STREAM_RING 256       // ~3 s at 80 SPS between two batches at worst
+#define WEB_STREAM_MAX_BATCH 32   // newest samples per message; older ones count as dropped
+
+struct WeightStreamStats {
+    uint32_t clients;
+    uint32_t messages;     // messages queued to clients
+    uint32_t samples;      // samples taken from the scale task
+    uint32_t coalesced;    // samples skipped for clients with a full queue
+    uint32_t ringDropped;  // samples lost because the web task fell behind
+};
+
+// Registers the endpoint
+void setupWeightStream(AsyncWebServer &server);
+// Web task: send what the scale task queued since the last call
+void weightStreamService();
+// Scale task: one fused sample; returns at once when nobody is connected
+void weightStreamSample(uint32_t timestampMs, float fusedG, int status, bool stable);
+WeightStreamStats weightStreamStats();
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// WiFi connection and provisioning state machine
+//
+// Nothing here waits. provisioningBegin() starts connecting to the stored
+// network and returns; the web task calls provisioningService(), which
+// follows the attempt and opens the configuration AP if it has not
+// connected within WIFI_CONNECT_TIMEOUT_MS. After a connection was lost the
+// station keeps reconnecting instead. HTTP handlers only queue work:
+// provisioningSetCredentials() hands the new network to the web task, which
+// saves it and restarts; provisioningScheduleRestart() restarts once the
+// delay has passed and pending settings are written. A restart that comes
+// due while grinding or in the relay test waits until that is over (the API
+// answers 409 to restart and WiFi requests while grinding). Progress is
+// reported by provisioningStatus() (GET /api/v1/wifi and serial 'W').
+//
+// Credentials live in the "wifi" namespace as wifi_ssid / wifi_pass; the
+// ssid / password keys the configuration page used to write are read as a
+// fallback and replaced on the next save.
+
+enum ProvisioningState : uint8_t {
+    PROV_OFF,          // provisioningBegin() not called
+    PROV_CONNECTING,   // first attempt on the stored network
+    PROV_CONNECTED,
+    PROV_RECONNECTING, // lost the network after it was connected
+    PROV_AP,           // configuration AP (no or wrong credentials)
+};
+
+struct ProvisioningStatus {
+    ProvisioningState state;
+    uint32_t address;       // IPv4, station or AP
+    char ssid[33];          // stored network ("" if none)
+    uint32_t sinceMs;       // time in this state
+    uint32_t connects;      // connections since boot
+    int32_t restartInMs;    // -1 if no restart is scheduled
+    bool credentialsPending; // saved by the web task next
+};
+
+// Starts connecting (or the AP); returns at once
+void provisioningBegin();
+// Web task: follows the connection, saves credentials, restarts
+void provisioningService();
+// Queues new credentials to be saved, then restarts; false if they are
+// invalid (SSID 1-32 characters, password empty or 8-63)
+bool provisioningSetCredentials(const char *ssid, const char *password);
+void provisioningScheduleRestart(uint32_t delayMs);
+ProvisioningStatus provisioningStatus();
+const char *provisioningStateName(ProvisioningState state);
+IPAddress provisioningAddress();
@@ -0,0 +1,36 @@
+#include "DualHx711.h"
+#include <math.h>
+
+IntervalStats::IntervalStats() {
+  clear();
+}
+
+void IntervalStats::clear() {
+  sampleCount = 0;
+  intervalCount = 0;
+  previousUs = 0;
+  lastIntervalUs = 0;
+  minIntervalUs = INT64_MAX;
+  maxIntervalUs = 0;
+  mean = 0;
+  m2 = 0;
+}
+
+void IntervalStats::record(int64_t timestampUs) {
+  sampleCount++;
+  if (previousUs != 0) {
+    int64_t interval = timestampUs - previousUs;
+    lastIntervalUs = interval;
+    if (interval < minIntervalUs) minIntervalUs = interval;
+    if (interval > maxIntervalUs) maxIntervalUs = interval;
+    intervalCount++;
+    double delta = interval - mean;
+    mean += delta / intervalCount;
+    m2 += delta * (interval - mean);
+  }
+  previousUs = timestampUs;
+}
+
+double IntervalStats::jitterUs() const {
+  return intervalCount > 1 ? sqrt(m2 / (intervalCount - 1)) : 0;
+}
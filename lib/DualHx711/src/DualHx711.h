@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Two HX711 modules sharing one SCK line, read in a single clock train.
+//
+// On every rising edge both DOUT lines present their next bit, so one read
+// of the input register per bit yields both 24-bit words at the same time.
+// The pins are reached through a Bus:
+//
+//     struct Bus {
+//         void sck(bool high);      // drive the shared SCK line
+//         void pause();             // >= 0.2 us (the HX711's minimum SCK phase)
+//         uint32_t inputs();        // GPIO input register
+//     };
+//
+// The device implements it with digitalWrite / REG_READ (acquisition.cpp);
+// the host tests with a model of the modules, so the same code is measured
+// there. The caller keeps the train short: SCK high for more than 60 us
+// powers the modules down.
+//
+// Plain C++ without Arduino dependencies.
+
+// 24-bit two's complement conversion as a signed count
+static inline int32_t hx711SignExtend(uint32_t word) {
+	if (word & 0x800000) word |= 0xFF000000;
+	return (int32_t)word;
+}
+
+// Shift both words out MSB first; gainPulses extra pulses select channel and
+// gain of the next conversion (1 = A/128, 2 = B/32, 3 = A/64)
+template<typename Bus>
+void hx711ShiftOutDual(Bus &bus, uint32_t mask1, uint32_t mask2, int gainPulses, uint32_t &word1, uint32_t &word2) {
+	word1 = 0;
+	word2 = 0;
+	for (int i = 0; i < 24; ++i) {
+		bus.sck(true);
+		bus.pause();
+		uint32_t in = bus.inputs();
+		word1 = (word1 << 1) | ((in & mask1) ? 1 : 0);
+		word2 = (word2 << 1) | ((in & mask2) ? 1 : 0);
+		bus.sck(false);
+		bus.pause();
+	}
+	for (int i = 0; i < gainPulses; ++i) {
+		bus.sck(true);
+		bus.pause();
+		bus.sck(false);
+		bus.pause();
+	}
+}
+
+// Sample count and the distribution of the intervals between samples, in
+// microseconds. The mean and standard deviation (the jitter) use Welford's
+// update, so long runs do not lose precision.
+class IntervalStats {
+public:
+	IntervalStats();
+
+	void record(int64_t timestampUs);
+	// The next sample starts a new run (e.g. after a rate switch), so the gap
+	// to it is not counted as an interval
+	void restart() { previousUs = 0; }
+	void clear();
+
+	uint32_t samples() const { return sampleCount; }
+	uint32_t intervals() const { return intervalCount; }
+	int64_t lastUs() const { return lastIntervalUs; }
+	int64_t minUs() const { return minIntervalUs; }
+	int64_t maxUs() const { return maxIntervalUs; }
+	double meanUs() const { return mean; }
+	double jitterUs() const;
+
+private:
+	uint32_t sampleCount;
+	uint32_t intervalCount;
+	int64_t previousUs;
+	int64_t lastIntervalUs;
+	int64_t minIntervalUs;
+	int64_t maxIntervalUs;
+	double mean;
+	double m2;
+};
@@ -167,11 +167,13 @@ AsyncEventSourceClient::AsyncEventSourceClient(AsyncWebServerRequest *request, A
     
   _client->setRxTimeout(0);
   _client->onError(NULL, NULL);
-  _client->onAck([](void *r, AsyncClient* c, size_t len, uint32_t time){ (void)c; ((AsyncEventSourceClient*)(r))->_onAck(len, time); }, this);
-  _client->onPoll([](void *r, AsyncClient* c){ (void)c; ((AsyncEventSourceClient*)(r))->_onPoll(); }, this);
+  // Every callback runs under the server's clients lock: they change the
+  // client list and the queues that other tasks read through the server
+  _client->onAck([](void *r, AsyncClient* c, size_t len, uint32_t time){ (void)c; AsyncEventSourceClient *client = (AsyncEventSourceClient*)(r); AsyncWebLockGuard l(client->_server->clientsLock()); client->_onAck(len, time); }, this);
+  _client->onPoll([](void *r, AsyncClient* c){ (void)c; AsyncEventSourceClient *client = (AsyncEventSourceClient*)(r); AsyncWebLockGuard l(client->_server->clientsLock()); client->_onPoll(); }, this);
   _client->onData(NULL, NULL);
-  _client->onTimeout([this](void *r, AsyncClient* c __attribute__((unused)), uint32_t time){ ((AsyncEventSourceClient*)(r))->_onTimeout(time); }, this);
-  _client->onDisconnect([this](void *r, AsyncClient* c){ ((AsyncEventSourceClient*)(r))->_onDisconnect(); delete c; }, this);
+  _client->onTimeout([this](void *r, AsyncClient* c __attribute__((unused)), uint32_t time){ AsyncEventSourceClient *client = (AsyncEventSourceClient*)(r); AsyncWebLockGuard l(client->_server->clientsLock()); client->_onTimeout(time); }, this);
+  _client->onDisconnect([this](void *r, AsyncClient* c){ AsyncEventSourceClient *client = (AsyncEventSourceClient*)(r); AsyncWebLockGuard l(client->_server->clientsLock()); client->_onDisconnect(); delete c; }, this);
 
   _server->_addClient(this);
   delete request;
@@ -366,6 +368,7 @@ void AsyncEventSourceResponse::_respond(AsyncWebServerRequest *request){
 
 size_t AsyncEventSourceResponse::_ack(AsyncWebServerRequest *request, size_t len, uint32_t time __attribute__((unused))){
   if(len){
+    AsyncWebLockGuard l(_server->clientsLock());
     new AsyncEventSourceClient(request, _server);
   }
   return 0;
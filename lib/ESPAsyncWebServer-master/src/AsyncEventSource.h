@@ -100,6 +100,7 @@ class AsyncEventSource: public AsyncWebHandler {
     String _url;
     LinkedList<AsyncEventSourceClient *> _clients;
     ArEventHandlerFunction _connectcb;
+    AsyncWebLock _lock;
   public:
     AsyncEventSource(const String& url);
     ~AsyncEventSource();
@@ -110,6 +111,9 @@ class AsyncEventSource: public AsyncWebHandler {
     void send(const char *message, const char *event=NULL, uint32_t id=0, uint32_t reconnect=0);
     size_t count() const; //number clinets connected
     size_t  avgPacketsWaiting() const;
+    // Held by the AsyncTCP callbacks while they add, remove or run clients;
+    // hold it (AsyncWebLockGuard) to use the clients from another task
+    AsyncWebLock & clientsLock(){ return _lock; }
 
     //system callbacks (do not call)
     void _addClient(AsyncEventSourceClient * client);
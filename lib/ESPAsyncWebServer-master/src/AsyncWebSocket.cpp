@@ -481,12 +481,14 @@ AsyncWebSocketClient::AsyncWebSocketClient(AsyncWebServerRequest *request, Async
   _lastMessageTime = millis();
   _keepAlivePeriod = 0;
   _client->setRxTimeout(0);
-  _client->onError([](void *r, AsyncClient* c, int8_t error){ (void)c; ((AsyncWebSocketClient*)(r))->_onError(error); }, this);
-  _client->onAck([](void *r, AsyncClient* c, size_t len, uint32_t time){ (void)c; ((AsyncWebSocketClient*)(r))->_onAck(len, time); }, this);
-  _client->onDisconnect([](void *r, AsyncClient* c){ ((AsyncWebSocketClient*)(r))->_onDisconnect(); delete c; }, this);
-  _client->onTimeout([](void *r, AsyncClient* c, uint32_t time){ (void)c; ((AsyncWebSocketClient*)(r))->_onTimeout(time); }, this);
-  _client->onData([](void *r, AsyncClient* c, void *buf, size_t len){ (void)c; ((AsyncWebSocketClient*)(r))->_onData(buf, len); }, this);
-  _client->onPoll([](void *r, AsyncClient* c){ (void)c; ((AsyncWebSocketClient*)(r))->_onPoll(); }, this);
+  // Every callback runs under the server's clients lock: they change the
+  // client list and the queues that other tasks read through the server
+  _client->onError([](void *r, AsyncClient* c, int8_t error){ (void)c; AsyncWebSocketClient *client = (AsyncWebSocketClient*)(r); AsyncWebLockGuard l(client->_server->clientsLock()); client->_onError(error); }, this);
+  _client->onAck([](void *r, AsyncClient* c, size_t len, uint32_t time){ (void)c; AsyncWebSocketClient *client = (AsyncWebSocketClient*)(r); AsyncWebLockGuard l(client->_server->clientsLock()); client->_onAck(len, time); }, this);
+  _client->onDisconnect([](void *r, AsyncClient* c){ AsyncWebSocketClient *client = (AsyncWebSocketClient*)(r); AsyncWebLockGuard l(client->_server->clientsLock()); client->_onDisconnect(); delete c; }, this);
+  _client->onTimeout([](void *r, AsyncClient* c, uint32_t time){ (void)c; AsyncWebSocketClient *client = (AsyncWebSocketClient*)(r); AsyncWebLockGuard l(client->_server->clientsLock()); client->_onTimeout(time); }, this);
+  _client->onData([](void *r, AsyncClient* c, void *buf, size_t len){ (void)c; AsyncWebSocketClient *client = (AsyncWebSocketClient*)(r); AsyncWebLockGuard l(client->_server->clientsLock()); client->_onData(buf, len); }, this);
+  _client->onPoll([](void *r, AsyncClient* c){ (void)c; AsyncWebSocketClient *client = (AsyncWebSocketClient*)(r); AsyncWebLockGuard l(client->_server->clientsLock()); client->_onPoll(); }, this);
   _server->_addClient(this);
   _server->_handleEvent(this, WS_EVT_CONNECT, request, NULL, 0);
   delete request;
@@ -1299,6 +1301,7 @@ void AsyncWebSocketResponse::_respond(AsyncWebServerRequest *request){
 size_t AsyncWebSocketResponse::_ack(AsyncWebServerRequest *request, size_t len, uint32_t time){
   (void)time;
   if(len){
+    AsyncWebLockGuard l(_server->clientsLock());
     new AsyncWebSocketClient(request, _server);
   }
   return 0;
@@ -263,6 +263,9 @@ class AsyncWebSocket: public AsyncWebHandler {
     size_t count() const;
     AsyncWebSocketClient * client(uint32_t id);
     bool hasClient(uint32_t id){ return client(id) != NULL; }
+    // Held by the AsyncTCP callbacks while they add, remove or run clients;
+    // hold it (AsyncWebLockGuard) to use the clients from another task
+    AsyncWebLock & clientsLock(){ return _lock; }
 
     void close(uint32_t id, uint16_t code=0, const char * message=NULL);
     void closeAll(uint16_t code=0, const char * message=NULL);
@@ -0,0 +1,128 @@
+#include "GrindPredictor.h"
+
+// Forgetting factor of the model update: older grinds lose weight so the
+// model follows changes in beans, grind size or chute build-up.
+static const float LEARN_FORGETTING = 0.9f;
+// Samples slower than this are treated as "not flowing" when learning
+static const float LEARN_MIN_FLOW_GPS = 0.2f;
+static const float LATENCY_MIN_S = 0.0f;
+static const float LATENCY_MAX_S = 2.0f;
+static const float IN_FLIGHT_MIN_G = -2.0f;
+static const float IN_FLIGHT_MAX_G = 5.0f;
+
+static float clampf(float value, float lo, float hi) {
+  if (value < lo) return lo;
+  if (value > hi) return hi;
+  return value;
+}
+
+GrindPredictor::GrindPredictor() :
+    times(), grams(), head(0), count(0), lastGrams(0), flowGps(0),
+    hasStopped(false), stopGrams(0), stopFlowGps(0),
+    latencyS(0.25f), inFlightG(0.3f) {
+  // Moderate prior: latency is known to within ~0.3 s, chute mass to ~1 g
+  p[0][0] = 0.1f; p[0][1] = 0;
+  p[1][0] = 0;    p[1][1] = 1.0f;
+}
+
+void GrindPredictor::setModel(float latency, float inFlight) {
+  latencyS = clampf(latency, LATENCY_MIN_S, LATENCY_MAX_S);
+  inFlightG = clampf(inFlight, IN_FLIGHT_MIN_G, IN_FLIGHT_MAX_G);
+}
+
+void GrindPredictor::begin() {
+  head = 0;
+  count = 0;
+  lastGrams = 0;
+  flowGps = 0;
+  hasStopped = false;
+}
+
+void GrindPredictor::addSample(int64_t timestampMs, float value) {
+  head = (head + 1) % HISTORY;
+  times[head] = timestampMs;
+  grams[head] = value;
+  if (count < HISTORY) {
+    count += 1;
+  }
+  lastGrams = value;
+  updateFlow();
+}
+
+// Least-squares slope of grams over time for the samples inside the flow
+// window, relative to the newest sample to keep the sums small.
+void GrindPredictor::updateFlow() {
+  int64_t t0 = times[head];
+  float sumT = 0, sumG = 0, sumTT = 0, sumTG = 0;
+  size_t n = 0;
+  size_t index = head;
+  for (size_t i = 0; i < count; i++) {
+    float t = (float)(times[index] - t0) / 1000.0f; // seconds, <= 0
+    if (-t * 1000.0f > FLOW_WINDOW_MS) {
+      break;
+    }
+    float g = grams[index] - lastGrams;
+    sumT += t;
+    sumG += g;
+    sumTT += t * t;
+    sumTG += t * g;
+    n += 1;
+    index = (index == 0) ? HISTORY - 1 : index - 1;
+  }
+
+  if (n < 3) {
+    flowGps = 0; // not enough points for a meaningful slope yet
+    return;
+  }
+  float denominator = n * sumTT - sumT * sumT;
+  flowGps = denominator > 1e-6f ? (n * sumTG - sumT * sumG) / denominator : 0;
+  if (flowGps < 0) {
+    flowGps = 0; // grinding never removes mass; negative slopes are noise
+  }
+}
+
+float GrindPredictor::predictedFinal() const {
+  return lastGrams + flowGps * latencyS + inFlightG;
+}
+
+bool GrindPredictor::shouldStop(float targetGrams) const {
+  return count >= 3 && predictedFinal() >= targetGrams;
+}
+
+void GrindPredictor::markStopped() {
+  hasStopped = true;
+  stopGrams = lastGrams;
+  stopFlowGps = flowGps;
+}
+
+bool GrindPredictor::learn(float settledGrams) {
+  if (!hasStopped || stopFlowGps < LEARN_MIN_FLOW_GPS) {
+    hasStopped = false;
+    return false;
+  }
+  hasStopped = false;
+
+  // Recursive least squares on overshoot = flow * latency + inFlight
+  float x0 = stopFlowGps, x1 = 1.0f;
+  float overshoot = settledGrams - stopGrams;
+  float error = overshoot - (x0 * latencyS + x1 * inFlightG);
+
+  float px0 = p[0][0] * x0 + p[0][1] * x1;
+  float px1 = p[1][0] * x0 + p[1][1] * x1;
+  float denominator = LEARN_FORGETTING + x0 * px0 + x1 * px1;
+  float k0 = px0 / denominator;
+  float k1 = px1 / denominator;
+
+  setModel(latencyS + k0 * error, inFlightG + k1 * error);
+
+  float p00 = (p[0][0] - k0 * px0) / LEARN_FORGETTING;
+  float p01 = (p[0][1] - k0 * px1) / LEARN_FORGETTING;
+  float p10 = (p[1][0] - k1 * px0) / LEARN_FORGETTING;
+  float p11 = (p[1][1] - k1 * px1) / LEARN_FORGETTING;
+  // Bound the covariance so a long run of identical grinds cannot blow it up
+  p[0][0] = clampf(p00, 1e-4f, 1.0f);
+  p[0][1] = p01;
+  p[1][0] = p10;
+  p[1][1] = clampf(p11, 1e-3f, 10.0f);
+  return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Predictive grind stop.
+//
+// While grinding, the current flow (g/s) is estimated with a least-squares
+// slope over the most recent samples. After the relay is cut the grinder
+// keeps delivering for a while (relay/motor latency) and some grounds are
+// still in the chute, so the final weight is modelled as
+//
+//     final = weightAtStop + flowAtStop * latencyS + inFlightG
+//
+// and the relay is cut as soon as that prediction reaches the target. After
+// every grind the observed overshoot (settled - weightAtStop) is fed back
+// with recursive least squares to learn latencyS and inFlightG.
+//
+// Plain C++ without Arduino dependencies so it can be driven from recorded
+// traces on a host as well as from the scale task.
+class GrindPredictor {
+public:
+	static constexpr size_t HISTORY = 64;  // samples kept for the flow fit (FLOW_WINDOW_MS at 80 SPS)
+	static constexpr int64_t FLOW_WINDOW_MS = 600;
+
+	GrindPredictor();
+
+	void setModel(float latencyS, float inFlightG);
+	float latency() const { return latencyS; }
+	float inFlight() const { return inFlightG; }
+
+	// Start a new grind (clears the flow history)
+	void begin();
+	void addSample(int64_t timestampMs, float grams);
+
+	float flowRate() const { return flowGps; }
+	float currentWeight() const { return lastGrams; }
+	float predictedFinal() const;
+	bool shouldStop(float targetGrams) const;
+
+	// Remember weight and flow at the moment the relay was cut
+	void markStopped();
+	bool stopped() const { return hasStopped; }
+	float weightAtStop() const { return stopGrams; }
+	float flowAtStop() const { return stopFlowGps; }
+
+	// Update the model from the settled weight of the finished grind.
+	// Returns false if there was no usable stop to learn from.
+	bool learn(float settledGrams);
+
+private:
+	void updateFlow();
+
+	int64_t times[HISTORY];
+	float grams[HISTORY];
+	size_t head;
+	size_t count;
+
+	float lastGrams;
+	float flowGps;
+
+	bool hasStopped;
+	float stopGrams;
+	float stopFlowGps;
+
+	// Model parameters and RLS covariance
+	float latencyS;
+	float inFlightG;
+	float p[2][2];
+};
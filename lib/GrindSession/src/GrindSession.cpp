@@ -0,0 +1,151 @@
+#include "GrindSession.h"
+
+// Weight above the cup that starts the timer in scale mode
+static const float SCALE_MODE_START_G = 0.1f;
+
+GrindSession::GrindSession(GrindClock &clock, GrindRelay &relay, GrindPredictor &predictor) :
+    clock(clock), relay(relay), predictor(predictor), limits(),
+    currentState(IDLE), failureReason(FAIL_NONE), scaleMode(false), predictive(false),
+    predictedStop(false), targetG(0), cupG(0), startMs(0), stopMs(0),
+    recentTimes(), recentValues(), recentHead(0), recentCount(0),
+    coarseTimes(), coarseValues(), coarseHead(0), coarseCount(0) {
+}
+
+void GrindSession::start(float target, float cup, bool timerMode, bool usePredictor) {
+  targetG = target;
+  cupG = cup;
+  scaleMode = timerMode;
+  predictive = usePredictor && !timerMode;
+  predictedStop = false;
+  failureReason = FAIL_NONE;
+  stopMs = 0;
+  startMs = scaleMode ? 0 : clock.nowMs();
+  recentCount = 0;
+  coarseCount = 0;
+  predictor.begin();
+  currentState = RUNNING;
+  relay.set(true);
+}
+
+void GrindSession::addSample(uint32_t timestampMs, float fusedG, float estimateG) {
+  if (currentState != RUNNING) return;
+  predictor.addSample(timestampMs, fusedG);
+
+  recentHead = (recentHead + 1) % RECENT;
+  recentTimes[recentHead] = timestampMs;
+  recentValues[recentHead] = estimateG;
+  if (recentCount < RECENT) recentCount++;
+
+  if (coarseCount == 0 || timestampMs - coarseTimes[coarseHead] >= COARSE_STEP_MS) {
+    coarseHead = (coarseHead + 1) % COARSE;
+    coarseTimes[coarseHead] = timestampMs;
+    coarseValues[coarseHead] = estimateG;
+    if (coarseCount < COARSE) coarseCount++;
+  }
+}
+
+float GrindSession::minOverStopWindow() const {
+  uint32_t now = clock.nowMs();
+  float result = 0;
+  size_t index = recentHead;
+  for (size_t i = 0; i < recentCount; i++) {
+    if (now - recentTimes[index] > limits.stopWindowMs) break;
+    if (i == 0 || recentValues[index] < result) result = recentValues[index];
+    index = (index == 0) ? RECENT - 1 : index - 1;
+  }
+  return result;
+}
+
+float GrindSession::maxOverStopWindow() const {
+  uint32_t now = clock.nowMs();
+  float result = 0;
+  size_t index = recentHead;
+  for (size_t i = 0; i < recentCount; i++) {
+    if (now - recentTimes[index] > limits.stopWindowMs) break;
+    if (i == 0 || recentValues[index] > result) result = recentValues[index];
+    index = (index == 0) ? RECENT - 1 : index - 1;
+  }
+  return result;
+}
+
+// The min/max checks need a sample inside the stop window: right after
+// start() and across an acquisition gap (rate switch) the window is empty
+// and min/max read 0
+bool GrindSession::windowFresh(uint32_t now) const {
+  return recentCount > 0 && now - recentTimes[recentHead] <= limits.stopWindowMs;
+}
+
+// Newest coarse sample taken before cutoffMs, 0 if there is none
+float GrindSession::valueOlderThan(uint32_t cutoffMs) const {
+  size_t index = coarseHead;
+  for (size_t i = 0; i < coarseCount; i++) {
+    if ((int32_t)(cutoffMs - coarseTimes[index]) > 0) return coarseValues[index];
+    index = (index == 0) ? COARSE - 1 : index - 1;
+  }
+  return 0;
+}
+
+bool GrindSession::finish(State state, Failure failure) {
+  relay.set(false);
+  stopMs = clock.nowMs();
+  currentState = state;
+  failureReason = failure;
+  if (state == STOPPED) predictor.markStopped();
+  return true;
+}
+
+bool GrindSession::update(float estimateG, bool scaleReady) {
+  if (currentState != RUNNING) return false;
+  uint32_t now = clock.nowMs();
+
+  if (estimateG < limits.removedBelowG) return finish(FAILED, FAIL_CUP_LIFTED);
+  if (!scaleReady) return finish(FAILED, FAIL_NOT_READY);
+
+  if (scaleMode) {
+    // Timing starts with the first grounds on the scale
+    if (startMs == 0 && estimateG - cupG >= SCALE_MODE_START_G) {
+      startMs = now;
+      return false;
+    }
+  } else {
+    if (now - startMs > limits.maxGrindMs) return finish(FAILED, FAIL_TIMEOUT);
+    if (now - startMs > limits.noFlowMs &&
+        estimateG - valueOlderThan(now - limits.noFlowMs) < limits.noFlowMinG) {
+      return finish(FAILED, FAIL_NO_FLOW);
+    }
+    if (windowFresh(now) && minOverStopWindow() < cupG - limits.cupToleranceG) {
+      return finish(FAILED, FAIL_CUP_REMOVED);
+    }
+  }
+
+  predictedStop = predictive && predictor.shouldStop(targetG);
+  if (predictedStop || (windowFresh(now) && maxOverStopWindow() >= targetG)) return finish(STOPPED, FAIL_NONE);
+  return false;
+}
+
+void GrindSession::abort() {
+  relay.set(false);
+  currentState = IDLE;
+}
+
+const char *GrindSession::failureName(Failure failure) {
+  switch (failure) {
+    case FAIL_CUP_LIFTED: return "Significantly negative weight detected (cup removed)";
+    case FAIL_NOT_READY: return "Scale not ready";
+    case FAIL_TIMEOUT: return "Max grinding time exceeded";
+    case FAIL_NO_FLOW: return "No weight increase";
+    case FAIL_CUP_REMOVED: return "Cup removed";
+    default: return "none";
+  }
+}
+
+const char *GrindSession::failureKey(Failure failure) {
+  switch (failure) {
+    case FAIL_CUP_LIFTED: return "cup_lifted";
+    case FAIL_NOT_READY: return "not_ready";
+    case FAIL_TIMEOUT: return "timeout";
+    case FAIL_NO_FLOW: return "no_flow";
+    case FAIL_CUP_REMOVED: return "cup_removed";
+    default: return "none";
+  }
+}
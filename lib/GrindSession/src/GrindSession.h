@@ -0,0 +1,108 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <GrindPredictor.h>
+
+// Hardware seams of a grind. The device implements them with millis() and
+// the relay GPIO (scale_hal.hpp); a replay implements them with the trace
+// timestamps and a relay that only records what it was told.
+class GrindClock {
+public:
+	virtual ~GrindClock() {}
+	virtual uint32_t nowMs() = 0;
+};
+
+class GrindRelay {
+public:
+	virtual ~GrindRelay() {}
+	// Idempotent: switching off an already stopped grinder is harmless
+	virtual void set(bool on) = 0;
+};
+
+struct GrindLimits {
+	uint32_t maxGrindMs = 20000;    // fail when grinding takes longer than this
+	uint32_t noFlowMs = 5000;       // fail when the weight rose less than
+	float noFlowMinG = 1.0f;        // noFlowMinG during the last noFlowMs
+	float cupToleranceG = 5.0f;     // fail when the weight drops this far below the cup
+	float removedBelowG = -10.0f;   // fail when the scale reads below this (cup lifted)
+	uint32_t stopWindowMs = 200;    // window of the min/max checks
+};
+
+// Decision logic of one grind, from relay on to stop or failure: the
+// failure checks, the predictive stop and the plain threshold stop.
+//
+// Samples and the filtered estimate are fed with addSample(), decisions are
+// taken by update(): on the device both run per sample in the scale task,
+// and the status task calls update() as well for the time limits when no
+// samples arrive. Callers serialize access.
+// Plain C++ without Arduino dependencies so recorded traces can be replayed
+// through exactly the logic that runs on the device.
+class GrindSession {
+public:
+	enum State : uint8_t { IDLE, RUNNING, STOPPED, FAILED };
+	enum Failure : uint8_t { FAIL_NONE, FAIL_CUP_LIFTED, FAIL_NOT_READY, FAIL_TIMEOUT, FAIL_NO_FLOW, FAIL_CUP_REMOVED };
+
+	GrindSession(GrindClock &clock, GrindRelay &relay, GrindPredictor &predictor);
+
+	void setLimits(const GrindLimits &limits) { this->limits = limits; }
+	const GrindLimits &getLimits() const { return limits; }
+
+	// Switch the grinder on and grind until the scale reads targetG (absolute,
+	// i.e. including the cup where applicable). In scale mode the relay is
+	// still switched on, but the grind only starts timing once weight shows
+	// up and only the threshold stop and the basic failure checks apply.
+	void start(float targetG, float cupG, bool scaleMode, bool predictive);
+	void addSample(uint32_t timestampMs, float fusedG, float estimateG);
+	// Evaluate stop and failure conditions; returns true if the state changed
+	bool update(float estimateG, bool scaleReady);
+	// Relay off and back to IDLE without a result
+	void abort();
+
+	State state() const { return currentState; }
+	Failure failure() const { return failureReason; }
+	static const char *failureName(Failure failure);
+	// Short identifier for logs and APIs ("no_flow")
+	static const char *failureKey(Failure failure);
+
+	uint32_t startedAt() const { return startMs; } // 0 until timing started (scale mode)
+	uint32_t stoppedAt() const { return stopMs; }
+	float target() const { return targetG; }
+	float cupWeight() const { return cupG; }
+	bool stoppedByPrediction() const { return predictedStop; }
+	float minOverStopWindow() const;
+	float maxOverStopWindow() const;
+
+private:
+	static constexpr size_t RECENT = 32;   // newest samples, for the stop window
+	static constexpr size_t COARSE = 32;   // one sample per COARSE_STEP_MS, for the no-flow check
+	static constexpr uint32_t COARSE_STEP_MS = 250;
+
+	bool finish(State state, Failure failure);
+	float valueOlderThan(uint32_t cutoffMs) const;
+	bool windowFresh(uint32_t now) const;
+
+	GrindClock &clock;
+	GrindRelay &relay;
+	GrindPredictor &predictor;
+	GrindLimits limits;
+
+	State currentState;
+	Failure failureReason;
+	bool scaleMode;
+	bool predictive;
+	bool predictedStop;
+	float targetG;
+	float cupG;
+	uint32_t startMs;
+	uint32_t stopMs;
+
+	uint32_t recentTimes[RECENT];
+	float recentValues[RECENT];
+	size_t recentHead;
+	size_t recentCount;
+
+	uint32_t coarseTimes[COARSE];
+	float coarseValues[COARSE];
+	size_t coarseHead;
+	size_t coarseCount;
+};
@@ -0,0 +1,92 @@
+#include "TraceReplay.h"
+
+// Traces without a recorded settled weight: the first SETTLED_SAMPLES
+// finished samples within SETTLED_SPREAD_G of each other. The last samples
+// of a trace are taken while the cup is lifted, so they are no measure.
+static const size_t SETTLED_SAMPLES = 5;
+static const float SETTLED_SPREAD_G = 0.2f;
+// GrindTraceSample::state values, as recorded from scaleStatus
+static const uint8_t TRACE_STATE_GRINDING = 1;
+static const uint8_t TRACE_STATE_FINISHED = 2;
+
+void ReplayRelay::set(bool on) {
+  if (on != isOn) switches++;
+  if (isOn && !on && clock) offAtMs = clock->nowMs();
+  isOn = on;
+}
+
+TraceReplay::TraceReplay(GrindPredictor &predictor, ReplayEstimator &estimator) :
+    clock(), relay(), predictor(predictor), estimator(estimator), session(clock, relay, predictor) {
+  relay.clock = &clock;
+}
+
+ReplayResult TraceReplay::run(const uint8_t *trace, size_t length, float targetG, bool predictive) {
+  ReplayResult result = {};
+  result.recordedStopMs = -1;
+  result.replayStopMs = -1;
+
+  GrindTraceReader reader;
+  GrindTraceSample sample;
+  if (!reader.begin(trace, length) || !reader.next(sample)) return result;
+  if (targetG < 0) targetG = reader.header().targetG;
+
+  relay.reset();
+  estimator.reset();
+  uint32_t startMs = sample.timeMs;
+  clock.set(startMs);
+  session.start(targetG, reader.header().cupG, false, predictive);
+
+  bool settledKnown = (reader.header().flags & GRIND_TRACE_FLAG_SETTLED) != 0;
+  if (settledKnown) result.recordedFinalG = reader.header().settledMg / 1000.0f;
+  float settled[SETTLED_SAMPLES] = {};
+  size_t settledCount = 0;
+  do {
+    clock.set(sample.timeMs);
+    if (result.recordedStopMs < 0 && sample.state != TRACE_STATE_GRINDING) {
+      result.recordedStopMs = (int32_t)(sample.timeMs - startMs);
+    }
+    if (!settledKnown) {
+      if (sample.state == TRACE_STATE_FINISHED) {
+        settled[settledCount % SETTLED_SAMPLES] = sample.fusedMg / 1000.0f;
+        settledCount++;
+      } else {
+        settledCount = 0;
+      }
+      if (settledCount >= SETTLED_SAMPLES) {
+        float low = settled[0], high = settled[0], sum = 0;
+        for (float grams : settled) {
+          low = grams < low ? grams : low;
+          high = grams > high ? grams : high;
+          sum += grams;
+        }
+        if (high - low <= SETTLED_SPREAD_G) {
+          result.recordedFinalG = sum / SETTLED_SAMPLES;
+          settledKnown = true;
+        }
+      }
+    }
+
+    float fused = sample.fusedMg / 1000.0f;
+    float estimate = estimator.update(sample.timeMs, fused);
+    if (session.state() == GrindSession::RUNNING) {
+      session.addSample(sample.timeMs, fused, estimate);
+      session.update(estimate, true);
+      result.samples++;
+    }
+  } while (reader.next(sample));
+
+  result.valid = true;
+  result.state = session.state();
+  result.failure = session.failure();
+  result.predicted = session.stoppedByPrediction();
+  if (session.state() != GrindSession::RUNNING) {
+    result.replayStopMs = (int32_t)(session.stoppedAt() - startMs);
+  } else {
+    session.abort();
+  }
+  if (session.state() == GrindSession::STOPPED) {
+    result.stopWeightG = predictor.weightAtStop();
+    result.predictedFinalG = predictor.weightAtStop() + predictor.flowAtStop() * predictor.latency() + predictor.inFlight();
+  }
+  return result;
+}
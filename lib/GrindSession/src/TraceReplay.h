@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <GrindTrace.h>
+#include "GrindSession.h"
+
+// Clock driven by the replayed samples instead of real time
+class ReplayClock : public GrindClock {
+public:
+	uint32_t nowMs() override { return now; }
+	void set(uint32_t ms) { now = ms; }
+
+private:
+	uint32_t now = 0;
+};
+
+// Relay that only remembers when it was switched
+class ReplayRelay : public GrindRelay {
+public:
+	void set(bool on) override;
+	void reset() { isOn = false; offAtMs = 0; switches = 0; }
+
+	ReplayClock *clock = nullptr;
+	bool isOn = false;
+	uint32_t offAtMs = 0;
+	uint32_t switches = 0;
+};
+
+// Turns the fused weight of a sample into the estimate the status logic
+// sees (the device runs its grinding filter profile); the default passes it
+// through.
+class ReplayEstimator {
+public:
+	virtual ~ReplayEstimator() {}
+	virtual void reset() {}
+	virtual float update(uint32_t timestampMs, float fusedG) { (void)timestampMs; return fusedG; }
+};
+
+struct ReplayResult {
+	bool valid;                 // trace decoded and contained a grind
+	uint32_t samples;           // samples fed into the session
+	GrindSession::State state;  // outcome of the replayed grind
+	GrindSession::Failure failure;
+	bool predicted;             // stopped by the predictor, not the threshold
+	int32_t recordedStopMs;     // when the recorded grind stopped (from start), -1 if never
+	int32_t replayStopMs;       // when the replay stopped (from start), -1 if never
+	float stopWeightG;          // weight at the replayed stop
+	float predictedFinalG;      // what the predictor expected the grind to settle at
+	float recordedFinalG;       // settled weight of the recorded grind, 0 if unknown
+};
+
+// Feeds a recorded trace through a GrindSession at full speed: the clock
+// follows the sample timestamps, so a 20 s grind replays in microseconds
+// and every run is deterministic. After the relay goes off the recorded
+// samples no longer match what the replayed grinder would have done, so
+// the result compares stop times and weights instead of continuing.
+class TraceReplay {
+public:
+	TraceReplay(GrindPredictor &predictor, ReplayEstimator &estimator);
+
+	void setLimits(const GrindLimits &limits) { session.setLimits(limits); }
+
+	// targetG < 0 uses the target stored in the trace header
+	ReplayResult run(const uint8_t *trace, size_t length, float targetG = -1, bool predictive = true);
+
+private:
+	ReplayClock clock;
+	ReplayRelay relay;
+	GrindPredictor &predictor;
+	ReplayEstimator &estimator;
+	GrindSession session;
+};
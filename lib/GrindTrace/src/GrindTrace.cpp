@@ -0,0 +1,132 @@
+#include "GrindTrace.h"
+#include <string.h>
+
+// The state byte never takes this value, so the first sample always carries it
+static const uint8_t NO_STATE = 0xFF;
+
+static inline uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static GrindTraceSample baseSample(const GrindTraceHeader &hdr) {
+  GrindTraceSample base;
+  base.timeMs = hdr.startMs;
+  base.raw1 = hdr.raw1Base;
+  base.raw2 = hdr.raw2Base;
+  base.fusedMg = hdr.fusedBaseMg;
+  base.state = NO_STATE;
+  return base;
+}
+
+GrindTraceWriter::GrindTraceWriter() : buf(nullptr), cap(0), hdr(), prev() {}
+
+void GrindTraceWriter::begin(uint8_t *buffer, size_t capacity, const GrindTraceHeader &info) {
+  buf = buffer;
+  cap = capacity;
+  hdr = info;
+  hdr.magic = GRIND_TRACE_MAGIC;
+  hdr.version = GRIND_TRACE_VERSION;
+  hdr.flags = 0;
+  hdr.sampleCount = 0;
+  hdr.dataLength = 0;
+  hdr.settledMg = 0;
+}
+
+void GrindTraceWriter::putVarint(uint32_t value) {
+  uint8_t *out = buf + sizeof(GrindTraceHeader) + hdr.dataLength;
+  while (value >= 0x80) {
+    *out++ = (uint8_t)(value | 0x80);
+    value >>= 7;
+    hdr.dataLength++;
+  }
+  *out = (uint8_t)value;
+  hdr.dataLength++;
+}
+
+bool GrindTraceWriter::append(const GrindTraceSample &sample) {
+  if (!buf) return false;
+  if (sizeof(GrindTraceHeader) + hdr.dataLength + MAX_SAMPLE_BYTES > cap) {
+    hdr.flags |= GRIND_TRACE_FLAG_TRUNCATED;
+    return false;
+  }
+  if (hdr.sampleCount == 0) {
+    hdr.startMs = sample.timeMs;
+    hdr.raw1Base = sample.raw1;
+    hdr.raw2Base = sample.raw2;
+    hdr.fusedBaseMg = sample.fusedMg;
+    prev = baseSample(hdr);
+  }
+
+  bool stateChanged = sample.state != prev.state;
+  // millis() is monotonic; a wrapped timestamp still yields the right delta
+  putVarint(((sample.timeMs - prev.timeMs) << 1) | (stateChanged ? 1 : 0));
+  if (stateChanged) {
+    buf[sizeof(GrindTraceHeader) + hdr.dataLength++] = sample.state;
+  }
+  putVarint(zigzag(sample.raw1 - prev.raw1));
+  putVarint(zigzag(sample.raw2 - prev.raw2));
+  putVarint(zigzag(sample.fusedMg - prev.fusedMg));
+
+  prev = sample;
+  hdr.sampleCount++;
+  return true;
+}
+
+void GrindTraceWriter::setSettled(int32_t settledMg) {
+  hdr.settledMg = settledMg;
+  hdr.flags |= GRIND_TRACE_FLAG_SETTLED;
+}
+
+size_t GrindTraceWriter::finish() {
+  if (!buf) return 0;
+  memcpy(buf, &hdr, sizeof(hdr));
+  return sizeof(GrindTraceHeader) + hdr.dataLength;
+}
+
+bool GrindTraceReader::begin(const uint8_t *buffer, size_t len) {
+  data = buffer;
+  length = len;
+  pos = sizeof(GrindTraceHeader);
+  if (len < sizeof(GrindTraceHeader)) return false;
+  memcpy(&hdr, buffer, sizeof(hdr));
+  if (hdr.magic != GRIND_TRACE_MAGIC || hdr.version != GRIND_TRACE_VERSION) return false;
+  if (sizeof(GrindTraceHeader) + hdr.dataLength > len) return false;
+  remaining = hdr.sampleCount;
+  prev = baseSample(hdr);
+  return true;
+}
+
+bool GrindTraceReader::getVarint(uint32_t &value) {
+  size_t end = sizeof(GrindTraceHeader) + hdr.dataLength;
+  value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (pos >= end) return false;
+    uint8_t byte = data[pos++];
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+bool GrindTraceReader::next(GrindTraceSample &sample) {
+  if (remaining == 0) return false;
+  uint32_t dt, d1, d2, dm;
+  if (!getVarint(dt)) return false;
+  sample.state = prev.state;
+  if (dt & 1) {
+    if (pos >= sizeof(GrindTraceHeader) + hdr.dataLength) return false;
+    sample.state = data[pos++];
+  }
+  if (!getVarint(d1) || !getVarint(d2) || !getVarint(dm)) return false;
+  sample.timeMs = prev.timeMs + (dt >> 1);
+  sample.raw1 = prev.raw1 + unzigzag(d1);
+  sample.raw2 = prev.raw2 + unzigzag(d2);
+  sample.fusedMg = prev.fusedMg + unzigzag(dm);
+  prev = sample;
+  remaining--;
+  return true;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Compact binary trace of one grind.
+//
+// A trace is a fixed 64-byte header followed by a delta-encoded sample
+// stream. Every sample is written as unsigned LEB128 varints:
+//
+//     (dtMs << 1) | stateChanged   time since the previous sample
+//     [state]                      one byte, only if stateChanged
+//     zigzag(raw1 - prevRaw1)      sensor1 counts
+//     zigzag(raw2 - prevRaw2)      sensor2 counts
+//     zigzag(fusedMg - prevMg)     fused weight in milligrams
+//
+// The first sample is encoded against the base values in the header, so it
+// costs ~5 bytes; a typical sample at 10 SPS costs 7-9 bytes.
+//
+// All multi-byte header fields are little-endian (the ESP32's native order),
+// see tools/decode_traces.py for the host-side decoder.
+//
+// Plain C++ without Arduino dependencies so traces can be decoded and
+// replayed on a host as well as on the device.
+
+static const uint32_t GRIND_TRACE_MAGIC = 0x54574247; // "GBWT"
+static const uint16_t GRIND_TRACE_VERSION = 1;
+static const uint16_t GRIND_TRACE_FLAG_TRUNCATED = 0x0001; // buffer filled before the grind ended
+static const uint16_t GRIND_TRACE_FLAG_SETTLED = 0x0002;   // settledMg holds the settled weight
+
+struct GrindTraceHeader {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t flags;
+	uint32_t shotId;       // monotonic across reboots
+	uint32_t sampleCount;
+	uint32_t dataLength;   // bytes of sample stream after the header
+	int32_t raw1Base;      // first sample, the stream starts from these
+	int32_t raw2Base;
+	int32_t fusedBaseMg;
+	uint32_t startMs;      // millis() of the first sample
+	int32_t offset1;       // calibration in effect, to turn raw counts into grams
+	int32_t offset2;
+	float factor1;
+	float factor2;
+	float targetG;         // scale reading the grind aimed for (cup included where applicable)
+	float cupG;            // cup weight captured at grind start
+	int32_t settledMg;     // weight the grind settled at, if GRIND_TRACE_FLAG_SETTLED
+};
+static_assert(sizeof(GrindTraceHeader) == 64, "trace header layout is part of the file format");
+
+struct GrindTraceSample {
+	uint32_t timeMs;       // millis() of the sample
+	int32_t raw1;
+	int32_t raw2;
+	int32_t fusedMg;
+	uint8_t state;         // scaleStatus when the sample was taken
+};
+
+// Appends samples to a caller-provided buffer. The sample stream is written
+// after room for the header; finish() stores the header in front of it.
+class GrindTraceWriter {
+public:
+	static constexpr size_t MAX_SAMPLE_BYTES = 21; // 4 varints of <= 5 bytes + state
+
+	GrindTraceWriter();
+
+	// Start a new trace in buffer (capacity includes the header)
+	void begin(uint8_t *buffer, size_t capacity, const GrindTraceHeader &info);
+	// Returns false (and flags the trace truncated) once the buffer is full
+	bool append(const GrindTraceSample &sample);
+	// Record the weight the scale settled at after the stop. The last
+	// samples of a trace are taken while the cup is lifted, so they are no
+	// measure of the result.
+	void setSettled(int32_t settledMg);
+	// Write the header; returns the number of bytes of the complete trace
+	size_t finish();
+
+	const GrindTraceHeader &header() const { return hdr; }
+	bool active() const { return buf != nullptr; }
+	void reset() { buf = nullptr; }
+
+private:
+	void putVarint(uint32_t value);
+
+	uint8_t *buf;
+	size_t cap;
+	GrindTraceHeader hdr;
+	GrindTraceSample prev;
+};
+
+// Walks the samples of an encoded trace
+class GrindTraceReader {
+public:
+	// Returns false if the buffer does not hold a valid trace
+	bool begin(const uint8_t *buffer, size_t length);
+	// Returns false at the end of the stream or on corrupt data
+	bool next(GrindTraceSample &sample);
+
+	const GrindTraceHeader &header() const { return hdr; }
+
+private:
+	bool getVarint(uint32_t &value);
+
+	const uint8_t *data;
+	size_t length;
+	size_t pos;
+	uint32_t remaining;
+	GrindTraceHeader hdr;
+	GrindTraceSample prev;
+};
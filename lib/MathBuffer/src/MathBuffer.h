@@ -3,6 +3,7 @@
 #include <stddef.h>
 #include <Arduino.h>
 #include <type_traits>
+#include <functional>
 
 template<typename T, size_t S> class MathBuffer {
 public:
@@ -12,6 +13,12 @@ public:
 
 	bool push(T value);
 
+	// Visit samples from newest to oldest. The visitor is a template parameter
+	// so it is inlined; it gets (value, timestampMs) and returns false to stop.
+	template<typename F> void visitSamples(F &&visitor);
+	// Same, limited to samples taken at or after cutoffMs
+	template<typename F> void visitSamplesSince(int64_t cutoffMs, F &&visitor);
+
 	void executeOnSamplesSince(int64_t cutoffMs, std::function<void (T, int64_t)> iterator);
 	size_t countSamplesSince(int64_t cutoffMs);
 	T averageSince(int64_t cutoffMs);
@@ -19,7 +26,7 @@ public:
 	T minSince(int64_t cutoffMs);
 	T firstValueOlderThan(int64_t cutoffMs);
 
-private:
+protected:
 	T buffer[S];
 	int64_t bufferTimestamp[S];
 
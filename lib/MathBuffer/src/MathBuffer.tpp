@@ -23,45 +23,55 @@ bool MathBuffer<T, S>::push(T value) {
 }
 
 template<typename T,size_t S>
-void MathBuffer<T, S>::executeOnSamplesSince(int64_t cutoffMs, std::function<void (T, int64_t)> iterator) {
-  for (int i = 0; i < count; i++) {
-    int index = (headIndex - i); // going backward to go from newest to oldest
-    if (index < 0) { // wrap around
-      index += S;
-    }
-    if (bufferTimestamp[index] < cutoffMs) {
+template<typename F>
+void MathBuffer<T, S>::visitSamples(F &&visitor) {
+  size_t index = headIndex;
+  for (size_t i = 0; i < count; i++) { // going backward to go from newest to oldest
+    if (!visitor(buffer[index], bufferTimestamp[index])) {
       return;
     }
-    iterator(buffer[index], bufferTimestamp[index]);
+    index = (index == 0) ? S - 1 : index - 1; // wrap around
   }
 }
 
 template<typename T,size_t S>
-size_t MathBuffer<T, S>::countSamplesSince(int64_t cutoffMs) {
-  for (int i = 0; i < count; i++) {
-    int index = (headIndex - i); // going backward to go from newest to oldest
-    if (index < 0) { // wrap around
-      index += S;
+template<typename F>
+void MathBuffer<T, S>::visitSamplesSince(int64_t cutoffMs, F &&visitor) {
+  visitSamples([&visitor, cutoffMs](T value, int64_t ms) {
+    if (ms < cutoffMs) {
+      return false;
     }
-    if (bufferTimestamp[index] < cutoffMs) {
-      return i;
-    }
-  }
+    visitor(value, ms);
+    return true;
+  });
+}
 
-  return count;
+template<typename T,size_t S>
+void MathBuffer<T, S>::executeOnSamplesSince(int64_t cutoffMs, std::function<void (T, int64_t)> iterator) {
+  visitSamplesSince(cutoffMs, iterator);
+}
+
+template<typename T,size_t S>
+size_t MathBuffer<T, S>::countSamplesSince(int64_t cutoffMs) {
+  size_t sampleCount = 0;
+  visitSamplesSince(cutoffMs, [&sampleCount](T, int64_t) {
+    sampleCount += 1;
+  });
+
+  return sampleCount;
 }
 
 
 template<typename T,size_t S>
 T MathBuffer<T, S>::averageSince(int64_t cutoffMs) {
-  size_t sampleCount = countSamplesSince(cutoffMs);
-
-  T average = 0;
-  executeOnSamplesSince(cutoffMs, [&average, &sampleCount](T value, int64_t ms) {
-    average += value / sampleCount;
+  size_t sampleCount = 0;
+  T sum = 0;
+  visitSamplesSince(cutoffMs, [&sum, &sampleCount](T value, int64_t) {
+    sum += value;
+    sampleCount += 1;
   });
 
-  return average;
+  return sampleCount > 0 ? sum / sampleCount : 0;
 }
 
 template<typename T,size_t S>
@@ -69,7 +79,7 @@ T MathBuffer<T, S>::maxSince(int64_t cutoffMs) {
   T max = 0;
   bool isFirst = true;
 
-  executeOnSamplesSince(cutoffMs, [&max, &isFirst](T value, int64_t ms) {
+  visitSamplesSince(cutoffMs, [&max, &isFirst](T value, int64_t) {
     if (isFirst || value > max) {
       max = value;
       isFirst = false;
@@ -84,7 +94,7 @@ T MathBuffer<T, S>::minSince(int64_t cutoffMs) {
   T min = 0;
   bool isFirst = true;
 
-  executeOnSamplesSince(cutoffMs, [&min, &isFirst](T value, int64_t ms) {
+  visitSamplesSince(cutoffMs, [&min, &isFirst](T value, int64_t) {
     if (isFirst || value < min) {
       min = value;
       isFirst = false;
@@ -96,16 +106,15 @@ T MathBuffer<T, S>::minSince(int64_t cutoffMs) {
 
 template<typename T,size_t S>
 T MathBuffer<T, S>::firstValueOlderThan(int64_t cutoffMs) {
-  for (int i = 0; i < count; i++) {
-    int index = (headIndex - i); // going backward to go from newest to oldest
-    if (index < 0) { // wrap around
-      index += S;
-    }
-    if (bufferTimestamp[index] < cutoffMs) {
-      return buffer[index];
+  T found = 0;
+  visitSamples([&found, cutoffMs](T value, int64_t ms) {
+    if (ms < cutoffMs) {
+      found = value;
+      return false;
     }
-  }
-  return 0;
+    return true;
+  });
+  return found;
 }
 
 // Macro to calculate the absolute value
@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <Arduino.h>
+#include <type_traits>
+#include "SlidingWindow.h"
+
+// Structure-of-arrays ring buffer: C value columns of type T sharing one
+// timestamp column, so every push records one consistent sample across all
+// channels (e.g. raw counts of both cells, fused grams, filter estimate).
+//
+// Up to W (channel, window length) pairs can be registered; their count,
+// average, min and max are maintained on push and are O(1) to query.
+// Unregistered windows fall back to a walk over the ring.
+//
+// Queries expire old samples, so they modify the windows just like push();
+// both run in a short critical section because producer and consumers are
+// usually different tasks. Walks over the ring (unregistered windows, the
+// *Since queries and the visitors) hold the same lock.
+template<typename T, size_t S, size_t C, size_t W> class MultiChannelBuffer {
+public:
+	constexpr MultiChannelBuffer();
+
+	static constexpr size_t capacity = S;
+	static constexpr size_t channels = C;
+
+	bool push(const T (&values)[C]);
+	bool push(const T (&values)[C], int64_t timestampMs);
+
+	// Register a window on one channel; returns false if all W slots are in use
+	bool addWindow(size_t channel, int64_t windowMs);
+
+	size_t countOver(size_t channel, int64_t windowMs);
+	T averageOver(size_t channel, int64_t windowMs);
+	T maxOver(size_t channel, int64_t windowMs);
+	T minOver(size_t channel, int64_t windowMs);
+
+	// Visit one channel from newest to oldest; the visitor gets
+	// (value, timestampMs) and returns false to stop. It runs inside the
+	// critical section, so keep it short and do not call back into the buffer.
+	template<typename F> void visitSamples(size_t channel, F &&visitor);
+	template<typename F> void visitSamplesSince(size_t channel, int64_t cutoffMs, F &&visitor);
+
+	size_t countSamplesSince(int64_t cutoffMs);
+	T averageSince(size_t channel, int64_t cutoffMs);
+	T maxSince(size_t channel, int64_t cutoffMs);
+	T minSince(size_t channel, int64_t cutoffMs);
+	T firstValueOlderThan(size_t channel, int64_t cutoffMs);
+	T latest(size_t channel) const;
+	int64_t latestTimestamp() const;
+
+private:
+	static_assert(std::is_arithmetic<T>::value, "T must be numeric");
+
+	struct ChannelWindow {
+		size_t channel;
+		SlidingWindow<T, S> window;
+	};
+
+	SlidingWindow<T, S> *window(size_t channel, int64_t windowMs);
+	// Ring walks and statistics for callers that hold the lock
+	template<typename F> void walk(size_t channel, F &&visitor) const;
+	template<typename F> void walkSince(size_t channel, int64_t cutoffMs, F &&visitor) const;
+	size_t countSince(int64_t cutoffMs) const;
+	T averageSinceUnlocked(size_t channel, int64_t cutoffMs) const;
+	T maxSinceUnlocked(size_t channel, int64_t cutoffMs) const;
+	T minSinceUnlocked(size_t channel, int64_t cutoffMs) const;
+	void lock();
+	void unlock();
+
+	T columns[C][S];
+	int64_t bufferTimestamp[S];
+
+	size_t headIndex;
+	size_t count;
+
+	ChannelWindow windows[W];
+	size_t windowCount;
+#if defined(ARDUINO_ARCH_ESP32)
+	portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+};
+
+#include "MultiChannelBuffer.tpp"
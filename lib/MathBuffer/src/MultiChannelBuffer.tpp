@@ -0,0 +1,268 @@
+#include "MultiChannelBuffer.h"
+
+template<typename T, size_t S, size_t C, size_t W>
+constexpr MultiChannelBuffer<T,S,C,W>::MultiChannelBuffer() :
+		headIndex(0), count(0), windows(), windowCount(0) {
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+void MultiChannelBuffer<T, S, C, W>::lock() {
+#if defined(ARDUINO_ARCH_ESP32)
+  portENTER_CRITICAL(&mux);
+#endif
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+void MultiChannelBuffer<T, S, C, W>::unlock() {
+#if defined(ARDUINO_ARCH_ESP32)
+  portEXIT_CRITICAL(&mux);
+#endif
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+bool MultiChannelBuffer<T, S, C, W>::push(const T (&values)[C]) {
+  return push(values, millis());
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+bool MultiChannelBuffer<T, S, C, W>::push(const T (&values)[C], int64_t timestampMs) {
+  lock();
+  // The slot about to be written holds the oldest sample once the ring is
+  // full; it has to leave every window before it is overwritten.
+  for (size_t i = 0; i < windowCount; i++) {
+    windows[i].window.expire(timestampMs, S - 1);
+  }
+
+  headIndex += 1;
+  if (headIndex >= S) {
+    headIndex = 0;
+  }
+  if (count < S) {
+    count += 1;
+  }
+
+  for (size_t c = 0; c < C; c++) {
+    columns[c][headIndex] = values[c];
+  }
+  bufferTimestamp[headIndex] = timestampMs;
+
+  for (size_t i = 0; i < windowCount; i++) {
+    windows[i].window.add(headIndex);
+  }
+  unlock();
+
+  return count == S; // Return true if buffer is full
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+bool MultiChannelBuffer<T, S, C, W>::addWindow(size_t channel, int64_t windowMs) {
+  lock();
+  bool added = windowCount < W && channel < C;
+  if (added) {
+    // Windows start empty; they fill up with the samples pushed from now on
+    windows[windowCount].channel = channel;
+    windows[windowCount].window.attach(columns[channel], bufferTimestamp, windowMs);
+    windowCount += 1;
+  }
+  unlock();
+  return added;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+SlidingWindow<T, S> *MultiChannelBuffer<T, S, C, W>::window(size_t channel, int64_t windowMs) {
+  for (size_t i = 0; i < windowCount; i++) {
+    if (windows[i].channel == channel && windows[i].window.length() == windowMs) {
+      windows[i].window.expire(millis(), S);
+      return &windows[i].window;
+    }
+  }
+  return nullptr;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+size_t MultiChannelBuffer<T, S, C, W>::countOver(size_t channel, int64_t windowMs) {
+  lock();
+  SlidingWindow<T, S> *w = window(channel, windowMs);
+  size_t result = w ? w->count() : countSince((int64_t)millis() - windowMs);
+  unlock();
+  return result;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::averageOver(size_t channel, int64_t windowMs) {
+  lock();
+  SlidingWindow<T, S> *w = window(channel, windowMs);
+  T result = w ? w->average() : averageSinceUnlocked(channel, (int64_t)millis() - windowMs);
+  unlock();
+  return result;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::maxOver(size_t channel, int64_t windowMs) {
+  lock();
+  SlidingWindow<T, S> *w = window(channel, windowMs);
+  T result = w ? w->max() : maxSinceUnlocked(channel, (int64_t)millis() - windowMs);
+  unlock();
+  return result;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::minOver(size_t channel, int64_t windowMs) {
+  lock();
+  SlidingWindow<T, S> *w = window(channel, windowMs);
+  T result = w ? w->min() : minSinceUnlocked(channel, (int64_t)millis() - windowMs);
+  unlock();
+  return result;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+template<typename F>
+void MultiChannelBuffer<T, S, C, W>::walk(size_t channel, F &&visitor) const {
+  const T *column = columns[channel];
+  size_t index = headIndex;
+  for (size_t i = 0; i < count; i++) { // going backward to go from newest to oldest
+    if (!visitor(column[index], bufferTimestamp[index])) {
+      return;
+    }
+    index = (index == 0) ? S - 1 : index - 1; // wrap around
+  }
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+template<typename F>
+void MultiChannelBuffer<T, S, C, W>::walkSince(size_t channel, int64_t cutoffMs, F &&visitor) const {
+  walk(channel, [&visitor, cutoffMs](T value, int64_t ms) {
+    if (ms < cutoffMs) {
+      return false;
+    }
+    visitor(value, ms);
+    return true;
+  });
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+template<typename F>
+void MultiChannelBuffer<T, S, C, W>::visitSamples(size_t channel, F &&visitor) {
+  lock();
+  walk(channel, visitor);
+  unlock();
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+template<typename F>
+void MultiChannelBuffer<T, S, C, W>::visitSamplesSince(size_t channel, int64_t cutoffMs, F &&visitor) {
+  lock();
+  walkSince(channel, cutoffMs, visitor);
+  unlock();
+}
+
+// Timestamps are shared by all channels, so the count needs no channel
+template<typename T, size_t S, size_t C, size_t W>
+size_t MultiChannelBuffer<T, S, C, W>::countSince(int64_t cutoffMs) const {
+  size_t sampleCount = 0;
+  size_t index = headIndex;
+  for (size_t i = 0; i < count && bufferTimestamp[index] >= cutoffMs; i++) {
+    sampleCount += 1;
+    index = (index == 0) ? S - 1 : index - 1;
+  }
+  return sampleCount;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::averageSinceUnlocked(size_t channel, int64_t cutoffMs) const {
+  size_t sampleCount = 0;
+  double sum = 0;
+  walkSince(channel, cutoffMs, [&sum, &sampleCount](T value, int64_t) {
+    sum += value;
+    sampleCount += 1;
+  });
+
+  return sampleCount > 0 ? (T)(sum / sampleCount) : 0;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::maxSinceUnlocked(size_t channel, int64_t cutoffMs) const {
+  T max = 0;
+  bool isFirst = true;
+
+  walkSince(channel, cutoffMs, [&max, &isFirst](T value, int64_t) {
+    if (isFirst || value > max) {
+      max = value;
+      isFirst = false;
+    }
+  });
+
+  return max;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::minSinceUnlocked(size_t channel, int64_t cutoffMs) const {
+  T min = 0;
+  bool isFirst = true;
+
+  walkSince(channel, cutoffMs, [&min, &isFirst](T value, int64_t) {
+    if (isFirst || value < min) {
+      min = value;
+      isFirst = false;
+    }
+  });
+
+  return min;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+size_t MultiChannelBuffer<T, S, C, W>::countSamplesSince(int64_t cutoffMs) {
+  lock();
+  size_t result = countSince(cutoffMs);
+  unlock();
+  return result;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::averageSince(size_t channel, int64_t cutoffMs) {
+  lock();
+  T result = averageSinceUnlocked(channel, cutoffMs);
+  unlock();
+  return result;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::maxSince(size_t channel, int64_t cutoffMs) {
+  lock();
+  T result = maxSinceUnlocked(channel, cutoffMs);
+  unlock();
+  return result;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::minSince(size_t channel, int64_t cutoffMs) {
+  lock();
+  T result = minSinceUnlocked(channel, cutoffMs);
+  unlock();
+  return result;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::firstValueOlderThan(size_t channel, int64_t cutoffMs) {
+  T found = 0;
+  lock();
+  walk(channel, [&found, cutoffMs](T value, int64_t ms) {
+    if (ms < cutoffMs) {
+      found = value;
+      return false;
+    }
+    return true;
+  });
+  unlock();
+  return found;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+T MultiChannelBuffer<T, S, C, W>::latest(size_t channel) const {
+  return count > 0 ? columns[channel][headIndex] : 0;
+}
+
+template<typename T, size_t S, size_t C, size_t W>
+int64_t MultiChannelBuffer<T, S, C, W>::latestTimestamp() const {
+  return count > 0 ? bufferTimestamp[headIndex] : 0;
+}
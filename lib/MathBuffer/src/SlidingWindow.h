@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Running statistics over the samples of a ring buffer that are younger than
+// a fixed window length. The window does not own any samples: it keeps the
+// index of its oldest sample, a running sum and two monotonic deques of ring
+// indices (ascending values for min, descending for max), so count, average,
+// min and max are all O(1) and each sample enters and leaves every deque once.
+//
+// The owning buffer must call expire() before it overwrites a slot and add()
+// after it wrote a new sample.
+template<typename T, size_t S> class SlidingWindow {
+public:
+	constexpr SlidingWindow();
+
+	void attach(const T *values, const int64_t *timestamps, int64_t windowMs);
+	int64_t length() const { return windowMs; }
+
+	void add(size_t index);
+	// Drop samples older than nowMs - length, and the oldest ones while more
+	// than maxCount samples are in the window.
+	void expire(int64_t nowMs, size_t maxCount);
+
+	size_t count() const { return windowCount; }
+	T average() const;
+	T min() const;
+	T max() const;
+
+private:
+	static_assert(S <= 65535, "window deques store 16-bit ring indices");
+
+	struct IndexDeque {
+		uint16_t items[S];
+		size_t front = 0;
+		size_t size = 0;
+
+		bool empty() const { return size == 0; }
+		uint16_t first() const { return items[front]; }
+		uint16_t last() const { return items[(front + size - 1) % S]; }
+		void pushBack(size_t index) { items[(front + size) % S] = (uint16_t)index; size++; }
+		void popBack() { size--; }
+		void popFront() { front = (front + 1) % S; size--; }
+		void clear() { front = 0; size = 0; }
+	};
+
+	const T *values;
+	const int64_t *timestamps;
+	int64_t windowMs;
+
+	double sum;
+	size_t tailIndex;
+	size_t windowCount;
+	IndexDeque minQueue;
+	IndexDeque maxQueue;
+};
+
+#include "SlidingWindow.tpp"
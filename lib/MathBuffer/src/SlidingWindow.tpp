@@ -0,0 +1,81 @@
+#include "SlidingWindow.h"
+
+template<typename T, size_t S>
+constexpr SlidingWindow<T,S>::SlidingWindow() :
+		values(nullptr), timestamps(nullptr), windowMs(0),
+		sum(0), tailIndex(0), windowCount(0), minQueue(), maxQueue() {
+}
+
+template<typename T, size_t S>
+void SlidingWindow<T, S>::attach(const T *valueColumn, const int64_t *timestampColumn, int64_t lengthMs) {
+  values = valueColumn;
+  timestamps = timestampColumn;
+  windowMs = lengthMs;
+  sum = 0;
+  windowCount = 0;
+  minQueue.clear();
+  maxQueue.clear();
+}
+
+template<typename T, size_t S>
+void SlidingWindow<T, S>::add(size_t index) {
+  T value = values[index];
+  if (windowCount == 0) {
+    tailIndex = index;
+  }
+  windowCount += 1;
+  sum += value;
+
+  while (!minQueue.empty() && values[minQueue.last()] >= value) {
+    minQueue.popBack();
+  }
+  minQueue.pushBack(index);
+
+  while (!maxQueue.empty() && values[maxQueue.last()] <= value) {
+    maxQueue.popBack();
+  }
+  maxQueue.pushBack(index);
+}
+
+template<typename T, size_t S>
+void SlidingWindow<T, S>::expire(int64_t nowMs, size_t maxCount) {
+  int64_t cutoffMs = nowMs - windowMs;
+  while (windowCount > 0 && (windowCount > maxCount || timestamps[tailIndex] < cutoffMs)) {
+    sum -= values[tailIndex];
+    if (!minQueue.empty() && minQueue.first() == tailIndex) {
+      minQueue.popFront();
+    }
+    if (!maxQueue.empty() && maxQueue.first() == tailIndex) {
+      maxQueue.popFront();
+    }
+    tailIndex += 1;
+    if (tailIndex >= S) {
+      tailIndex = 0;
+    }
+    windowCount -= 1;
+  }
+
+  if (windowCount == 0) {
+    sum = 0; // do not carry rounding error into the next run of samples
+    minQueue.clear();
+    maxQueue.clear();
+  }
+}
+
+template<typename T, size_t S>
+T SlidingWindow<T, S>::average() const {
+  if (windowCount == 0) {
+    return 0;
+  }
+  return (T)(sum / windowCount);
+}
+
+template<typename T, size_t S>
+T SlidingWindow<T, S>::min() const {
+  return minQueue.empty() ? 0 : values[minQueue.first()];
+}
+
+template<typename T, size_t S>
+T SlidingWindow<T, S>::max() const {
+  return maxQueue.empty() ? 0 : values[maxQueue.first()];
+}
@@ -0,0 +1,145 @@
+#include "RelayCharacterizer.h"
+#include <math.h>
+
+// Samples averaged for the settled weight at the end of a pulse
+static const size_t SETTLED_SAMPLES = 3;
+// Below this spread of flows the slope of the fit is meaningless
+static const float MIN_FLOW_SPREAD_GPS = 0.3f;
+static const float LATENCY_MIN_S = 0.0f;
+static const float LATENCY_MAX_S = 2.0f;
+
+RelayCharacterizer::RelayCharacterizer() :
+    pulses(), count(0), active(false), cut(false), sampleTimes(), sampleGrams(), samples(0), overflowed(false) {
+}
+
+void RelayCharacterizer::reset() {
+  count = 0;
+  active = false;
+}
+
+void RelayCharacterizer::beginPulse(uint32_t onMs) {
+  if (count >= MAX_PULSES) return;
+  pulses[count] = RelayPulse();
+  pulses[count].onMs = onMs;
+  samples = 0;
+  overflowed = false;
+  cut = false;
+  active = true;
+}
+
+void RelayCharacterizer::relayOff(uint32_t offMs) {
+  if (!active) return;
+  pulses[count].offMs = offMs;
+  cut = true;
+}
+
+void RelayCharacterizer::addSample(uint32_t timestampMs, float grams) {
+  if (!active) return;
+  if (samples >= MAX_SAMPLES) {
+    overflowed = true;
+    return;
+  }
+  sampleTimes[samples] = timestampMs;
+  sampleGrams[samples] = grams;
+  samples++;
+}
+
+const RelayPulse &RelayCharacterizer::endPulse() {
+  RelayPulse &result = pulses[count < MAX_PULSES ? count : MAX_PULSES - 1];
+  if (!active) return result;
+  active = false;
+  if (!cut || overflowed) {
+    result.valid = false;
+    return result;
+  }
+  analyse(result);
+  count++;
+  return result;
+}
+
+void RelayCharacterizer::analyse(RelayPulse &result) const {
+  result.valid = false;
+
+  // Last sample at or before the cut, as GrindPredictor::markStopped() sees it
+  size_t last = samples;
+  for (size_t i = 0; i < samples; i++) {
+    if ((int32_t)(sampleTimes[i] - result.offMs) <= 0) last = i;
+  }
+  if (last == samples || samples - last - 1 < SETTLED_SAMPLES) return;
+  result.weightAtOffG = sampleGrams[last];
+
+  // Flow: least-squares slope over the flow window ending at that sample
+  float sumT = 0, sumG = 0, sumTT = 0, sumTG = 0;
+  size_t n = 0;
+  for (size_t i = 0; i <= last; i++) {
+    uint32_t age = sampleTimes[last] - sampleTimes[i];
+    if (age > FLOW_WINDOW_MS) continue;
+    float t = -(float)age / 1000.0f;
+    float g = sampleGrams[i] - result.weightAtOffG;
+    sumT += t;
+    sumG += g;
+    sumTT += t * t;
+    sumTG += t * g;
+    n++;
+  }
+  if (n < 3) return;
+  float denominator = n * sumTT - sumT * sumT;
+  result.flowAtOffGps = denominator > 1e-6f ? (n * sumTG - sumT * sumG) / denominator : 0;
+  if (result.flowAtOffGps < 0) result.flowAtOffGps = 0;
+
+  float settled = 0;
+  for (size_t i = samples - SETTLED_SAMPLES; i < samples; i++) settled += sampleGrams[i];
+  result.settledG = settled / SETTLED_SAMPLES;
+  result.overshootG = result.settledG - result.weightAtOffG;
+
+  result.coastMs = 0;
+  for (size_t i = last + 1; i < samples; i++) {
+    if (sampleGrams[i] >= result.settledG - COAST_TOLERANCE_G) {
+      result.coastMs = sampleTimes[i] - result.offMs;
+      break;
+    }
+  }
+  result.valid = true;
+}
+
+RelayFit RelayCharacterizer::fit(float fallbackLatencyS) const {
+  RelayFit result = {false, false, fallbackLatencyS, 0, 0, 0};
+  float sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+  float minX = 0, maxX = 0;
+  size_t n = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!pulses[i].valid) continue;
+    float x = pulses[i].flowAtOffGps;
+    float y = pulses[i].overshootG;
+    if (n == 0 || x < minX) minX = x;
+    if (n == 0 || x > maxX) maxX = x;
+    sumX += x;
+    sumY += y;
+    sumXX += x * x;
+    sumXY += x * y;
+    n++;
+  }
+  if (n == 0) return result;
+  result.pulses = n;
+
+  float denominator = n * sumXX - sumX * sumX;
+  if (n >= 2 && maxX - minX >= MIN_FLOW_SPREAD_GPS && denominator > 1e-6f) {
+    float slope = (n * sumXY - sumX * sumY) / denominator;
+    if (slope >= LATENCY_MIN_S && slope <= LATENCY_MAX_S) {
+      result.latencyS = slope;
+      result.latencyFitted = true;
+    }
+  }
+  // With the latency fixed, the in-flight mass is the mean remaining overshoot
+  result.inFlightG = (sumY - result.latencyS * sumX) / n;
+
+  float squares = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!pulses[i].valid) continue;
+    float error = pulses[i].overshootG - (pulses[i].flowAtOffGps * result.latencyS + result.inFlightG);
+    squares += error * error;
+  }
+  result.rmsErrorG = sqrtf(squares / n);
+  result.valid = true;
+  return result;
+}
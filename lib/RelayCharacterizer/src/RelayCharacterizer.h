@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Relay + motor characterisation from short grind pulses.
+//
+// Each pulse switches the grinder on for a known time and records the
+// weight response. At the moment the relay is cut the flow is estimated
+// the same way GrindPredictor does (least-squares slope over its flow
+// window), and the overshoot is what still lands on the scale afterwards:
+//
+//     overshoot = settled - weightAtOff = flowAtOff * latencyS + inFlightG
+//
+// Pulses of different lengths cut at different flows, so a straight-line
+// fit over the pulses gives the predictor's latency and in-flight mass
+// directly. The time from cut-off until the weight stops rising is reported
+// as well (coast time), as a sanity check on the fitted latency.
+//
+// Plain C++ without Arduino dependencies; the device drives it from the
+// scale task (samples) and a serial command (pulses).
+struct RelayPulse {
+	uint32_t onMs;
+	uint32_t offMs;
+	float weightAtOffG;   // last sample at or before the cut
+	float flowAtOffGps;   // flow estimate at the cut
+	float settledG;       // mean of the last samples of the pulse
+	float overshootG;     // settled - weightAtOff
+	uint32_t coastMs;     // cut to the first sample within COAST_TOLERANCE_G of settled
+	bool valid;           // enough samples before the cut and after it, none dropped
+};
+
+struct RelayFit {
+	bool valid;
+	bool latencyFitted;   // false: flows too similar, latency kept and only in-flight fitted
+	float latencyS;
+	float inFlightG;
+	float rmsErrorG;      // residual of the fit over the valid pulses
+	size_t pulses;        // valid pulses used
+};
+
+class RelayCharacterizer {
+public:
+	static constexpr size_t MAX_PULSES = 8;
+	// Per pulse, pulse plus settle time: the scale samples at 80 SPS during the
+	// test, so 384 is 4.8 s. A pulse that overflows it is invalid, its tail
+	// (and the settled weight) would be missing.
+	static constexpr size_t MAX_SAMPLES = 384;
+	static constexpr uint32_t FLOW_WINDOW_MS = 600;  // same as GrindPredictor
+	static constexpr float COAST_TOLERANCE_G = 0.1f;
+
+	RelayCharacterizer();
+
+	void reset();
+	// Pulse protocol: beginPulse() before the relay goes on, relayOff() when
+	// it was cut, endPulse() once the weight has settled
+	void beginPulse(uint32_t onMs);
+	void relayOff(uint32_t offMs);
+	const RelayPulse &endPulse();
+	void addSample(uint32_t timestampMs, float grams);
+	bool collecting() const { return active; }
+
+	size_t pulseCount() const { return count; }
+	const RelayPulse &pulse(size_t index) const { return pulses[index]; }
+
+	// Least-squares fit over the valid pulses. fallbackLatencyS is used when
+	// the pulses do not spread the flow enough to separate the two terms.
+	RelayFit fit(float fallbackLatencyS) const;
+
+private:
+	void analyse(RelayPulse &result) const;
+
+	RelayPulse pulses[MAX_PULSES];
+	size_t count;
+
+	bool active;
+	bool cut;
+	uint32_t sampleTimes[MAX_SAMPLES];
+	float sampleGrams[MAX_SAMPLES];
+	size_t samples;
+	bool overflowed;
+};
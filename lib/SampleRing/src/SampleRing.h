@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <type_traits>
+
+// Lock-free single-producer / single-consumer ring. The producer (acquisition
+// task) only writes `writeIndex`, the consumer (scale task) only writes
+// `readIndex`, so no locking is needed between exactly one of each.
+// S must be a power of two; one slot is never used to tell full from empty.
+template<typename T, size_t S> class SampleRing {
+public:
+	constexpr SampleRing();
+
+	static constexpr size_t capacity = S - 1;
+
+	bool push(const T &value);   // producer side, false (and counted) if full
+	bool pop(T &value);          // consumer side, false if empty
+
+	size_t size() const;
+	bool empty() const;
+	uint32_t dropped() const;
+
+private:
+	static_assert(S >= 2 && (S & (S - 1)) == 0, "S must be a power of two");
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+	T buffer[S];
+
+	std::atomic<size_t> writeIndex;
+	std::atomic<size_t> readIndex;
+	std::atomic<uint32_t> droppedCount;
+};
+
+#include "SampleRing.tpp"
@@ -0,0 +1,49 @@
+#include "SampleRing.h"
+
+template<typename T, size_t S>
+constexpr SampleRing<T,S>::SampleRing() :
+    buffer(), writeIndex(0), readIndex(0), droppedCount(0) {
+}
+
+template<typename T, size_t S>
+bool SampleRing<T, S>::push(const T &value) {
+  size_t head = writeIndex.load(std::memory_order_relaxed);
+  size_t next = (head + 1) & (S - 1);
+  if (next == readIndex.load(std::memory_order_acquire)) {
+    droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return false; // consumer fell behind, keep the older samples
+  }
+
+  buffer[head] = value;
+  writeIndex.store(next, std::memory_order_release);
+  return true;
+}
+
+template<typename T, size_t S>
+bool SampleRing<T, S>::pop(T &value) {
+  size_t tail = readIndex.load(std::memory_order_relaxed);
+  if (tail == writeIndex.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  value = buffer[tail];
+  readIndex.store((tail + 1) & (S - 1), std::memory_order_release);
+  return true;
+}
+
+template<typename T, size_t S>
+size_t SampleRing<T, S>::size() const {
+  size_t head = writeIndex.load(std::memory_order_acquire);
+  size_t tail = readIndex.load(std::memory_order_acquire);
+  return (head - tail) & (S - 1);
+}
+
+template<typename T, size_t S>
+bool SampleRing<T, S>::empty() const {
+  return size() == 0;
+}
+
+template<typename T, size_t S>
+uint32_t SampleRing<T, S>::dropped() const {
+  return droppedCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,147 @@
+#include "StabilityDetector.h"
+#include <math.h>
+
+// Noise floor tracking per evaluated sample: follows quieter windows quickly,
+// noisier ones only while stable and slowly
+static const float FLOOR_DOWN_ALPHA = 1.0f / 8.0f;
+static const float FLOOR_UP_ALPHA = 1.0f / 64.0f;
+
+StabilityDetector::StabilityDetector() : StabilityDetector(StabilityConfig{1000, 500, 3, 0.01f, 0.1f, 0.1f, 3.0f}) {
+}
+
+StabilityDetector::StabilityDetector(const StabilityConfig &config) :
+    cfg(config), times(), values(), head(0), size(0), sinceRebuild(0), baseMs(0), baseValue(0), sumT(0), sumX(0),
+    sumTT(0), sumTX(0), sumXX(0), floor(0), isStable(false), stableSince(0) {
+  configure(config);
+}
+
+void StabilityDetector::configure(const StabilityConfig &config) {
+  cfg = config;
+  if (cfg.minSamples < 2) cfg.minSamples = 2;
+  if (cfg.noiseFactor <= 0) cfg.noiseFactor = 1;
+  // Start permissive, tighten as quiet windows are seen
+  floor = cfg.maxStdDev / cfg.noiseFactor;
+  reset();
+}
+
+void StabilityDetector::reset() {
+  head = 0;
+  size = 0;
+  isStable = false;
+  rebuild();
+}
+
+size_t StabilityDetector::indexOf(size_t age) const {
+  return (head + MAX_SAMPLES - size + age) % MAX_SAMPLES;
+}
+
+void StabilityDetector::accumulate(size_t index, double sign) {
+  double t = (int32_t)(times[index] - baseMs) / 1000.0;
+  double x = values[index] - baseValue;
+  sumT += sign * t;
+  sumX += sign * x;
+  sumTT += sign * t * t;
+  sumTX += sign * t * x;
+  sumXX += sign * x * x;
+}
+
+// Re-bases the sums on the oldest sample and recomputes them, so rounding
+// from adding and removing does not build up
+void StabilityDetector::rebuild() {
+  sumT = sumX = sumTT = sumTX = sumXX = 0;
+  sinceRebuild = 0;
+  if (size == 0) return;
+  baseMs = times[indexOf(0)];
+  baseValue = values[indexOf(0)];
+  for (size_t age = 0; age < size; age++) accumulate(indexOf(age), 1);
+}
+
+bool StabilityDetector::push(uint32_t timestampMs, float value) {
+  if (size > 0 && (int32_t)(timestampMs - times[indexOf(size - 1)]) < 0) reset();
+
+  while (size > 0 && (size == MAX_SAMPLES || timestampMs - times[indexOf(0)] > cfg.windowMs)) {
+    accumulate(indexOf(0), -1);
+    size--;
+  }
+  if (size == 0) {
+    baseMs = timestampMs;
+    baseValue = value;
+  }
+  times[head] = timestampMs;
+  values[head] = value;
+  accumulate(head, 1);
+  head = (head + 1) % MAX_SAMPLES;
+  size++;
+  if (++sinceRebuild >= MAX_SAMPLES) rebuild();
+
+  evaluate();
+  return isStable;
+}
+
+void StabilityDetector::evaluate() {
+  bool wasStable = isStable;
+  isStable = false;
+  if (size < cfg.minSamples || spanMs() < cfg.minSpanMs) return;
+
+  float deviation = stdDev();
+  float allowed = limit();
+  bool flat = fabsf(slope()) <= cfg.maxSlope;
+  isStable = deviation <= allowed && flat;
+
+  if (deviation < floor) {
+    floor += FLOOR_DOWN_ALPHA * (deviation - floor);
+  } else if (isStable) {
+    floor += FLOOR_UP_ALPHA * (deviation - floor);
+  }
+  float lowest = cfg.minStdDev / cfg.noiseFactor;
+  float highest = cfg.maxStdDev / cfg.noiseFactor;
+  floor = floor < lowest ? lowest : (floor > highest ? highest : floor);
+
+  if (isStable && !wasStable) stableSince = times[indexOf(size - 1)];
+}
+
+uint32_t StabilityDetector::spanMs() const {
+  if (size < 2) return 0;
+  return times[indexOf(size - 1)] - times[indexOf(0)];
+}
+
+float StabilityDetector::mean() const {
+  if (size == 0) return 0;
+  return (float)(baseValue + sumX / size);
+}
+
+float StabilityDetector::stdDev() const {
+  if (size < 2) return 0;
+  double variance = (sumXX - sumX * sumX / size) / (size - 1);
+  return variance > 0 ? (float)sqrt(variance) : 0;
+}
+
+float StabilityDetector::slope() const {
+  if (size < 2) return 0;
+  double denominator = size * sumTT - sumT * sumT;
+  if (denominator <= 0) return 0;
+  return (float)((size * sumTX - sumT * sumX) / denominator);
+}
+
+float StabilityDetector::limit() const {
+  float allowed = cfg.noiseFactor * floor;
+  return allowed < cfg.minStdDev ? cfg.minStdDev : (allowed > cfg.maxStdDev ? cfg.maxStdDev : allowed);
+}
+
+uint32_t StabilityDetector::stableForMs() const {
+  if (!isStable) return 0;
+  return times[indexOf(size - 1)] - stableSince;
+}
+
+StabilityState StabilityDetector::state() const {
+  StabilityState s;
+  s.stable = isStable;
+  s.count = size;
+  s.spanMs = spanMs();
+  s.mean = mean();
+  s.stdDev = stdDev();
+  s.slope = slope();
+  s.limit = limit();
+  s.stableForMs = stableForMs();
+  return s;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Incremental stability detector
+//
+// Keeps the samples of the last windowMs and running sums over them, so the
+// mean, standard deviation and least-squares slope of the window cost a few
+// additions per sample instead of a pass over a history buffer. The window is
+// stable when it spans at least minSpanMs with minSamples samples, the
+// standard deviation is within the limit and the slope within maxSlope.
+//
+// The limit follows the noise floor of the signal: the detector learns the
+// standard deviation of quiet windows (quickly downwards, slowly upwards
+// while stable) and allows noiseFactor times that, clamped to
+// [minStdDev, maxStdDev]. So a quiet load cell is not reported stable while
+// it still creeps by a fraction of a gram, and a noisy one is not held back
+// by a threshold tuned for a quiet one. reset() drops the samples but keeps
+// the learned floor.
+//
+// At most MAX_SAMPLES samples are kept; at high sample rates the oldest ones
+// leave before windowMs has passed.
+//
+// Plain C++ without Arduino dependencies, no heap.
+struct StabilityConfig {
+	uint32_t windowMs;
+	uint32_t minSpanMs;   // window must cover this long to be stable
+	uint32_t minSamples;
+	float minStdDev;      // bounds of the noise-scaled limit
+	float maxStdDev;
+	float maxSlope;       // units per second
+	float noiseFactor;    // limit = noiseFactor * learned noise floor
+};
+
+struct StabilityState {
+	bool stable;
+	uint32_t count;
+	uint32_t spanMs;
+	float mean;
+	float stdDev;
+	float slope;          // units per second
+	float limit;          // standard deviation allowed right now
+	uint32_t stableForMs; // 0 unless stable
+};
+
+class StabilityDetector {
+public:
+	static constexpr size_t MAX_SAMPLES = 96;
+
+	StabilityDetector();
+	explicit StabilityDetector(const StabilityConfig &config);
+
+	// New parameters; drops the samples and the learned noise floor
+	void configure(const StabilityConfig &config);
+	// Drops the samples (after a tare or an offset change)
+	void reset();
+	// Returns stable() after the sample; a timestamp before the previous
+	// one restarts the window
+	bool push(uint32_t timestampMs, float value);
+
+	bool stable() const { return isStable; }
+	uint32_t count() const { return size; }
+	uint32_t spanMs() const;
+	float mean() const;
+	float stdDev() const;
+	float slope() const;
+	float limit() const;
+	float noiseFloor() const { return floor; }
+	uint32_t stableForMs() const;
+	StabilityState state() const;
+
+private:
+	size_t indexOf(size_t age) const; // 0 = oldest
+	void accumulate(size_t index, double sign);
+	void rebuild();
+	void evaluate();
+
+	StabilityConfig cfg;
+	uint32_t times[MAX_SAMPLES];
+	float values[MAX_SAMPLES];
+	size_t head;          // next slot to write
+	size_t size;
+	size_t sinceRebuild;
+
+	// Sums relative to the base sample, in seconds and units. Doubles, since
+	// 0.01 g of noise under a few hundred grams cancels out in float sums.
+	uint32_t baseMs;
+	float baseValue;
+	double sumT, sumX, sumTT, sumTX, sumXX;
+
+	float floor;
+	bool isStable;
+	uint32_t stableSince;
+};
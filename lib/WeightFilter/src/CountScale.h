@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+// HX711 counts to milligrams in integer arithmetic
+//
+// The calibration factor (counts per gram) is turned into a fixed-point
+// reciprocal once, so every sample costs one 32x32->64 multiply and a shift
+// instead of a double-precision divide, which the ESP32 does in software.
+// With SHIFT = 24 and factors of a few hundred to a few thousand counts per
+// gram the reciprocal keeps better than 1e-6 relative precision, and a full
+// scale 24-bit reading times the reciprocal stays well inside 64 bits.
+//
+// Below about 8 counts per gram the reciprocal no longer fits 31 bits and
+// the product could overflow 64 bits for large counts; those factors take a
+// double divide instead. Results beyond the int32 range (e.g. a full scale
+// reading at less than about 4 counts per gram) saturate at INT32_MIN/MAX.
+//
+// Plain C++ without Arduino dependencies.
+class CountScale {
+public:
+	static constexpr int SHIFT = 24;
+
+	CountScale() : factor(0), reciprocal(0), wide(false) {}
+
+	// Recomputes the reciprocal only when the factor changed; returns true
+	// if it did. Non-positive factors give 0 mg for every reading.
+	bool setFactor(double countsPerGram) {
+		if (countsPerGram == factor) return false;
+		factor = countsPerGram;
+		double exact = countsPerGram > 0 ? 1000.0 * (double)(1LL << SHIFT) / countsPerGram : 0;
+		reciprocal = exact < (double)INT32_MAX ? (int64_t)(exact + 0.5) : 0;
+		wide = exact >= (double)INT32_MAX;
+		return true;
+	}
+
+	// Rounded to the nearest milligram, half up
+	int32_t toMg(int32_t counts) const {
+		int64_t mg;
+		if (wide) {
+			mg = (int64_t)floor((double)counts * 1000.0 / factor + 0.5);
+		} else {
+			mg = ((int64_t)counts * reciprocal + (1LL << (SHIFT - 1))) >> SHIFT;
+		}
+		if (mg > INT32_MAX) return INT32_MAX;
+		if (mg < INT32_MIN) return INT32_MIN;
+		return (int32_t)mg;
+	}
+
+	double countsPerGram() const { return factor; }
+
+private:
+	double factor;
+	int64_t reciprocal;   // milligrams per count, Q(SHIFT)
+	bool wide;            // reciprocal too large, divide instead
+};
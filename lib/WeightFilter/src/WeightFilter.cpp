@@ -0,0 +1,237 @@
+#include "WeightFilter.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Weight of the newest sample in the running metrics (~32 sample memory)
+static const float METRIC_ALPHA = 1.0f / 32.0f;
+static const float PI_F = 3.14159265f;
+
+struct FilterInfo {
+  FilterType type;
+  const char *name;
+  size_t paramCount;
+  float defaults[3];
+};
+
+static const FilterInfo FILTERS[] = {
+  {FILTER_NONE, "none", 0, {0, 0, 0}},
+  {FILTER_KALMAN, "kalman", 3, {0.5f, 0.01f, 0.01f}},
+  {FILTER_MEDIAN, "median", 1, {5, 0, 0}},
+  {FILTER_AVERAGE, "average", 1, {8, 0, 0}},
+  {FILTER_ONE_EURO, "euro", 3, {1.0f, 0.05f, 1.0f}},
+};
+static const size_t FILTER_COUNT = sizeof(FILTERS) / sizeof(FILTERS[0]);
+
+static const FilterInfo &info(FilterType type) {
+  for (size_t i = 0; i < FILTER_COUNT; i++) {
+    if (FILTERS[i].type == type) return FILTERS[i];
+  }
+  return FILTERS[0];
+}
+
+FilterStage::FilterStage() :
+    kind(FILTER_NONE), p(), estimate(0), estimateError(0), window(), windowSize(0), windowHead(0),
+    windowCount(0), windowSum(0), euroValue(0), euroDerivative(0), euroLastMs(0), euroStarted(false) {
+}
+
+const char *FilterStage::typeName(FilterType type) {
+  return info(type).name;
+}
+
+bool FilterStage::configure(FilterType type, const float *params, size_t paramCount) {
+  const FilterInfo &filter = info(type);
+  float values[3];
+  for (size_t i = 0; i < 3; i++) values[i] = i < paramCount ? params[i] : filter.defaults[i];
+
+  switch (type) {
+    case FILTER_KALMAN:
+      if (values[0] <= 0 || values[1] <= 0 || values[2] < 0) return false;
+      break;
+    case FILTER_MEDIAN:
+      if (values[0] < 1 || values[0] > MAX_MEDIAN || ((int)values[0] % 2) == 0) return false;
+      break;
+    case FILTER_AVERAGE:
+      if (values[0] < 1 || values[0] > MAX_WINDOW) return false;
+      break;
+    case FILTER_ONE_EURO:
+      if (values[0] <= 0 || values[1] < 0 || values[2] <= 0) return false;
+      break;
+    default:
+      break;
+  }
+  kind = type;
+  memcpy(p, values, sizeof(p));
+  windowSize = (type == FILTER_MEDIAN || type == FILTER_AVERAGE) ? (size_t)values[0] : 0;
+  reset(0);
+  return true;
+}
+
+void FilterStage::reset(float value) {
+  estimate = value;
+  estimateError = p[1];
+  for (size_t i = 0; i < windowSize; i++) window[i] = value;
+  windowHead = 0;
+  windowCount = windowSize;
+  windowSum = value * windowSize;
+  euroValue = value;
+  euroDerivative = 0;
+  euroStarted = false;
+}
+
+float FilterStage::median() const {
+  float sorted[MAX_MEDIAN];
+  for (size_t i = 0; i < windowCount; i++) {
+    // Insertion sort, at most 9 elements
+    float value = window[i];
+    size_t j = i;
+    while (j > 0 && sorted[j - 1] > value) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = value;
+  }
+  return sorted[windowCount / 2];
+}
+
+float FilterStage::update(uint32_t timestampMs, float value) {
+  switch (kind) {
+    case FILTER_KALMAN: {
+      float gain = estimateError / (estimateError + p[0]);
+      float next = estimate + gain * (value - estimate);
+      estimateError = (1.0f - gain) * estimateError + fabsf(estimate - next) * p[2];
+      estimate = next;
+      return estimate;
+    }
+    case FILTER_MEDIAN:
+    case FILTER_AVERAGE: {
+      windowSum += value - window[windowHead];
+      window[windowHead] = value;
+      windowHead = (windowHead + 1) % windowSize;
+      if (kind == FILTER_MEDIAN) return median();
+      return windowSum / windowSize;
+    }
+    case FILTER_ONE_EURO: {
+      float dt = euroStarted ? (timestampMs - euroLastMs) / 1000.0f : 0;
+      euroLastMs = timestampMs;
+      euroStarted = true;
+      if (dt <= 0) dt = 0.1f; // first sample or duplicate timestamp
+      // Smoothing factor of a first-order low pass with the given cutoff
+      float derivativeTau = 1.0f / (2 * PI_F * p[2]);
+      float derivativeAlpha = 1.0f / (1.0f + derivativeTau / dt);
+      euroDerivative += derivativeAlpha * ((value - euroValue) / dt - euroDerivative);
+      float cutoff = p[0] + p[1] * fabsf(euroDerivative);
+      float tau = 1.0f / (2 * PI_F * cutoff);
+      euroValue += (1.0f / (1.0f + tau / dt)) * (value - euroValue);
+      return euroValue;
+    }
+    default:
+      return value;
+  }
+}
+
+int FilterStage::describe(char *buffer, size_t size) const {
+  const FilterInfo &filter = info(kind);
+  int written = snprintf(buffer, size, "%s", filter.name);
+  for (size_t i = 0; i < filter.paramCount && written >= 0 && (size_t)written < size; i++) {
+    written += snprintf(buffer + written, size - written, "%c%g", i == 0 ? ':' : ',', (double)p[i]);
+  }
+  return written;
+}
+
+FilterPipeline::FilterPipeline() :
+    stages(), stageMetrics(), metricMean(), metricVariance(), count(0), micros(nullptr) {
+}
+
+bool FilterPipeline::configure(const char *spec) {
+  FilterStage parsed[MAX_STAGES];
+  size_t parsedCount = 0;
+  const char *cursor = spec;
+  while (*cursor) {
+    while (*cursor == ' ') cursor++;
+    if (!*cursor) break;
+    if (parsedCount == MAX_STAGES) return false;
+
+    // Stage name up to ':' or the end of the token
+    const char *nameEnd = cursor;
+    while (*nameEnd && *nameEnd != ':' && *nameEnd != ' ') nameEnd++;
+    const FilterInfo *filter = nullptr;
+    for (size_t i = 0; i < FILTER_COUNT; i++) {
+      if (strlen(FILTERS[i].name) == (size_t)(nameEnd - cursor) &&
+          strncmp(FILTERS[i].name, cursor, nameEnd - cursor) == 0) {
+        filter = &FILTERS[i];
+      }
+    }
+    if (!filter) return false;
+    cursor = nameEnd;
+
+    float params[3];
+    size_t paramCount = 0;
+    if (*cursor == ':') {
+      do {
+        cursor++;
+        char *end;
+        float value = strtof(cursor, &end);
+        if (end == cursor || paramCount == 3) return false;
+        params[paramCount++] = value;
+        cursor = end;
+      } while (*cursor == ',');
+    }
+    if (*cursor && *cursor != ' ') return false;
+    if (!parsed[parsedCount++].configure(filter->type, params, paramCount)) return false;
+  }
+
+  for (size_t i = 0; i < parsedCount; i++) stages[i] = parsed[i];
+  count = parsedCount;
+  resetMetrics();
+  return true;
+}
+
+void FilterPipeline::reset(float value) {
+  for (size_t i = 0; i < count; i++) {
+    stages[i].reset(value);
+    metricMean[i] = value;
+  }
+}
+
+void FilterPipeline::resetMetrics() {
+  for (size_t i = 0; i < MAX_STAGES; i++) {
+    stageMetrics[i] = FilterStageMetrics();
+    metricMean[i] = 0;
+    metricVariance[i] = 0;
+  }
+}
+
+float FilterPipeline::update(uint32_t timestampMs, float value) {
+  for (size_t i = 0; i < count; i++) {
+    uint32_t started = micros ? micros() : 0;
+    float output = stages[i].update(timestampMs, value);
+    FilterStageMetrics &m = stageMetrics[i];
+    if (micros) {
+      m.lastUs = micros() - started;
+      if (m.lastUs > m.maxUs) m.maxUs = m.lastUs;
+    }
+    if (m.samples == 0) metricMean[i] = output;
+    float deviation = output - metricMean[i];
+    metricMean[i] += METRIC_ALPHA * deviation;
+    metricVariance[i] += METRIC_ALPHA * (deviation * deviation - metricVariance[i]);
+    m.noiseG = sqrtf(metricVariance[i]);
+    m.lagG += METRIC_ALPHA * ((value - output) - m.lagG);
+    m.samples++;
+    value = output;
+  }
+  return value;
+}
+
+int FilterPipeline::describe(char *buffer, size_t size) const {
+  if (size == 0) return 0;
+  buffer[0] = '\0';
+  int written = 0;
+  for (size_t i = 0; i < count && (size_t)written < size; i++) {
+    if (i > 0) written += snprintf(buffer + written, size - written, " ");
+    if ((size_t)written < size) written += stages[i].describe(buffer + written, size - written);
+  }
+  if (count == 0) written = snprintf(buffer, size, "none");
+  return written;
+}
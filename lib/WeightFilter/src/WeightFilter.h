@@ -0,0 +1,109 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Weight filter pipeline
+//
+// A pipeline is up to MAX_STAGES filter stages applied in order to the fused
+// weight. It is configured from a spec string, so profiles can live in
+// config.hpp, be changed over serial and be scored on a host with the same
+// parser:
+//
+//     "median:5 kalman:0.5,0.01,0.01"
+//
+// Stages and their parameters (defaults in brackets):
+//   kalman:<measurement error>,<estimate error>,<process noise> [0.5,0.01,0.01]
+//       same update as SimpleKalmanFilter(mea_e, est_e, q)
+//   median:<N> [5]       median of the last N samples (odd, <= 9), rejects spikes
+//   average:<N> [8]      moving average of the last N samples (<= 32)
+//   euro:<min cutoff Hz>,<beta>,<derivative cutoff Hz> [1.0,0.05,1.0]
+//       one-euro filter: smooth when still, cutoff rises with the speed of change
+//   none                 pass-through
+//
+// Each stage keeps running metrics: noise is the exponentially weighted
+// standard deviation of its output (the noise floor when the weight is
+// still), lag is the weighted mean of input minus output (how far it trails
+// a rising weight), and the compute time per sample when a clock is set.
+//
+// Plain C++ without Arduino dependencies, no heap.
+enum FilterType : uint8_t { FILTER_NONE, FILTER_KALMAN, FILTER_MEDIAN, FILTER_AVERAGE, FILTER_ONE_EURO };
+
+struct FilterStageMetrics {
+	uint32_t samples;
+	float noiseG;
+	float lagG;
+	uint32_t lastUs;
+	uint32_t maxUs;
+};
+
+class FilterStage {
+public:
+	static constexpr size_t MAX_WINDOW = 32;
+	static constexpr size_t MAX_MEDIAN = 9;
+
+	FilterStage();
+
+	// params may be shorter than the stage needs; missing ones take defaults.
+	// Returns false for out-of-range parameters.
+	bool configure(FilterType type, const float *params, size_t count);
+	void reset(float value);
+	float update(uint32_t timestampMs, float value);
+
+	FilterType type() const { return kind; }
+	static const char *typeName(FilterType type);
+	// Writes the stage back as spec text ("kalman:0.5,0.01,0.01")
+	int describe(char *buffer, size_t size) const;
+
+private:
+	float median() const;
+
+	FilterType kind;
+	float p[3];
+
+	// Kalman
+	float estimate;
+	float estimateError;
+	// Median / moving average
+	float window[MAX_WINDOW];
+	size_t windowSize;
+	size_t windowHead;
+	size_t windowCount;
+	float windowSum;
+	// One-euro
+	float euroValue;
+	float euroDerivative;
+	uint32_t euroLastMs;
+	bool euroStarted;
+};
+
+class FilterPipeline {
+public:
+	static constexpr size_t MAX_STAGES = 3;
+	typedef uint32_t (*MicrosClock)();
+
+	FilterPipeline();
+
+	// Parse and apply a spec; on error the current stages are kept
+	bool configure(const char *spec);
+	// Restart every stage at value (no ramp from zero after a tare or a
+	// profile switch)
+	void reset(float value);
+	float update(uint32_t timestampMs, float value);
+
+	size_t stageCount() const { return count; }
+	const FilterStage &stage(size_t index) const { return stages[index]; }
+	const FilterStageMetrics &metrics(size_t index) const { return stageMetrics[index]; }
+	void resetMetrics();
+	// Optional microsecond clock for the compute-time metric
+	void setClock(MicrosClock clock) { micros = clock; }
+
+	int describe(char *buffer, size_t size) const;
+
+private:
+	FilterStage stages[MAX_STAGES];
+	FilterStageMetrics stageMetrics[MAX_STAGES];
+	float metricMean[MAX_STAGES];
+	float metricVariance[MAX_STAGES];
+	size_t count;
+	MicrosClock micros;
+};
@@ -0,0 +1,257 @@
+#include "acquisition.hpp"
+#include "config.hpp"
+#include "soc/gpio_reg.h"
+
+// Interrupt-driven HX711 acquisition
+//
+// The HX711 pulls DOUT low when a conversion is ready. Instead of polling
+// wait_ready_timeout() we take a falling-edge interrupt on the primary DOUT,
+// timestamp it and wake the acquisition task, which clocks the data out and
+// pushes it into a lock-free ring. The scale task consumes the ring at its
+// own pace, so filtering/state logic never delays the next conversion.
+//
+// The task also owns the HX711 operating mode (RATE pin, power down), since
+// switching it touches the shared SCK line.
+
+TaskHandle_t AcquisitionTask = nullptr;
+
+static SampleRing<RawSample, ACQUISITION_RING_SIZE> sampleRing;
+static SemaphoreHandle_t sampleReady = nullptr; // given once per pushed sample
+static SemaphoreHandle_t hx711Mutex = nullptr;
+
+// Set while the task is clocking data out; DOUT toggles with the data bits
+// during that time and those edges must not count as new conversions.
+static volatile bool clockingOut = false;
+static volatile int64_t lastEdgeUs = 0;
+
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+static AcquisitionStats stats = {IntervalStats(), 0, 0, 0, 0, 0, RATE_IDLE};
+
+// Requested by the scale status task, applied under hx711Mutex
+static volatile SampleRate requestedRate = RATE_IDLE;
+static volatile SampleRate appliedRate = RATE_IDLE;
+static volatile uint8_t settleRemaining = 0;
+
+static void IRAM_ATTR onDoutFalling() {
+    if (clockingOut) return;
+    lastEdgeUs = esp_timer_get_time();
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(AcquisitionTask, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+// Both HX711s share SCK, so a single clock train shifts both 24-bit words out
+// at the same time (hx711ShiftOutDual): on every rising edge we sample the
+// GPIO input register once and pick both DOUT bits from it. This halves the
+// bus time compared with two sequential HX711::read() calls and gives both
+// cells the same timestamp.
+static portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+
+static_assert(LOADCELL_DOUT_PIN < 32 && LOADCELL2_DOUT_PIN < 32,
+              "both DOUT pins must be in GPIO_IN_REG (GPIO0-31)");
+
+struct GpioBus {
+    void sck(bool high) { digitalWrite(LOADCELL_SCK_PIN, high ? HIGH : LOW); }
+    void pause() { delayMicroseconds(1); }
+    uint32_t inputs() { return REG_READ(GPIO_IN_REG); }
+};
+
+static void shiftOutDual(uint32_t &word1, uint32_t &word2) {
+    const uint32_t mask1 = 1UL << LOADCELL_DOUT_PIN;
+    const uint32_t mask2 = (LOADCELL2_DOUT_PIN != -1) ? (1UL << LOADCELL2_DOUT_PIN) : 0;
+    GpioBus bus;
+    // SCK must not stay high for more than 60 us or the HX711s power down,
+    // so the clock train runs with interrupts off on this core.
+    portENTER_CRITICAL(&clockMux);
+    hx711ShiftOutDual(bus, mask1, mask2, HX711_GAIN_PULSES, word1, word2);
+    portEXIT_CRITICAL(&clockMux);
+}
+
+static int64_t conversionPeriodUs(SampleRate rate) {
+    return rate == RATE_FAST ? HX711_PERIOD_FAST_US : HX711_PERIOD_IDLE_US;
+}
+
+enum ReadResult : uint8_t { READ_OK, READ_NOT_READY, READ_PAIR_TIMEOUT };
+
+// Clock both conversions out of the HX711s. READ_NOT_READY if the primary
+// module is no longer ready (the conversion was consumed by someone else).
+static ReadResult readCells(RawSample &sample) {
+    if (digitalRead(LOADCELL_DOUT_PIN) != LOW) return READ_NOT_READY;
+
+    // The modules convert on their own oscillators, so sensor2 can become
+    // ready up to one period after sensor1. Wait for it so both words come
+    // from the same clock train. If it is not ready by then, clocking would
+    // shift sensor2 in the middle of a conversion (SCK is shared): leave both
+    // modules alone and read the pair once sensor2 has caught up.
+    if (LOADCELL2_DOUT_PIN != -1 && digitalRead(LOADCELL2_DOUT_PIN) != LOW) {
+        int64_t waitStart = esp_timer_get_time();
+        int64_t timeoutUs = conversionPeriodUs(appliedRate);
+        while (digitalRead(LOADCELL2_DOUT_PIN) != LOW) {
+            if (esp_timer_get_time() - waitStart > timeoutUs) return READ_PAIR_TIMEOUT;
+            vTaskDelay(1);
+        }
+        // The pair is only complete now, use that as its common timestamp
+        sample.timestampUs = esp_timer_get_time();
+    }
+
+    uint32_t word1, word2;
+    shiftOutDual(word1, word2);
+    sample.raw1 = hx711SignExtend(word1);
+    sample.raw2 = LOADCELL2_DOUT_PIN != -1 ? hx711SignExtend(word2) : 0;
+    return READ_OK;
+}
+
+static void recordInterval(int64_t timestampUs) {
+    portENTER_CRITICAL(&statsMux);
+    stats.intervals.record(timestampUs);
+    portEXIT_CRITICAL(&statsMux);
+}
+
+// Switch both modules to rate; the caller holds hx711Mutex
+static void applyRate(SampleRate rate) {
+    if (rate == RATE_OFF) {
+        // SCK high for more than 60 us powers both HX711s down
+        digitalWrite(LOADCELL_SCK_PIN, HIGH);
+        delayMicroseconds(100);
+    } else {
+        if (HX711_RATE_PIN != -1) {
+            digitalWrite(HX711_RATE_PIN, rate == RATE_FAST ? HIGH : LOW);
+        }
+        // Power-up (SCK low) restarts at channel A gain 128, like HX711_GAIN_PULSES 1
+        if (appliedRate == RATE_OFF) digitalWrite(LOADCELL_SCK_PIN, LOW);
+        settleRemaining = HX711_SETTLE_CONVERSIONS;
+    }
+    appliedRate = rate;
+    portENTER_CRITICAL(&statsMux);
+    stats.rateSwitches++;
+    stats.rate = rate;
+    stats.intervals.restart(); // do not count the switch as a long interval
+    portEXIT_CRITICAL(&statsMux);
+}
+
+// Task that turns DOUT edges into ring samples
+static void acquisitionLoop(void *parameter) {
+    bool resync = false;
+    for (;;) {
+        // The timeout only matters if the edge was missed (e.g. DOUT already
+        // low when the interrupt was attached); poll once in that case.
+        // Powered down, only acquisitionSetRate() wakes the task. After a
+        // pair timeout sensor1 stays ready without a new edge, so retry at once.
+        TickType_t wait = appliedRate == RATE_OFF ? portMAX_DELAY : resync ? 0 : 200 / portTICK_PERIOD_MS;
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        RawSample sample;
+        xSemaphoreTakeRecursive(hx711Mutex, portMAX_DELAY);
+        if (requestedRate != appliedRate) {
+            applyRate(requestedRate);
+        }
+        if (appliedRate == RATE_OFF) {
+            xSemaphoreGiveRecursive(hx711Mutex);
+            continue;
+        }
+        clockingOut = true;
+        // A retried pair has no edge of its own; 0 takes the read time below
+        sample.timestampUs = resync ? 0 : lastEdgeUs;
+        ReadResult result = readCells(sample);
+        clockingOut = false;
+        xSemaphoreGiveRecursive(hx711Mutex);
+
+        resync = result == READ_PAIR_TIMEOUT;
+        if (result != READ_OK) {
+            portENTER_CRITICAL(&statsMux);
+            if (resync) {
+                stats.pairTimeouts++;
+            } else {
+                stats.missedEdges++;
+            }
+            portEXIT_CRITICAL(&statsMux);
+            continue;
+        }
+        if (sample.timestampUs == 0 || esp_timer_get_time() - sample.timestampUs > 100000) {
+            sample.timestampUs = esp_timer_get_time(); // polled read, no edge time available
+        }
+
+        if (settleRemaining > 0) {
+            // Taken before the new rate or the power-up settled
+            settleRemaining--;
+            portENTER_CRITICAL(&statsMux);
+            stats.settling++;
+            portEXIT_CRITICAL(&statsMux);
+            continue;
+        }
+
+        recordInterval(sample.timestampUs);
+        if (sampleRing.push(sample)) {
+            xSemaphoreGive(sampleReady);
+        }
+    }
+}
+
+bool acquisitionNextSample(RawSample &sample, uint32_t timeoutMs) {
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeoutMs);
+    for (;;) {
+        if (sampleRing.pop(sample)) return true;
+        // The semaphore count can run ahead of the ring (a sample popped without
+        // taking it), so an empty ring after a successful take just means wait again.
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) return false;
+        xSemaphoreTake(sampleReady, timeout - elapsed);
+    }
+}
+
+void acquisitionFlush() {
+    RawSample discard;
+    while (sampleRing.pop(discard)) {}
+}
+
+AcquisitionStats acquisitionGetStats() {
+    portENTER_CRITICAL(&statsMux);
+    AcquisitionStats copy = stats;
+    portEXIT_CRITICAL(&statsMux);
+    copy.dropped = sampleRing.dropped();
+    return copy;
+}
+
+void acquisitionSetRate(SampleRate rate) {
+    if (rate == RATE_FAST && HX711_RATE_PIN == -1) rate = RATE_IDLE;
+    if (rate == requestedRate) return;
+    requestedRate = rate;
+    if (AcquisitionTask) xTaskNotifyGive(AcquisitionTask);
+}
+
+bool acquisitionSettling() {
+    return requestedRate == RATE_OFF || appliedRate == RATE_OFF || settleRemaining > 0;
+}
+
+void hx711Lock() {
+    xSemaphoreTakeRecursive(hx711Mutex, portMAX_DELAY);
+    // Direct readers wait for DOUT themselves but expect settled conversions.
+    // The acquisition task powers the modules down again if that is still
+    // requested once the lock is released.
+    if (appliedRate == RATE_OFF) {
+        applyRate(RATE_IDLE);
+        delay(HX711_SETTLE_CONVERSIONS * 100);
+        settleRemaining = 0;
+    }
+}
+
+void hx711Unlock() {
+    xSemaphoreGiveRecursive(hx711Mutex);
+}
+
+void setupAcquisition() {
+    // The ring holds at most capacity samples, so the counting semaphore never
+    // needs to count higher than that.
+    sampleReady = xSemaphoreCreateCounting(ACQUISITION_RING_SIZE, 0);
+    hx711Mutex = xSemaphoreCreateRecursiveMutex();
+    if (HX711_RATE_PIN != -1) {
+        pinMode(HX711_RATE_PIN, OUTPUT);
+        digitalWrite(HX711_RATE_PIN, LOW);
+    }
+
+    xTaskCreatePinnedToCore(acquisitionLoop, "Acquisition", TASK_ACQUISITION_STACK, NULL, TASK_ACQUISITION_PRIORITY,
+                            &AcquisitionTask, TASK_ACQUISITION_CORE);
+    attachInterrupt(digitalPinToInterrupt(LOADCELL_DOUT_PIN), onDoutFalling, FALLING);
+    Serial.println("HX711 acquisition started (DOUT falling-edge interrupt).");
+}
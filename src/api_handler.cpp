@@ -1,31 +1,304 @@
 #include "api_handler.hpp"
 #include "config.hpp"
+#include "log.hpp"
+#include "scale.hpp"
+#include "settings.hpp"
+#include "wifi_provisioning.hpp"
+#include <ArduinoJson.h>
 
-extern Preferences preferences;
+extern float predictorLatencyS;
+extern float predictorInFlightG;
 
-void setupApiEndpoints(AsyncWebServer& server) {
-    // Serve Wi-Fi configuration page
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-        extern const std::string html_page;
-        request->send(200, "text/html", html_page.c_str());
-    });
+// Settings a client may change, with the accepted range. The others
+// (calibration, load cell offsets, shot count) are reported read-only:
+// they are set by the calibration flow and the scale itself.
+struct ApiSetting {
+    SettingKey key;
+    double min;
+    double max;
+};
+
+static const ApiSetting WRITABLE[] = {
+    {SET_SET_WEIGHT, 0, 100},
+    {SET_SHOT_OFFSET, -100, 100}, // further limited to +-setWeight like the menu
+    {SET_CUP_WEIGHT, 0, 1000},
+    {SET_SCALE_MODE, 0, 1},
+    {SET_GRIND_MODE, 0, 1},
+    {SET_SLEEP_TIME, 1000, 3600000},
+    {SET_GRIND_TRIGGER, 0, 1},
+    {SET_MANUAL_GRIND, 0, 1},
+    {SET_DISPLAY_COMP, 0, 20},
+    {SET_AUTO_VIBE, 0, 1},
+    {SET_PRED_LATENCY, 0, 2},     // GrindPredictor's model limits
+    {SET_PRED_IN_FLIGHT, -2, 5},
+};
+
+static const char *const STATUS_NAMES[] = {"empty", "grinding", "finished", "failed", "menu", "submenu",
+                                           "relay_test", "unknown", "info"};
+
+static ApiStats stats = {};
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const ApiSetting *writable(SettingKey key) {
+    for (const ApiSetting &setting : WRITABLE) {
+        if (setting.key == key) return &setting;
+    }
+    return nullptr;
+}
+
+// Serializes into a stack buffer; the only heap the request costs is the
+// response object and its copy of the body inside AsyncWebServer. The free
+// heap before and after send() measures that (other tasks allocating at the
+// same moment show up as noise).
+static void sendJson(AsyncWebServerRequest *request, int code, const JsonDocument &doc) {
+    char body[API_BODY_MAX];
+    size_t length = serializeJson(doc, body, sizeof(body));
+    bool overflowed = doc.overflowed() || length >= sizeof(body) - 1;
+    if (overflowed) LOGW(TAG_WEB, "API: %s response does not fit API_BODY_MAX", request->url().c_str());
+    uint32_t heapBefore = ESP.getFreeHeap();
+    request->send(code, "application/json", body);
+    int32_t heapDelta = (int32_t)(heapBefore - ESP.getFreeHeap());
+    portENTER_CRITICAL(&statsMux);
+    stats.requests++;
+    if (code >= 400) stats.errors++;
+    if (overflowed) stats.overflows++;
+    if (length > stats.largestBody) stats.largestBody = length;
+    stats.lastHeapDelta = heapDelta;
+    if (heapDelta > stats.largestHeapDelta) stats.largestHeapDelta = heapDelta;
+    portEXIT_CRITICAL(&statsMux);
+}
 
-    // Handle Wi-Fi settings submission
+static void sendError(AsyncWebServerRequest *request, int code, const char *error, const char *key = nullptr) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(2)> doc;
+    doc["error"] = error;
+    if (key) doc["key"] = key;
+    sendJson(request, code, doc);
+}
+
+// Weights to 0.01 g like the display, rather than the filter's noise
+static double grams(double weight) {
+    return round(weight * 100.0) / 100.0;
+}
+
+static void handleState(AsyncWebServerRequest *request) {
+    StaticJsonDocument<API_JSON_CAPACITY> doc;
+    int status = scaleStatus;
+    doc["status"] = status >= 0 && status < (int)(sizeof(STATUS_NAMES) / sizeof(STATUS_NAMES[0]))
+                        ? STATUS_NAMES[status] : "unknown";
+    doc["weight"] = grams(scaleWeight);
+    StabilityState stability = scaleStability();
+    doc["stable"] = stability.stable;
+    doc["cup"] = grams(cupWeightEmpty);
+    doc["target"] = setWeight;
+    doc["taring"] = tareInProgress();
+    double settled;
+    if (grindSettledWeight(settled)) {
+        doc["settled"] = grams(settled);
+    } else {
+        doc["settled"] = nullptr;
+    }
+    doc["shotCount"] = shotCount;
+    doc["uptimeMs"] = millis();
+    doc["heapFree"] = ESP.getFreeHeap();
+    sendJson(request, 200, doc);
+}
+
+static void handleSettingsGet(AsyncWebServerRequest *request) {
+    StaticJsonDocument<API_JSON_CAPACITY> doc;
+    JsonObject values = doc.createNestedObject("settings");
+    JsonArray readOnly = doc.createNestedArray("readOnly");
+    for (int i = 0; i < SETTING_COUNT; ++i) {
+        SettingKey key = (SettingKey)i;
+        if (settingsIsBool(key)) {
+            values[settingsName(key)] = settingsGet(key) != 0;
+        } else {
+            values[settingsName(key)] = settingsGet(key);
+        }
+        if (!writable(key)) readOnly.add(settingsName(key));
+    }
+    sendJson(request, 200, doc);
+}
+
+// Body of a settings update; AsyncWebServer frees _tempObject with the
+// request. Bodies normally arrive in one piece, but TCP may split them.
+static void collectBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (total >= API_BODY_MAX) return; // rejected in handleSettingsUpdate
+    if (index == 0) {
+        request->_tempObject = calloc(total + 1, 1);
+    }
+    if (request->_tempObject && index + len <= total) {
+        memcpy((char *)request->_tempObject + index, data, len);
+    }
+}
+
+// Validates every key before changing anything, so a rejected update has
+// no effect. Returns false after sending the error. Not inlined, so its
+// document leaves the stack before the response is built.
+static bool __attribute__((noinline)) applySettingsUpdate(AsyncWebServerRequest *request) {
+    if (request->contentLength() >= API_BODY_MAX) {
+        sendError(request, 413, "body too large");
+        return false;
+    }
+    if (!request->_tempObject) {
+        sendError(request, 400, "expected a JSON object");
+        return false;
+    }
+    StaticJsonDocument<API_JSON_CAPACITY> doc;
+    // Parses in place: strings point into the body buffer
+    if (deserializeJson(doc, (char *)request->_tempObject) != DeserializationError::Ok || !doc.is<JsonObject>()) {
+        sendError(request, 400, "expected a JSON object");
+        return false;
+    }
+    JsonObject update = doc.as<JsonObject>();
+    if (scaleStatus == STATUS_GRINDING_IN_PROGRESS) {
+        sendError(request, 409, "grinding");
+        return false;
+    }
+
+    double newSetWeight = setWeight;
+    if (update.containsKey(settingsName(SET_SET_WEIGHT))) newSetWeight = update[settingsName(SET_SET_WEIGHT)];
+    for (JsonPair pair : update) {
+        SettingKey key = settingsFind(pair.key().c_str());
+        if (key == SETTING_COUNT) {
+            sendError(request, 400, "unknown setting", pair.key().c_str());
+            return false;
+        }
+        const ApiSetting *setting = writable(key);
+        if (!setting) {
+            sendError(request, 403, "read-only setting", pair.key().c_str());
+            return false;
+        }
+        JsonVariant value = pair.value();
+        bool typeOk = settingsIsBool(key) ? value.is<bool>() : (value.is<double>() && !value.is<bool>());
+        if (!typeOk) {
+            sendError(request, 400, settingsIsBool(key) ? "expected true or false" : "expected a number",
+                      pair.key().c_str());
+            return false;
+        }
+        double number = value.as<double>();
+        double lowest = key == SET_SHOT_OFFSET ? max(setting->min, -newSetWeight) : setting->min;
+        double highest = key == SET_SHOT_OFFSET ? min(setting->max, newSetWeight) : setting->max;
+        if (!settingsIsBool(key) && !(number >= lowest && number <= highest)) {
+            sendError(request, 400, "out of range", pair.key().c_str());
+            return false;
+        }
+    }
+
+    float latency = predictorLatencyS, inFlight = predictorInFlightG;
+    bool predictor = false;
+    for (JsonPair pair : update) {
+        SettingKey key = settingsFind(pair.key().c_str());
+        double value = settingsIsBool(key) ? (pair.value().as<bool>() ? 1 : 0) : pair.value().as<double>();
+        // The predictor model is shared with the scale task
+        if (key == SET_PRED_LATENCY) {
+            latency = value;
+            predictor = true;
+        } else if (key == SET_PRED_IN_FLIGHT) {
+            inFlight = value;
+            predictor = true;
+        } else {
+            settingsSet(key, value);
+        }
+        LOGI(TAG_WEB, "API: %s = %.3f", pair.key().c_str(), value);
+    }
+    if (predictor) grindPredictorSetModel(latency, inFlight);
+    return true;
+}
+
+// Answers with the settings as they are afterwards. The update's document
+// is gone by then: two documents plus the response body would crowd the
+// AsyncTCP task's 8 KB stack.
+static void handleSettingsUpdate(AsyncWebServerRequest *request) {
+    if (applySettingsUpdate(request)) handleSettingsGet(request);
+}
+
+static void sendWifiStatus(AsyncWebServerRequest *request, int code) {
+    ProvisioningStatus wifi = provisioningStatus();
+    StaticJsonDocument<API_JSON_CAPACITY> doc;
+    doc["state"] = provisioningStateName(wifi.state);
+    char address[16];
+    snprintf(address, sizeof(address), "%u.%u.%u.%u", wifi.address & 0xff, (wifi.address >> 8) & 0xff,
+             (wifi.address >> 16) & 0xff, wifi.address >> 24);
+    doc["address"] = address;
+    doc["ssid"] = wifi.ssid;
+    doc["sinceMs"] = wifi.sinceMs;
+    doc["connects"] = wifi.connects;
+    doc["saving"] = wifi.credentialsPending;
+    if (wifi.restartInMs >= 0) {
+        doc["restartInMs"] = wifi.restartInMs;
+    } else {
+        doc["restartInMs"] = nullptr;
+    }
+    sendJson(request, code, doc);
+}
+
+static void handleWifiGet(AsyncWebServerRequest *request) {
+    sendWifiStatus(request, 200);
+}
+
+// {"ssid":"...","password":"..."}: saved and applied by a restart from the
+// web task; poll GET /api/v1/wifi for progress
+static void handleWifiUpdate(AsyncWebServerRequest *request) {
+    if (request->contentLength() >= API_BODY_MAX) {
+        sendError(request, 413, "body too large");
+        return;
+    }
+    StaticJsonDocument<JSON_OBJECT_SIZE(2)> doc;
+    if (!request->_tempObject ||
+        deserializeJson(doc, (char *)request->_tempObject) != DeserializationError::Ok ||
+        !doc["ssid"].is<const char *>()) {
+        sendError(request, 400, "expected {\"ssid\":...,\"password\":...}");
+        return;
+    }
+    // Saving restarts the scale
+    if (grinderBusy()) {
+        sendError(request, 409, "grinding");
+        return;
+    }
+    const char *password = doc["password"].is<const char *>() ? doc["password"].as<const char *>() : "";
+    if (!provisioningSetCredentials(doc["ssid"], password)) {
+        sendError(request, 400, "SSID must be 1-32 characters, password empty or 8-63");
+        return;
+    }
+    sendWifiStatus(request, 202);
+}
+
+void setupApiEndpoints(AsyncWebServer& server) {
+    // Handle Wi-Fi settings submission (configuration page); the web task
+    // saves them and restarts
     server.on("/updateSettings", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (request->hasParam("ssid", true) && request->hasParam("password", true)) {
-            String ssid = request->getParam("ssid", true)->value();
-            String password = request->getParam("password", true)->value();
-
-            preferences.begin("wifi", false);
-            preferences.putString("ssid", ssid);
-            preferences.putString("password", password);
-            preferences.end();
-
-            request->send(200, "text/html", "<h1>Wi-Fi Saved. Restarting...</h1>");
-            delay(3000);
-            ESP.restart(); // Restart ESP32 to apply new Wi-Fi settings
+        if (grinderBusy()) {
+            request->send(409, "text/plain", "Grinding, try again when it is done");
+        } else if (request->hasParam("ssid", true) && request->hasParam("password", true)) {
+            if (provisioningSetCredentials(request->getParam("ssid", true)->value().c_str(),
+                                           request->getParam("password", true)->value().c_str())) {
+                request->send(202, "text/html", "<h1>Wi-Fi Saved. Restarting...</h1>");
+            } else {
+                request->send(400, "text/plain", "SSID must be 1-32 characters, password empty or 8-63");
+            }
         } else {
             request->send(400, "text/plain", "Missing Wi-Fi credentials");
         }
     });
+
+    server.on("/api/v1/state", HTTP_GET, handleState);
+    server.on("/api/v1/settings", HTTP_GET, handleSettingsGet);
+    server.on("/api/v1/settings", HTTP_PUT | HTTP_POST, handleSettingsUpdate, nullptr, collectBody);
+    server.on("/api/v1/wifi", HTTP_GET, handleWifiGet);
+    server.on("/api/v1/wifi", HTTP_PUT | HTTP_POST, handleWifiUpdate, nullptr, collectBody);
+    server.on("/api/v1/restart", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (grinderBusy()) {
+            sendError(request, 409, "grinding");
+            return;
+        }
+        provisioningScheduleRestart(WIFI_RESTART_DELAY_MS);
+        sendWifiStatus(request, 202);
+    });
+}
+
+ApiStats apiStats() {
+    portENTER_CRITICAL(&statsMux);
+    ApiStats copy = stats;
+    portEXIT_CRITICAL(&statsMux);
+    return copy;
 }
@@ -4,8 +4,11 @@
 #include <U8g2lib.h>
 
 #include "config.hpp"
+#include "display.hpp"
 #include "rotary.hpp"
+#include "scale.hpp"
 #include "web_server.hpp"
+#include "wifi_provisioning.hpp"
 
 // External flag set by scale logic to indicate the finished-screen compensation
 extern bool display_compensate_shot;
@@ -14,11 +17,84 @@ extern double display_compensation_g;
 
 U8G2_SSD1306_128X64_NONAME_F_HW_I2C screen(U8G2_R0, /* reset=*/ U8X8_PIN_NONE, /* clock=*/ OLED_SCL, /* data=*/ OLED_SDA);
 TaskHandle_t DisplayTask;
-extern String currentIPAddress;
 
 // Time in milliseconds after which the display sleeps (10 seconds)
 int sleepTime = SLEEP_AFTER_MS;
 
+// Dirty-tile renderer
+//
+// Screens still draw the complete frame into the U8g2 buffer. presentFrame()
+// compares it with the frame last sent, 8x8 tile by tile, and pushes only the
+// runs of changed tiles with updateDisplayArea(). A static screen costs a
+// 1 KB memcmp instead of a full I2C transfer.
+static uint8_t lastFrame[128 * 64 / 8];
+static bool lastFrameValid = false;
+static SemaphoreHandle_t frameMutex = nullptr; // wakeScreen() and the messages present from other tasks
+static DisplayStats displayStats = {0, 0, 0, 0, 0, 0, 0};
+static uint32_t bytesThisWindow = 0;
+static unsigned long windowStartedAt = 0;
+
+static bool tileChanged(const uint8_t *frame, size_t offset)
+{
+  return !lastFrameValid || memcmp(frame + offset, lastFrame + offset, 8) != 0;
+}
+
+static void presentFrame()
+{
+  if (frameMutex) xSemaphoreTake(frameMutex, portMAX_DELAY);
+  const uint8_t *frame = screen.getBufferPtr();
+  const uint8_t tilesWide = screen.getBufferTileWidth();
+  const uint8_t tilesHigh = screen.getBufferTileHeight();
+  uint32_t tiles = 0;
+  for (uint8_t ty = 0; ty < tilesHigh; ty++)
+  {
+    uint8_t tx = 0;
+    while (tx < tilesWide)
+    {
+      // Skip unchanged tiles, then send the run of changed ones in one call
+      while (tx < tilesWide && !tileChanged(frame, (ty * tilesWide + tx) * 8)) tx++;
+      if (tx == tilesWide) break;
+      uint8_t start = tx;
+      while (tx < tilesWide && tileChanged(frame, (ty * tilesWide + tx) * 8)) tx++;
+      screen.updateDisplayArea(start, ty, tx - start, 1);
+      tiles += tx - start;
+    }
+  }
+  memcpy(lastFrame, frame, sizeof(lastFrame));
+  lastFrameValid = true;
+
+  displayStats.frames++;
+  if (tiles == 0) displayStats.unchangedFrames++;
+  displayStats.tilesSent += tiles;
+  bytesThisWindow += tiles * 8;
+  unsigned long now = millis();
+  if (now - windowStartedAt >= 1000)
+  {
+    displayStats.bytesPerSecond = bytesThisWindow * 1000 / (now - windowStartedAt);
+    bytesThisWindow = 0;
+    windowStartedAt = now;
+  }
+  if (frameMutex) xSemaphoreGive(frameMutex);
+}
+
+// Change notifications from the scale, status and UI code. The display task
+// sleeps on this queue and redraws when something it shows has changed, or
+// when the max-age deadline passes (clock, sleep timeout).
+static QueueHandle_t displayQueue = nullptr;
+
+void displayNotify(DisplayEvent event)
+{
+  if (!displayQueue) return;
+  // A full queue already guarantees a redraw, so the event can be dropped
+  if (xQueueSend(displayQueue, &event, 0) != pdTRUE) displayStats.coalescedEvents++;
+}
+
+DisplayStats displayGetStats()
+{
+  return displayStats;
+}
+
+
 // ...existing code...
 
 
@@ -41,7 +117,7 @@ void showErrorMessage(const char* message) {
   CenterPrintToScreen("ERROR", 0);
   screen.setFont(u8g2_font_7x13_tr);
   CenterPrintToScreen(message, 24);
-  screen.sendBuffer();
+  presentFrame();
 }
 bool screenJustWoke = false;
 
@@ -71,12 +147,41 @@ void RightPrintToScreen(char const *str, u8g2_uint_t y)
   screen.print(str);                           // Print the text
 }
 
+// Current weight -> target, shared by the grinding and finished screens
+static void drawWeightToTarget(double weight, double target)
+{
+  char buf[16];
+  screen.setFontPosCenter();
+  screen.setFont(u8g2_font_7x14B_tf);
+  screen.setCursor(3, 32);
+  snprintf(buf, sizeof(buf), "%3.1fg", weight);
+  screen.print(buf);
+
+  screen.setFont(u8g2_font_unifont_t_symbols);
+  screen.drawGlyph(64, 32, 0x2794);
+
+  screen.setFont(u8g2_font_7x14B_tf);
+  screen.setCursor(84, 32);
+  snprintf(buf, sizeof(buf), "%3.1fg", target);
+  screen.print(buf);
+}
+
+// Elapsed time centred on the bottom line
+static void drawSecondsFooter(double seconds)
+{
+  char buf[16];
+  screen.setFontPosBottom();
+  screen.setFont(u8g2_font_7x13_tr);
+  snprintf(buf, sizeof(buf), "%3.1fs", seconds);
+  CenterPrintToScreen(buf, 64);
+}
+
 //WEBSERVER
 void showIPAddress() {
   screen.setFont(u8g2_font_5x8_tf); // Small font for IP display
   screen.setCursor(2, 60);          // Position at bottom-left of the screen
   screen.print("IP: ");
-  screen.print(currentIPAddress);
+  screen.print(provisioningAddress());
 }
 
 //MENU 
@@ -126,7 +231,8 @@ void wakeScreen() {
     screenJustWoke = true; // Indicate that the screen just woke up
     scaleStatus = STATUS_EMPTY;
     screen.clearBuffer();
-    screen.sendBuffer();
+    presentFrame();
+    displayNotify(DISPLAY_STATE);
 }
 
 // Function to display the menu with previous, current, and next items
@@ -151,7 +257,7 @@ void showMenu()
   LeftPrintActiveToScreen(current.menuName, 35); // Highlight the current menu item
   LeftPrintToScreen(next.menuName, 51);          // Print the next menu item
 
-  screen.sendBuffer(); // Send the buffer to the display
+  presentFrame(); // Send the buffer to the display
 }
 
 // Function to display the mode submenu
@@ -175,7 +281,7 @@ void showModeMenu()
   LeftPrintActiveToScreen(current.menuName, 35);
   LeftPrintToScreen(next.menuName, 51);
 
-  screen.sendBuffer();
+  presentFrame();
 }
 
 // Function to display the configuration submenu
@@ -199,7 +305,7 @@ void showConfigMenu()
   LeftPrintActiveToScreen(current.menuName, 35);
   LeftPrintToScreen(next.menuName, 51);
 
-  screen.sendBuffer();
+  presentFrame();
 }
 
 void showGrindTriggerMenu() {
@@ -218,7 +324,7 @@ void showGrindTriggerMenu() {
 
   // Display instructions
   LeftPrintToScreen("Press button to toggle", 50);
-  screen.sendBuffer();
+  presentFrame();
 }
 
 
@@ -233,7 +339,7 @@ void showOffsetMenu()
   screen.setFont(u8g2_font_7x13_tr);            // Set the font for the offset value
   snprintf(buf, sizeof(buf), "%3.2fg", shotOffset); // Format the shotOffset value
   CenterPrintToScreen(buf, 28);                 // Print the offset value
-  screen.sendBuffer();                          // Send the buffer to the display
+  presentFrame();                             // Send the buffer to the display
 }
 
 // Dedicated Compensation menu so user can edit stuck-grounds compensation
@@ -254,7 +360,7 @@ void showCompensationMenu()
   screen.setFont(u8g2_font_7x13_tr);
   LeftPrintToScreen("Adjust with dial", 50);
   LeftPrintToScreen("Press to save", 58);
-  screen.sendBuffer();
+  presentFrame();
 }
 
 // Function to display the scale mode menu
@@ -275,7 +381,7 @@ void showScaleModeMenu()
     LeftPrintActiveToScreen("GBW", 19);  // Highlight active item
     LeftPrintToScreen("Scale only", 35); // Print inactive item
   }
-  screen.sendBuffer(); // Send the buffer to the display
+  presentFrame(); // Send the buffer to the display
 }
 
 // Function to display the grind mode menu
@@ -297,7 +403,7 @@ void showGrindModeMenu()
     LeftPrintToScreen("Continuous", 35);    // Print inactive item
     LeftPrintActiveToScreen("Impulse", 51); // Highlight active item
   }
-  screen.sendBuffer(); // Send the buffer to the display
+  presentFrame(); // Send the buffer to the display
 }
 
 // Function to display the cup weight adjustment menu
@@ -313,7 +419,7 @@ void showCupMenu()
   CenterPrintToScreen(buf, 19);                      // Print the scale weight
   LeftPrintToScreen("Place cup on scale", 35);       // Print instructions
   LeftPrintToScreen("and press button", 51);         // Print instructions
-  screen.sendBuffer();                               // Send the buffer to the display
+  presentFrame();                                  // Send the buffer to the display
 }
 
 void showCupWeightSetScreen(double cupWeight)
@@ -326,7 +432,7 @@ void showCupWeightSetScreen(double cupWeight)
   snprintf(buf, sizeof(buf), "%3.1fg", cupWeight);
   CenterPrintToScreen(buf, 20); // Center the message on the screen
 
-  screen.sendBuffer();
+  presentFrame();
   delay(2000); // Block for 2 seconds to ensure the screen stays visible
 }
 
@@ -347,7 +453,7 @@ void showCalibrationMenu()
   char buf[32];
   snprintf(buf, sizeof(buf), "Compensation: %.1fg", display_compensation_g);
   LeftPrintToScreen(buf, 58);
-  screen.sendBuffer();                          // Send the buffer to the display
+  presentFrame();                             // Send the buffer to the display
 }
 
 // Function to display the reset menu
@@ -368,7 +474,7 @@ void showResetMenu()
     LeftPrintToScreen("Confirm", 19);      // Print inactive item
     LeftPrintActiveToScreen("Cancel", 35); // Highlight active item
   }
-  screen.sendBuffer(); // Send the buffer to the display
+  presentFrame(); // Send the buffer to the display
 }
 
 void showInfoMenu() {
@@ -383,7 +489,7 @@ void showInfoMenu() {
     CenterPrintToScreen("System Info", 0);
 
     // Display offset
-    IPAddress ip = WiFi.localIP();
+    IPAddress ip = provisioningAddress();
     snprintf(buf, sizeof(buf), "IP: %d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
     LeftPrintToScreen(buf, 32);
 
@@ -392,7 +498,7 @@ void showInfoMenu() {
     LeftPrintToScreen(buf, 48);
 
     // Send buffer to the display
-    screen.sendBuffer();
+    presentFrame();
 
     // No unnecessary delays or clearing here
 }
@@ -445,8 +551,49 @@ void updateDisplay(void *parameter)
   char buf[64];
   char buf2[64];
 
+  const unsigned long frameIntervalMs = 1000 / DISPLAY_MAX_FPS;
+  unsigned long lastFrameAt = 0;
+  unsigned long infoMenuSince = 0;
+  int lastStatus = -1;
+
   for (;;)
   {
+    // Sleep until something changed or the current screen is due a refresh.
+    // The grinding timer ticks every 0.1s, everything else only needs the
+    // deadline for the sleep timeout.
+    unsigned long maxAgeMs = DISPLAY_MAX_AGE_MS;
+    if (scaleStatus == STATUS_GRINDING_IN_PROGRESS) maxAgeMs = 100;
+    if (scaleStatus == STATUS_INFO_MENU)
+    {
+      unsigned long shown = millis() - infoMenuSince;
+      maxAgeMs = shown < INFO_MENU_SHOW_MS ? min(maxAgeMs, INFO_MENU_SHOW_MS - shown) : 0;
+    }
+    DisplayEvent event;
+    bool urgent = false;
+    if (xQueueReceive(displayQueue, &event, pdMS_TO_TICKS(maxAgeMs)) == pdTRUE)
+    {
+      displayStats.eventWakeups++;
+      urgent = event == DISPLAY_STATE;
+    }
+    else
+    {
+      displayStats.deadlineWakeups++;
+    }
+    // Let a burst of weight or encoder updates settle into one frame; state
+    // changes (grind start/stop) are drawn right away
+    unsigned long sinceLastFrame = millis() - lastFrameAt;
+    if (!urgent && sinceLastFrame < frameIntervalMs) delay(frameIntervalMs - sinceLastFrame);
+    while (xQueueReceive(displayQueue, &event, 0) == pdTRUE)
+    {
+    }
+    lastFrameAt = millis();
+
+    if (scaleStatus != lastStatus)
+    {
+      if (scaleStatus == STATUS_INFO_MENU) infoMenuSince = millis();
+      lastStatus = scaleStatus;
+    }
+
     // Clear the display compensation flag as soon as we leave the finished screen
     if (scaleStatus != STATUS_GRINDING_FINISHED) {
       display_compensate_shot = false;
@@ -454,16 +601,13 @@ void updateDisplay(void *parameter)
 
     if (displayLock)
     {
-      delay(50); // Skip updating the display while locked
-      continue;
+      continue; // Skip updating the display while locked; the unlock notifies
     }
 
-    screen.clearBuffer(); // Clear the display buffer
     screen.clearBuffer(); // Clear the display buffer
     if (millis() - lastSignificantWeightChangeAt > sleepTime)
     {
-      screen.sendBuffer(); // Send the buffer to the display to "sleep"
-      delay(100);
+      presentFrame(); // Send the buffer to the display to "sleep"
       scaleStatus = STATUS_EMPTY;
       continue;
     }
@@ -486,26 +630,8 @@ void updateDisplay(void *parameter)
         screen.setFont(u8g2_font_7x13_tr);
         CenterPrintToScreen("Grinding...", 0);
 
-        screen.setFontPosCenter();
-        screen.setFont(u8g2_font_7x14B_tf);
-        screen.setCursor(3, 32);
-        snprintf(buf, sizeof(buf), "%3.1fg", scaleWeight - cupWeightEmpty);
-        screen.print(buf);
-
-        screen.setFontPosCenter();
-        screen.setFont(u8g2_font_unifont_t_symbols);
-        screen.drawGlyph(64, 32, 0x2794);
-
-        screen.setFontPosCenter();
-        screen.setFont(u8g2_font_7x14B_tf);
-        screen.setCursor(84, 32);
-        snprintf(buf, sizeof(buf), "%3.1fg", setWeight);
-        screen.print(buf);
-
-        screen.setFontPosBottom();
-        screen.setFont(u8g2_font_7x13_tr);
-        snprintf(buf, sizeof(buf), "%3.1fs", startedGrindingAt > 0 ? (double)(millis() - startedGrindingAt) / 1000 : 0);
-        CenterPrintToScreen(buf, 64);
+        drawWeightToTarget(scaleWeight - cupWeightEmpty, setWeight);
+        drawSecondsFooter(startedGrindingAt > 0 ? (double)(millis() - startedGrindingAt) / 1000 : 0);
       }
       else if (scaleStatus == STATUS_EMPTY)
       {
@@ -549,29 +675,14 @@ void updateDisplay(void *parameter)
         screen.setCursor(0, 0);
         CenterPrintToScreen("Grinding finished", 0);
 
-        screen.setFontPosCenter();
-        screen.setFont(u8g2_font_7x14B_tf);
-  screen.setCursor(3, 32);
-  double displayed = scaleWeight - cupWeightEmpty;
-  if (display_compensate_shot) displayed += display_compensation_g;
-  snprintf(buf, sizeof(buf), "%3.1fg", displayed);
-  screen.print(buf);
-
-        screen.setFontPosCenter();
-        screen.setFont(u8g2_font_unifont_t_symbols);
-        screen.drawGlyph(64, 32, 0x2794);
-
-        screen.setFontPosCenter();
-        screen.setFont(u8g2_font_7x14B_tf);
-        screen.setCursor(84, 32);
-        snprintf(buf, sizeof(buf), "%3.1fg", setWeight);
-        screen.print(buf);
-
-        screen.setFontPosBottom();
-        screen.setFont(u8g2_font_7x13_tr);
-        screen.setCursor(64, 64);
-        snprintf(buf, sizeof(buf), "%3.1fs", (double)(finishedGrindingAt - startedGrindingAt) / 1000);
-        CenterPrintToScreen(buf, 64);
+        // Hold the settled weight once there is one instead of the filter's
+        // last digit wandering
+        double finalWeight = scaleWeight;
+        grindSettledWeight(finalWeight);
+        double displayed = finalWeight - cupWeightEmpty;
+        if (display_compensate_shot) displayed += display_compensation_g;
+        drawWeightToTarget(displayed, setWeight);
+        drawSecondsFooter((double)(finishedGrindingAt - startedGrindingAt) / 1000);
       }
       else if (scaleStatus == STATUS_IN_MENU)
       {
@@ -587,21 +698,35 @@ void updateDisplay(void *parameter)
       {
         showSetting();
       }
+      else if (scaleStatus == STATUS_RELAY_TEST)
+      {
+        screen.setFontPosTop();
+        screen.setFont(u8g2_font_7x14B_tf);
+        CenterPrintToScreen("Relay test", 0);
+        screen.setFont(u8g2_font_7x13_tr);
+        CenterPrintToScreen("Keep the cup", 28);
+        CenterPrintToScreen("in place", 42);
+      }
       else if (scaleStatus == STATUS_INFO_MENU)
       {
-        showInfoMenu(); // Continuously display the Info Menu while in this state
-        delay(1000);     // Add a small delay to avoid rapid screen updates
-        exitToMenu();
-        continue;       // Skip the rest of the update logic
+        showInfoMenu(); // Shown for INFO_MENU_SHOW_MS, then back to the menu
+        if (millis() - infoMenuSince >= INFO_MENU_SHOW_MS)
+        {
+          exitToMenu();
+          displayNotify(DISPLAY_STATE);
+        }
+        continue;       // showInfoMenu() already presented the frame
       }
     }
-    screen.sendBuffer(); // Send the buffer to the display
+    presentFrame(); // Send the buffer to the display
   }
 }
 
 // Function to initialize the display and start the display update task
 void setupDisplay()
 {
+  frameMutex = xSemaphoreCreateMutex();
+  displayQueue = xQueueCreate(DISPLAY_QUEUE_LENGTH, sizeof(DisplayEvent));
   screen.begin();                    // Initialize the display
   screen.setFont(u8g2_font_7x13_tr); // Set the default font
   screen.setFontPosTop();
@@ -611,11 +736,11 @@ void setupDisplay()
   xTaskCreatePinnedToCore(
       updateDisplay, /* Function to implement the task */
       "Display",     /* Name of the task */
-      10000,         /* Stack size in words */
-      NULL,          /* Task input parameter */
-      0,             /* Priority of the task */
-      &DisplayTask,  /* Task handle */
-      1);            /* Core where the task should run */
+      TASK_DISPLAY_STACK,    /* Stack size in bytes */
+      NULL,                  /* Task input parameter */
+      TASK_DISPLAY_PRIORITY, /* Priority of the task */
+      &DisplayTask,          /* Task handle */
+      TASK_DISPLAY_CORE);    /* Core where the task should run */
 }
 
 // Function to show taring message
@@ -627,7 +752,7 @@ void showTaringMessage()
   CenterPrintToScreen("Taring...", 20);         // Print the taring message
   screen.setFont(u8g2_font_7x13_tr);            // Set smaller font
   CenterPrintToScreen("Please wait", 40);       // Print additional message
-  screen.sendBuffer();                          // Send the buffer to the display
+  presentFrame();                             // Send the buffer to the display
 }
 
 // Function to show mode change message
@@ -639,5 +764,5 @@ void showModeChangeMessage(const char* mode, const char* status)
   CenterPrintToScreen(mode, 20);                // Print the mode
   screen.setFont(u8g2_font_7x13_tr);            // Set smaller font
   CenterPrintToScreen(status, 40);              // Print the status
-  screen.sendBuffer();                          // Send the buffer to the display
+  presentFrame();                             // Send the buffer to the display
 }
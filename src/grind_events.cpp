@@ -0,0 +1,116 @@
+#include "grind_events.hpp"
+#include "config.hpp"
+#include "log.hpp"
+#include <stdarg.h>
+
+struct LoggedEvent {
+    uint32_t id;
+    GrindEventType type;
+    char data[GRIND_EVENT_DATA];
+};
+
+static const char *const EVENT_NAMES[] = {"grind_start", "grind_stop", "grind_failed", "grind_settled"};
+
+static AsyncEventSource eventSource(WEB_EVENTS_PATH);
+// Event with id n lives in slot n % GRIND_EVENT_LOG until id n + GRIND_EVENT_LOG
+static LoggedEvent eventLog[GRIND_EVENT_LOG];
+static uint32_t newestId = 0; // last published
+static uint32_t pushedId = 0; // last handed to the connected clients
+static portMUX_TYPE eventMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Ids on the wire carry a random per-boot epoch above the sequence number,
+// so a client can tell the ids of an earlier boot from this one's. Kept
+// below 2^31: AsyncEventSourceClient parses Last-Event-ID with atoi().
+#define EVENT_SEQUENCE_BITS 20
+#define EVENT_SEQUENCE_MASK ((1UL << EVENT_SEQUENCE_BITS) - 1)
+#define EVENT_EPOCHS (1UL << (31 - EVENT_SEQUENCE_BITS))
+static uint32_t bootEpoch = 0; // 1..EVENT_EPOCHS - 1, set in setupGrindEvents()
+
+static uint32_t wireId(uint32_t id) {
+    return (bootEpoch << EVENT_SEQUENCE_BITS) | (id & EVENT_SEQUENCE_MASK);
+}
+
+// False if the event is not (or no longer) in the log
+static bool copyEvent(uint32_t id, LoggedEvent &event) {
+    bool found = false;
+    portENTER_CRITICAL(&eventMux);
+    const LoggedEvent &slot = eventLog[id % GRIND_EVENT_LOG];
+    if (id != 0 && slot.id == id) {
+        event = slot;
+        found = true;
+    }
+    portEXIT_CRITICAL(&eventMux);
+    return found;
+}
+
+// Runs in the AsyncTCP task when a client connects
+static void onEventsConnect(AsyncEventSourceClient *client) {
+    portENTER_CRITICAL(&eventMux);
+    uint32_t upTo = pushedId;
+    portEXIT_CRITICAL(&eventMux);
+    uint32_t lastWireId = client->lastId();
+    LOGI(TAG_WEB, "Events: client connected, Last-Event-ID %u of %u", lastWireId, wireId(upTo));
+    if (lastWireId == 0) return;
+    uint32_t lastId = lastWireId & EVENT_SEQUENCE_MASK;
+    // Another boot's id (or one from the future): all logged events are new to it
+    if ((lastWireId >> EVENT_SEQUENCE_BITS) != bootEpoch || lastId > upTo) lastId = 0;
+    if (lastId == upTo) return;
+
+    // Events after upTo reach this client through grindEventsService()
+    uint32_t oldest = upTo > GRIND_EVENT_LOG ? upTo - GRIND_EVENT_LOG + 1 : 1;
+    if (lastId + 1 < oldest && lastId != 0) {
+        char gap[32];
+        snprintf(gap, sizeof(gap), "{\"missed\":%u}", oldest - lastId - 1);
+        client->send(gap, "gap");
+    }
+    LoggedEvent event;
+    for (uint32_t id = max(lastId + 1, oldest); id <= upTo; ++id) {
+        if (copyEvent(id, event)) client->send(event.data, EVENT_NAMES[event.type], wireId(event.id));
+    }
+}
+
+void setupGrindEvents(AsyncWebServer &server) {
+    bootEpoch = 1 + esp_random() % (EVENT_EPOCHS - 1);
+    eventSource.onConnect(onEventsConnect);
+    server.addHandler(&eventSource);
+}
+
+void grindEventsService() {
+    for (;;) {
+        // Advance before sending: a client connecting meanwhile is replayed
+        // up to here, and a duplicate id is better than a missed event
+        portENTER_CRITICAL(&eventMux);
+        uint32_t id = pushedId < newestId ? ++pushedId : 0;
+        portEXIT_CRITICAL(&eventMux);
+        if (id == 0) return;
+        LoggedEvent event;
+        if (!copyEvent(id, event)) continue;
+        // AsyncTCP adds and deletes clients from its own task
+        AsyncWebLockGuard lock(eventSource.clientsLock());
+        if (eventSource.count() > 0) eventSource.send(event.data, EVENT_NAMES[event.type], wireId(event.id));
+    }
+}
+
+void grindEventPublish(GrindEventType type, const char *format, ...) {
+    char data[GRIND_EVENT_DATA];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(data, sizeof(data), format, args);
+    va_end(args);
+
+    portENTER_CRITICAL(&eventMux);
+    uint32_t id = ++newestId;
+    LoggedEvent &slot = eventLog[id % GRIND_EVENT_LOG];
+    slot.id = id;
+    slot.type = type;
+    memcpy(slot.data, data, sizeof(data));
+    portEXIT_CRITICAL(&eventMux);
+    LOGI(TAG_WEB, "Event %u %s %s", id, EVENT_NAMES[type], data);
+}
+
+uint32_t grindEventsPublished() {
+    portENTER_CRITICAL(&eventMux);
+    uint32_t id = newestId;
+    portEXIT_CRITICAL(&eventMux);
+    return id;
+}
@@ -0,0 +1,167 @@
+#include "grind_trace.hpp"
+#include "config.hpp"
+#include "scale.hpp"
+#include "log.hpp"
+#include <LittleFS.h>
+#include <atomic>
+
+extern double scaleFactor;
+
+// The scale task fills traceBuffer while a grind runs. When the grind is over
+// the finished trace is handed to grindTraceService() through pendingBytes;
+// until it has been written no new trace is started, so the buffer is never
+// shared. Writing to flash can take tens of milliseconds and must not stall
+// the scale task, hence the hand-off.
+static uint8_t traceBuffer[TRACE_BUFFER_BYTES];
+static GrindTraceWriter traceWriter;
+static std::atomic<size_t> pendingBytes(0);
+
+static bool traceMounted = false;
+static uint32_t newestShotId = 0; // 0 = no trace stored yet
+static uint32_t nextShotId = 1;
+
+static void slotPath(uint32_t shotId, char *path, size_t size) {
+    snprintf(path, size, TRACE_DIR "/%02u.bin", (unsigned)(shotId % TRACE_SLOTS));
+}
+
+static bool readHeader(uint32_t shotId, GrindTraceHeader &hdr) {
+    char path[32];
+    slotPath(shotId, path, sizeof(path));
+    if (!LittleFS.exists(path)) return false;
+    File f = LittleFS.open(path, "r");
+    if (!f) return false;
+    bool ok = f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) && hdr.magic == GRIND_TRACE_MAGIC;
+    f.close();
+    return ok;
+}
+
+void setupGrindTrace() {
+    if (!GRIND_TRACE_ENABLED) return;
+    if (!LittleFS.begin(true)) {
+        Serial.println("[Trace] LittleFS mount failed, grind traces disabled");
+        return;
+    }
+    if (!LittleFS.exists(TRACE_DIR)) LittleFS.mkdir(TRACE_DIR);
+
+    // Shot ids are monotonic, the newest stored trace tells where to continue
+    for (uint32_t slot = 0; slot < TRACE_SLOTS; ++slot) {
+        GrindTraceHeader hdr;
+        if (readHeader(slot, hdr) && hdr.shotId > newestShotId) {
+            newestShotId = hdr.shotId;
+        }
+    }
+    nextShotId = newestShotId + 1;
+    traceMounted = true;
+    Serial.printf("[Trace] Recorder ready, next shot #%u (%u/%u KB used)\n", nextShotId,
+                  (unsigned)(LittleFS.usedBytes() / 1024), (unsigned)(LittleFS.totalBytes() / 1024));
+}
+
+static void finishTrace() {
+    double settled;
+    if (grindSettledWeight(settled)) traceWriter.setSettled((int32_t)lround(settled * 1000.0));
+    size_t size = traceWriter.finish();
+    traceWriter.reset();
+    nextShotId++;
+    pendingBytes.store(size);
+}
+
+void grindTraceSample(uint32_t timeMs, long raw1, long raw2, double fusedGrams, int state) {
+    if (!traceMounted) return;
+
+    bool grinding = state == STATUS_GRINDING_IN_PROGRESS || state == STATUS_GRINDING_FINISHED ||
+                    state == STATUS_GRINDING_FAILED;
+    if (!traceWriter.active()) {
+        // A grind only starts a trace once the previous one reached flash
+        if (state != STATUS_GRINDING_IN_PROGRESS || pendingBytes.load() != 0) return;
+        GrindTraceHeader info = {};
+        info.shotId = nextShotId;
+        info.offset1 = (int32_t)loadcell.get_offset();
+        info.offset2 = (int32_t)loadcell2_offset;
+        info.factor1 = (float)scaleFactor;
+        info.factor2 = (float)scaleFactor2;
+        info.targetG = grindSession.target();
+        info.cupG = (float)cupWeightEmpty;
+        traceWriter.begin(traceBuffer, sizeof(traceBuffer), info);
+    }
+    if (!grinding) {
+        // Cup removed / back to the menu: the shot is complete
+        finishTrace();
+        return;
+    }
+
+    GrindTraceSample sample;
+    sample.timeMs = timeMs;
+    sample.raw1 = (int32_t)raw1;
+    sample.raw2 = (int32_t)raw2;
+    sample.fusedMg = (int32_t)lround(fusedGrams * 1000.0);
+    sample.state = (uint8_t)state;
+    traceWriter.append(sample); // once full the trace is flagged truncated
+
+    // A failed grind stays in that state until the user resets it; one
+    // sample of it is enough to tell how the shot ended
+    if (state == STATUS_GRINDING_FAILED) finishTrace();
+}
+
+void grindTraceService() {
+    size_t size = pendingBytes.load();
+    if (size == 0) return;
+
+    GrindTraceHeader hdr;
+    memcpy(&hdr, traceBuffer, sizeof(hdr));
+    char path[32];
+    slotPath(hdr.shotId, path, sizeof(path));
+    File f = LittleFS.open(path, "w");
+    size_t written = f ? f.write(traceBuffer, size) : 0;
+    if (f) f.close();
+    if (written == size) {
+        newestShotId = hdr.shotId;
+        LOGI(TAG_TRACE, "Shot #%u saved: %u samples, %u bytes%s", hdr.shotId, hdr.sampleCount,
+             (unsigned)size, (hdr.flags & GRIND_TRACE_FLAG_TRUNCATED) ? " (truncated)" : "");
+    } else {
+        LittleFS.remove(path); // never leave a partial trace behind
+        LOGE(TAG_TRACE, "Failed to save shot #%u (%u of %u bytes written)", hdr.shotId,
+             (unsigned)written, (unsigned)size);
+    }
+    pendingBytes.store(0);
+}
+
+void grindTraceDump(Stream &out) {
+    if (!traceMounted || newestShotId == 0) {
+        out.println("[Trace] No traces stored");
+        return;
+    }
+    // Oldest first; every line is "TRACE <shotId> <hex bytes>", one
+    // "TRACE <shotId> END" closes a shot
+    uint32_t oldest = newestShotId >= TRACE_SLOTS ? newestShotId - TRACE_SLOTS + 1 : 1;
+    for (uint32_t shotId = oldest; shotId <= newestShotId; ++shotId) {
+        GrindTraceHeader hdr;
+        if (!readHeader(shotId, hdr) || hdr.shotId != shotId) continue;
+        char path[32];
+        slotPath(shotId, path, sizeof(path));
+        File f = LittleFS.open(path, "r");
+        if (!f) continue;
+        uint8_t chunk[32];
+        size_t n;
+        while ((n = f.read(chunk, sizeof(chunk))) > 0) {
+            out.printf("TRACE %u ", shotId);
+            for (size_t i = 0; i < n; ++i) out.printf("%02x", chunk[i]);
+            out.println();
+        }
+        f.close();
+        out.printf("TRACE %u END\n", shotId);
+    }
+}
+
+size_t grindTraceLoad(uint8_t age, uint8_t *buffer, size_t capacity) {
+    if (!traceMounted || age >= TRACE_SLOTS || newestShotId <= age) return 0;
+    uint32_t shotId = newestShotId - age;
+    GrindTraceHeader hdr;
+    if (!readHeader(shotId, hdr) || hdr.shotId != shotId) return 0;
+    char path[32];
+    slotPath(shotId, path, sizeof(path));
+    File f = LittleFS.open(path, "r");
+    if (!f) return 0;
+    size_t size = f.read(buffer, capacity);
+    f.close();
+    return size;
+}
@@ -0,0 +1,216 @@
+#include "log.hpp"
+#include "config.hpp"
+#include <stdarg.h>
+
+TaskHandle_t LogTask = nullptr;
+
+static const char *const TAG_NAMES[TAG_COUNT] = {
+    "Scale", "HX711", "Tare", "AZT", "Predictor", "Trace", "UI", "System", "Web"
+};
+static const char *const LEVEL_NAMES[] = { "none", "error", "warn", "info", "debug" };
+
+struct TagState {
+    uint16_t ratePerSecond; // 0 = unlimited
+    float tokens;
+    uint32_t lastRefillMs;
+    uint32_t suppressed;    // since the last message that got through
+};
+
+// The level array is read without the lock on every call; a stale level for
+// one message is harmless
+static volatile LogLevel tagLevel[TAG_COUNT];
+static TagState tags[TAG_COUNT];
+
+// Byte ring of complete, formatted lines. Writers copy whole lines under the
+// lock so lines from different tasks never interleave.
+static char ring[LOG_RING_BYTES];
+static size_t ringHead = 0; // next write position
+static size_t ringUsed = 0;
+static portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+static LogStats stats = {0, 0, 0, 0, 0};
+
+bool logEnabled(LogTag tag, LogLevel level) {
+    return tag < TAG_COUNT && level != LOG_NONE && level <= tagLevel[tag];
+}
+
+// Token bucket with a burst of one second worth of messages. Returns the
+// number of messages suppressed before this one, or -1 if this one is too.
+static int32_t takeToken(TagState &state, uint32_t now) {
+    if (state.ratePerSecond == 0) {
+        uint32_t suppressed = state.suppressed;
+        state.suppressed = 0;
+        return (int32_t)suppressed;
+    }
+    state.tokens += (now - state.lastRefillMs) * state.ratePerSecond / 1000.0f;
+    if (state.tokens > state.ratePerSecond) state.tokens = state.ratePerSecond;
+    state.lastRefillMs = now;
+    if (state.tokens < 1.0f) {
+        state.suppressed++;
+        stats.suppressed++;
+        return -1;
+    }
+    state.tokens -= 1.0f;
+    uint32_t suppressed = state.suppressed;
+    state.suppressed = 0;
+    return (int32_t)suppressed;
+}
+
+static bool pushLine(const char *line, size_t length) {
+    if (length > LOG_RING_BYTES - ringUsed) {
+        stats.droppedFull++;
+        return false;
+    }
+    size_t first = LOG_RING_BYTES - ringHead;
+    if (first > length) first = length;
+    memcpy(ring + ringHead, line, first);
+    memcpy(ring, line + first, length - first);
+    ringHead = (ringHead + length) % LOG_RING_BYTES;
+    ringUsed += length;
+    if (ringUsed > stats.highWater) stats.highWater = ringUsed;
+    stats.written++;
+    return true;
+}
+
+void logWrite(LogTag tag, LogLevel level, const char *format, ...) {
+    if (!logEnabled(tag, level)) return;
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&logMux);
+    int32_t suppressed = takeToken(tags[tag], now);
+    portEXIT_CRITICAL(&logMux);
+    if (suppressed < 0) return;
+
+    char line[LOG_LINE_MAX];
+    int length = snprintf(line, sizeof(line), "%lu [%s] %s", (unsigned long)now, TAG_NAMES[tag],
+                          level == LOG_ERROR ? "ERROR: " : level == LOG_WARN ? "WARN: " : "");
+    va_list args;
+    va_start(args, format);
+    length += vsnprintf(line + length, sizeof(line) - length, format, args);
+    va_end(args);
+    if (length > (int)sizeof(line) - 2) length = sizeof(line) - 2; // truncated, keep room for the newline
+    if (suppressed > 0) {
+        length += snprintf(line + length, sizeof(line) - length, " (+%ld suppressed)", (long)suppressed);
+        if (length > (int)sizeof(line) - 2) length = sizeof(line) - 2;
+    }
+    line[length++] = '\n';
+
+    portENTER_CRITICAL(&logMux);
+    bool wasEmpty = ringUsed == 0;
+    bool queued = pushLine(line, length);
+    portEXIT_CRITICAL(&logMux);
+    if (queued && wasEmpty && LogTask) xTaskNotifyGive(LogTask);
+}
+
+// Drains the ring in chunks; the UART write may block, but only this task
+static void logDrainLoop(void *parameter) {
+    char chunk[256];
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, 100 / portTICK_PERIOD_MS);
+        for (;;) {
+            portENTER_CRITICAL(&logMux);
+            size_t tail = (ringHead + LOG_RING_BYTES - ringUsed) % LOG_RING_BYTES;
+            size_t length = ringUsed < sizeof(chunk) ? ringUsed : sizeof(chunk);
+            size_t first = LOG_RING_BYTES - tail;
+            if (first > length) first = length;
+            memcpy(chunk, ring + tail, first);
+            memcpy(chunk + first, ring, length - first);
+            ringUsed -= length;
+            stats.bytes += length;
+            portEXIT_CRITICAL(&logMux);
+            if (length == 0) break;
+            Serial.write((const uint8_t *)chunk, length);
+        }
+    }
+}
+
+void logSetLevel(LogTag tag, LogLevel level) {
+    if (tag < TAG_COUNT) tagLevel[tag] = level;
+}
+
+void logSetRate(LogTag tag, uint16_t perSecond) {
+    if (tag >= TAG_COUNT) return;
+    portENTER_CRITICAL(&logMux);
+    tags[tag].ratePerSecond = perSecond;
+    tags[tag].tokens = perSecond;
+    portEXIT_CRITICAL(&logMux);
+}
+
+LogStats logGetStats() {
+    portENTER_CRITICAL(&logMux);
+    LogStats copy = stats;
+    portEXIT_CRITICAL(&logMux);
+    return copy;
+}
+
+void setupLog() {
+    for (int i = 0; i < TAG_COUNT; ++i) {
+        tagLevel[i] = LOG_INFO;
+        tags[i] = {0, 0, 0, 0};
+    }
+    // Per-sample readings are only useful while debugging the load cells
+    tagLevel[TAG_HX711] = LOG_WARN;
+    logSetRate(TAG_HX711, 20);
+    logSetRate(TAG_SCALE, 10);
+    logSetRate(TAG_UI, 10);
+    xTaskCreatePinnedToCore(logDrainLoop, "Log", TASK_LOG_STACK, NULL, TASK_LOG_PRIORITY, &LogTask, TASK_LOG_CORE);
+}
+
+static int findTag(const String &name) {
+    for (int i = 0; i < TAG_COUNT; ++i) {
+        if (name.equalsIgnoreCase(TAG_NAMES[i])) return i;
+    }
+    return name.equalsIgnoreCase("all") ? TAG_COUNT : -1;
+}
+
+static int findLevel(const String &name) {
+    for (int i = 0; i <= LOG_DEBUG; ++i) {
+        if (name.equalsIgnoreCase(LEVEL_NAMES[i])) return i;
+    }
+    return -1;
+}
+
+void logCommand(const String &args, Stream &out) {
+    String rest = args;
+    rest.trim();
+    if (rest.length() == 0) {
+        LogStats s = logGetStats();
+        out.println("\n=== Log ===");
+        for (int i = 0; i < TAG_COUNT; ++i) {
+            out.printf("%-10s %-6s %s\n", TAG_NAMES[i], LEVEL_NAMES[tagLevel[i]],
+                       tags[i].ratePerSecond ? (String(tags[i].ratePerSecond) + "/s").c_str() : "unlimited");
+        }
+        out.printf("Queued %u, dropped (full) %u, suppressed (rate) %u, %u bytes out, ring high water %u/%u\n",
+                   s.written, s.droppedFull, s.suppressed, s.bytes, s.highWater, LOG_RING_BYTES);
+        out.println("Usage: L <tag|all> <none|error|warn|info|debug>  |  L <tag|all> rate <n/s, 0=unlimited>");
+        out.println("===========\n");
+        return;
+    }
+
+    int space = rest.indexOf(' ');
+    int tag = findTag(space < 0 ? rest : rest.substring(0, space));
+    String value = space < 0 ? String() : rest.substring(space + 1);
+    value.trim();
+    if (tag < 0 || value.length() == 0) {
+        out.println("[Log] Unknown tag or missing value, 'L' lists tags");
+        return;
+    }
+    int first = tag == TAG_COUNT ? 0 : tag;
+    int last = tag == TAG_COUNT ? TAG_COUNT - 1 : tag;
+    if (value.startsWith("rate")) {
+        long rate = value.substring(4).toInt();
+        if (rate < 0 || rate > 1000) {
+            out.println("[Log] Rate must be 0..1000 messages/s");
+            return;
+        }
+        for (int i = first; i <= last; ++i) logSetRate((LogTag)i, (uint16_t)rate);
+        out.printf("[Log] Rate set to %ld/s\n", rate);
+        return;
+    }
+    int level = findLevel(value);
+    if (level < 0) {
+        out.println("[Log] Unknown level");
+        return;
+    }
+    for (int i = first; i <= last; ++i) logSetLevel((LogTag)i, (LogLevel)level);
+    out.printf("[Log] Level set to %s\n", LEVEL_NAMES[level]);
+}
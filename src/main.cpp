@@ -6,17 +6,20 @@
 #include "display.hpp"
 #include "scale.hpp"
 #include "config.hpp"
-// #include "web_server.hpp"
+#include "acquisition.hpp"
+#include "grind_trace.hpp"
+#include "replay.hpp"
+#include "log.hpp"
+#include "settings.hpp"
+#include "task_monitor.hpp"
+#include "relay_test.hpp"
+#include "weight_filter.hpp"
+#include "web_server.hpp"
 
 // Definitions of global variables (memory allocated here)
 Preferences preferences;             // Preferences object
 HX711 loadcell;                      // HX711 load cell object
 HX711 loadcell2;                     // Optional second HX711 load cell object
-// Kalman filter for weight smoothing. Tuned for more responsiveness: higher processNoise
-// and lower measurementNoise compared to previous conservative defaults.
-// Make Kalman more responsive to reduce settle time after events like grinding.
-// Increasing processNoise makes the filter trust the model less and follow measurements faster.
-SimpleKalmanFilter kalmanFilter(1.0, 0.01, 0.01); // (processNoise, measurementNoise, estimationError)
 
 // Secondary scale factor (loaded from preferences in setupScale)
 double scaleFactor2 = LOADCELL2_SCALE_FACTOR;
@@ -58,6 +61,7 @@ void processSerialCommands() {
             // Tare command - capture current raw average for selected sensor
             Serial.println("\n[CAL] Taring - please wait...");
             if (sensor == 2) {
+                Hx711Guard guard;
                 if (loadcell2.wait_ready_timeout(500)) {
                     calibration_tare_raw2 = loadcell2.read_average(20);
                     Serial.printf("[CAL] Sensor2 tare captured: %ld counts\n", calibration_tare_raw2);
@@ -66,6 +70,7 @@ void processSerialCommands() {
                     Serial.println("[CAL] Error: HX711(sensor2) not ready for tare");
                 }
             } else {
+                Hx711Guard guard;
                 if (loadcell.wait_ready_timeout(500)) {
                     calibration_tare_raw = loadcell.read_average(20);
                     Serial.printf("[CAL] Sensor1 tare captured: %ld counts\n", calibration_tare_raw);
@@ -131,6 +136,7 @@ void processSerialCommands() {
                 }
 
                 Serial.printf("[CAL] Sensor2: Using %.2fg as reference. Waiting for stable reading...\n", calibration_known_weight2);
+                Hx711Guard guard;
                 if (loadcell2.wait_ready_timeout(500)) {
                     long raw_with_weight = loadcell2.read_average(20);
                     long raw_diff = raw_with_weight - calibration_tare_raw2;
@@ -152,9 +158,8 @@ void processSerialCommands() {
                     loadcell2.set_scale(scaleFactor2);
 
                     // Save to preferences
-                    preferences.begin("scale", false);
-                    preferences.putDouble("calibration2", (double)scaleFactor2);
-                    preferences.end();
+                    settingsTouch(SET_CALIBRATION2);
+                    settingsFlush();
 
                     // Block AZT briefly after calibration to avoid auto-zero fighting the new factor
                     aztBlockUntil = millis() + 10000UL; // 10 seconds
@@ -183,6 +188,7 @@ void processSerialCommands() {
 
                 Serial.printf("[CAL] Using %.2fg as reference. Waiting for stable reading...\n", calibration_known_weight);
 
+                Hx711Guard guard;
                 if (loadcell.wait_ready_timeout(500)) {
                     long raw_with_weight = loadcell.read_average(20);
                     long raw_diff = raw_with_weight - calibration_tare_raw;
@@ -205,9 +211,8 @@ void processSerialCommands() {
                     loadcell.set_scale(scaleFactor);
 
                     // Save to preferences
-                    preferences.begin("scale", false);
-                    preferences.putDouble("calibration", (double)scaleFactor);
-                    preferences.end();
+                    settingsTouch(SET_CALIBRATION);
+                    settingsFlush();
 
                     // Block AZT briefly after calibration to avoid auto-zero fighting the new factor
                     aztBlockUntil = millis() + 10000UL; // 10 seconds
@@ -235,6 +240,34 @@ void processSerialCommands() {
             Serial.printf("Calibration mode (s2): %s\n", calibration_mode2 ? "active" : "inactive");
             Serial.printf("Tare captured (s1): %s\n", calibration_tare_raw != 0 ? "yes" : "no");
             Serial.printf("Tare captured (s2): %s\n", calibration_tare_raw2 != 0 ? "yes" : "no");
+            Serial.printf("Predictor: latency %.3fs, in-flight %.2fg (%s)\n", grindPredictor.latency(), grindPredictor.inFlight(),
+                          PREDICTIVE_STOP ? "enabled" : "disabled");
+            {
+                AcquisitionStats acq = acquisitionGetStats();
+                Serial.printf("Acquisition: %u samples, %u dropped, %u missed edges, %u pair timeouts\n",
+                              acq.intervals.samples(), acq.dropped, acq.missedEdges, acq.pairTimeouts);
+                static const char *const rateNames[] = {"10 SPS", "80 SPS", "powered down"};
+                Serial.printf("HX711 rate: %s, %u switches, %u settling conversions discarded\n", rateNames[acq.rate],
+                              acq.rateSwitches, acq.settling);
+                if (acq.intervals.intervals() > 0) {
+                    Serial.printf("Sample interval: last %.1fms min %.1fms max %.1fms mean %.2fms jitter %.2fms\n",
+                                  acq.intervals.lastUs() / 1000.0, acq.intervals.minUs() / 1000.0,
+                                  acq.intervals.maxUs() / 1000.0, acq.intervals.meanUs() / 1000.0,
+                                  acq.intervals.jitterUs() / 1000.0);
+                }
+            }
+            {
+                DisplayStats ds = displayGetStats();
+                Serial.printf("Display: %u frames (%u unchanged), %u tiles sent, %u B/s\n", ds.frames, ds.unchangedFrames,
+                              ds.tilesSent, ds.bytesPerSecond);
+                Serial.printf("Display wakeups: %u notified, %u deadline, %u coalesced\n", ds.eventWakeups,
+                              ds.deadlineWakeups, ds.coalescedEvents);
+            }
+            {
+                SettingsStats st = settingsGetStats();
+                Serial.printf("Settings: %u changes, %u NVS writes in %u flushes, %u unchanged%s\n", st.touches, st.writes,
+                              st.flushes, st.unchanged, settingsDirty() ? " (pending)" : "");
+            }
             Serial.println("====================\n");
             break;
         }
@@ -245,6 +278,7 @@ void processSerialCommands() {
                     Serial.println("[RAW] Sensor2 not configured");
                     break;
                 }
+                Hx711Guard guard;
                 if (loadcell2.wait_ready_timeout(1000)) {
                     long raw2 = loadcell2.read_average(30);
                     long off2 = loadcell2_offset;
@@ -254,6 +288,7 @@ void processSerialCommands() {
                     Serial.println("[RAW] HX711(sensor2) not ready for raw read");
                 }
             } else {
+                Hx711Guard guard;
                 if (loadcell.wait_ready_timeout(1000)) {
                     long raw1 = loadcell.read_average(30);
                     long off1 = loadcell.get_offset();
@@ -268,26 +303,15 @@ void processSerialCommands() {
         case 'T': {
             // Combined tare: tare primary sensor (request) and set offset for sensor2
             Serial.println("[CAL] Combined tare: taring primary and capturing sensor2 offset...");
-            // Request tare for primary (handled in updateScale)
-            tareScale();
-            // Give updateScale some time to perform the tare
-            delay(700);
-            // Now capture sensor2 offset if available
+            // Both offsets come from the same samples (handled in updateScale)
+            if (!tareScale() || !tareWait(TARE_TIMEOUT_MS)) {
+                Serial.println("[CAL] Error: tare did not complete");
+                break;
+            }
+            settingsFlush();
+            Serial.printf("[CAL] Sensor1 offset set to %ld and saved to NVS\n", loadcell_offset);
             if (LOADCELL2_DOUT_PIN != -1) {
-                if (loadcell2.wait_ready_timeout(500)) {
-                    long off2 = loadcell2.read_average(20);
-                    loadcell2.set_offset(off2);
-                    // Update runtime variable used by scale.cpp and persist
-                    loadcell2_offset = off2;
-                    preferences.begin("scale", false);
-                    preferences.putLong("offset2", off2);
-                    preferences.end();
-                    Serial.printf("[CAL] Sensor2 offset set to %ld and saved to NVS\n", off2);
-                    // Block AZT briefly after setting offsets
-                    aztBlockUntil = millis() + 10000UL;
-                } else {
-                    Serial.println("[CAL] Error: HX711(sensor2) not ready to capture offset");
-                }
+                Serial.printf("[CAL] Sensor2 offset set to %ld and saved to NVS\n", loadcell2_offset);
             } else {
                 Serial.println("[CAL] No sensor2 configured");
             }
@@ -300,13 +324,13 @@ void processSerialCommands() {
                 break;
             }
             Serial.println("[CAL] Capturing sensor2 offset (this will set offset2)...");
+            Hx711Guard guard;
             if (loadcell2.wait_ready_timeout(500)) {
                 long off2 = loadcell2.read_average(20);
                 loadcell2.set_offset(off2);
                 loadcell2_offset = off2; // keep runtime in sync
-                preferences.begin("scale", false);
-                preferences.putLong("offset2", off2);
-                preferences.end();
+                settingsTouch(SET_OFFSET2);
+                settingsFlush();
                 Serial.printf("[CAL] Sensor2 offset set to %ld and saved to NVS\n", off2);
                 // Block AZT briefly after setting offsets
                 aztBlockUntil = millis() + 10000UL;
@@ -315,6 +339,46 @@ void processSerialCommands() {
             }
             break;
         }
+        case 'D': {
+            // Dump recorded grind traces; decode with tools/decode_traces.py
+            grindTraceDump(Serial);
+            break;
+        }
+        case 'L': {
+            // Log levels and rate limits, e.g. "L hx711 debug", "L scale rate 5"
+            logCommand(line.substring(1), Serial);
+            break;
+        }
+        case 'r': {
+            // Replay a stored trace through the grind logic: 'r' newest, 'r3' three shots back
+            replayStoredTrace((uint8_t)line.substring(1).toInt(), Serial);
+            break;
+        }
+        case 'X': {
+            // Relay characterisation: grind pulses into the cup, fit latency and in-flight mass
+            runRelayTest(Serial);
+            break;
+        }
+        case 'F': {
+            // Weight filter profiles and per-stage metrics, e.g. "F idle median:5 kalman"
+            weightFilterCommand(line.substring(1), Serial);
+            break;
+        }
+        case 'B': {
+            // Cycles per sample of the double vs fixed-point weight path and the filter
+            weightPathBenchmark(Serial);
+            break;
+        }
+        case 'P': {
+            // Task table: cores, priorities, stack high-water marks, CPU share, sample latency
+            taskMonitorReport(Serial);
+            break;
+        }
+        case 'W': {
+            // Web server address and weight stream statistics
+            webServerReport(Serial);
+            break;
+        }
         case 'h': {
             // Help
             Serial.println("\n=== Calibration Commands ===");
@@ -325,6 +389,14 @@ void processSerialCommands() {
             Serial.println("w48.1 or w1 48.1 - Provide known weight for sensor1");
             Serial.println("w2 48.1 or w248.1 - Provide known weight for sensor2");
             Serial.println("s  - Show current status");
+            Serial.println("D  - Dump recorded grind traces");
+            Serial.println("L  - Log status; L <tag|all> <level> or L <tag|all> rate <n>");
+            Serial.println("r  - Replay the newest trace through the grind logic (r<n>: n shots back)");
+            Serial.println("X  - Relay test: pulse the grinder into the cup and fit the stop model");
+            Serial.println("F  - Weight filter profiles and metrics; F <idle|grinding|finished> <spec>");
+            Serial.println("B  - Benchmark the counts-to-grams paths and the weight filter (cycles/sample)");
+            Serial.println("P  - Task CPU usage, stack high-water marks and sample latency");
+            Serial.println("W  - Web server address and weight stream statistics");
             Serial.println("h  - Show this help");
             Serial.println("============================\n");
             break;
@@ -332,24 +404,18 @@ void processSerialCommands() {
         case 'R': {
             // Reset scale calibration and offsets to defaults (destructive)
             Serial.println("[CAL] RESET: Clearing saved calibration and offsets in NVS and restoring defaults...");
-            preferences.begin("scale", false);
-            preferences.remove("calibration");
-            preferences.remove("calibration2");
-            preferences.remove("offset1");
-            preferences.remove("offset2");
-            preferences.remove("shotOffset");
-            preferences.remove("shotCount");
-            // Re-write sane defaults so runtime picks them up immediately
-            preferences.putDouble("calibration", (double)LOADCELL_SCALE_FACTOR);
-            if (LOADCELL2_DOUT_PIN != -1) preferences.putDouble("calibration2", (double)LOADCELL2_SCALE_FACTOR);
-            preferences.end();
+            settingsReset(SET_CALIBRATION);
+            settingsReset(SET_CALIBRATION2);
+            settingsReset(SET_OFFSET1);
+            settingsReset(SET_OFFSET2);
+            settingsReset(SET_SHOT_OFFSET);
+            settingsReset(SET_SHOT_COUNT);
+            settingsFlush();
 
             // Apply defaults to runtime immediately
-            scaleFactor = (double)LOADCELL_SCALE_FACTOR;
             loadcell.set_scale(scaleFactor);
             Serial.printf("[CAL] scaleFactor reset to default: %.6f\n", scaleFactor);
             if (LOADCELL2_DOUT_PIN != -1) {
-                scaleFactor2 = (double)LOADCELL2_SCALE_FACTOR;
                 loadcell2.set_scale(scaleFactor2);
                 Serial.printf("[CAL] scaleFactor2 reset to default: %.6f\n", scaleFactor2);
             }
@@ -428,6 +494,7 @@ void processSerialCommands() {
             // Prompt: user should have placed the known mass already
             Serial.println("[CAL] Reading sensors for calibration (ensure mass is placed and stable)...");
             // Read averages
+            Hx711Guard guard; // keep the acquisition task off the shared SCK line
             if (!loadcell.wait_ready_timeout(1000)) {
                 Serial.println("[CAL] Error: HX711(sensor1) not ready");
                 break;
@@ -466,17 +533,14 @@ void processSerialCommands() {
             // Apply multiplier to both scale factors (keep relative split)
             scaleFactor = scaleFactor * multiplier;
             loadcell.set_scale(scaleFactor);
-            preferences.begin("scale", false);
-            preferences.putDouble("calibration", (double)scaleFactor);
-            preferences.end();
+            settingsTouch(SET_CALIBRATION);
 
             if (LOADCELL2_DOUT_PIN != -1) {
                 scaleFactor2 = scaleFactor2 * multiplier;
                 loadcell2.set_scale(scaleFactor2);
-                preferences.begin("scale", false);
-                preferences.putDouble("calibration2", (double)scaleFactor2);
-                preferences.end();
+                settingsTouch(SET_CALIBRATION2);
             }
+            settingsFlush();
 
             // Block AZT briefly after guided combined calibration so AZT does not undo calibration
             aztBlockUntil = millis() + 10000UL;
@@ -504,8 +568,9 @@ void processSerialCommands() {
 
 void setup() {
     Serial.begin(115200);
+    setupLog();
     
-    // WiFi and Bluetooth disabled - fully commented out
+    // WiFi stays off unless WEB_SERVER_ENABLED (see setupWebServer below)
     // WiFi.mode(WIFI_OFF);
     // WiFi.disconnect(true);
 // #ifdef ARDUINO_ARCH_ESP32
@@ -514,11 +579,16 @@ void setup() {
     
     // Setup other components
     setupDisplay();
+    setupGrindTrace();
     setupScale();
-    // setupWebServer(); // Disabled
+#if WEB_SERVER_ENABLED
+    setupWebServer();
+#endif
 }
 
 void loop() {
     processSerialCommands();
+    grindTraceService();
+    settingsService();
     delay(100);
 }
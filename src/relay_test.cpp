@@ -0,0 +1,107 @@
+#include "relay_test.hpp"
+#include "config.hpp"
+#include "scale.hpp"
+#include "scale_hal.hpp"
+#include "display.hpp"
+#include "acquisition.hpp"
+#include "settings.hpp"
+#include <RelayCharacterizer.h>
+
+extern bool grinderActive;
+
+static RelayCharacterizer characterizer;
+
+static constexpr uint32_t longestPulseMs() {
+    constexpr uint32_t pulseMs[] = RELAY_TEST_PULSES_MS;
+    uint32_t longest = 0;
+    for (uint32_t ms : pulseMs) longest = ms > longest ? ms : longest;
+    return longest;
+}
+// The scale samples at 80 SPS during the test (updateSampleRate); every
+// pulse and its settle time must fit the characterizer's buffer, with 10 %
+// margin for the delay() overrun and the oscillator tolerance
+static_assert((uint64_t)(longestPulseMs() + RELAY_TEST_SETTLE_MS) * 1100 / HX711_PERIOD_FAST_US <=
+                  RelayCharacterizer::MAX_SAMPLES,
+              "RelayCharacterizer::MAX_SAMPLES too small for RELAY_TEST_PULSES_MS + RELAY_TEST_SETTLE_MS");
+// The scale task adds samples while the serial task drives the pulses
+static portMUX_TYPE relayTestMux = portMUX_INITIALIZER_UNLOCKED;
+
+void relayTestSample(uint32_t timestampMs, float grams) {
+    portENTER_CRITICAL(&relayTestMux);
+    characterizer.addSample(timestampMs, grams);
+    portEXIT_CRITICAL(&relayTestMux);
+}
+
+static bool cupOnScale() {
+    return scaleReady && scaleWeight >= RELAY_TEST_MIN_CUP_G;
+}
+
+void runRelayTest(Stream &out) {
+    if (scaleStatus != STATUS_EMPTY || grinderActive) {
+        out.println("[Relay] The scale must be idle to run the relay test");
+        return;
+    }
+    if (!cupOnScale()) {
+        out.printf("[Relay] Put an empty cup (>= %dg) on the scale first\n", RELAY_TEST_MIN_CUP_G);
+        return;
+    }
+
+    // Own status so cup detection cannot start a grind between the pulses
+    scaleStatus = STATUS_RELAY_TEST;
+    displayNotify(DISPLAY_STATE);
+    portENTER_CRITICAL(&relayTestMux);
+    characterizer.reset();
+    portEXIT_CRITICAL(&relayTestMux);
+
+    const uint32_t pulseMs[] = RELAY_TEST_PULSES_MS;
+    const size_t pulseCount = sizeof(pulseMs) / sizeof(pulseMs[0]);
+    out.printf("[Relay] Running %u pulses, keep the cup in place...\n", pulseCount);
+    bool aborted = false;
+    for (size_t i = 0; i < pulseCount && i < RelayCharacterizer::MAX_PULSES; ++i) {
+        lastSignificantWeightChangeAt = millis(); // keep the display (and the status) awake
+
+        portENTER_CRITICAL(&relayTestMux);
+        characterizer.beginPulse(millis());
+        portEXIT_CRITICAL(&relayTestMux);
+        grinderRelay.set(true);
+        delay(pulseMs[i]);
+        grinderRelay.set(false);
+        uint32_t offMs = millis();
+        portENTER_CRITICAL(&relayTestMux);
+        characterizer.relayOff(offMs);
+        portEXIT_CRITICAL(&relayTestMux);
+
+        delay(RELAY_TEST_SETTLE_MS);
+        portENTER_CRITICAL(&relayTestMux);
+        RelayPulse pulse = characterizer.endPulse();
+        portEXIT_CRITICAL(&relayTestMux);
+
+        if (pulse.valid) {
+            out.printf("[Relay] Pulse %u: %lu ms on, flow at cut %.2fg/s, overshoot %.2fg, coast %lu ms\n", i + 1,
+                       (unsigned long)(pulse.offMs - pulse.onMs), pulse.flowAtOffGps, pulse.overshootG,
+                       (unsigned long)pulse.coastMs);
+        } else {
+            out.printf("[Relay] Pulse %u: too few samples or sample buffer full, ignored\n", i + 1);
+        }
+        if (!cupOnScale()) {
+            out.println("[Relay] Cup removed or scale not ready, test aborted");
+            aborted = true;
+            break;
+        }
+    }
+    scaleStatus = STATUS_EMPTY;
+    displayNotify(DISPLAY_STATE);
+    if (aborted) return;
+
+    RelayFit fit = characterizer.fit(grindPredictor.latency());
+    if (!fit.valid) {
+        out.println("[Relay] No usable pulses, model unchanged");
+        return;
+    }
+    out.printf("[Relay] Fit over %u pulses: latency %.3fs%s, in-flight %.2fg, rms error %.2fg\n", fit.pulses,
+               fit.latencyS, fit.latencyFitted ? "" : " (kept, flows too similar)", fit.inFlightG, fit.rmsErrorG);
+    out.printf("[Relay] Previous model: latency %.3fs, in-flight %.2fg\n", grindPredictor.latency(), grindPredictor.inFlight());
+    grindPredictorSetModel(fit.latencyS, fit.inFlightG);
+    settingsFlush();
+    out.printf("[Relay] Model applied and saved%s\n", PREDICTIVE_STOP ? "" : " (predictive stop is disabled in config)");
+}
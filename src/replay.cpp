@@ -0,0 +1,74 @@
+#include "replay.hpp"
+#include "config.hpp"
+#include "scale.hpp"
+#include "grind_trace.hpp"
+#include "weight_filter.hpp"
+#include <TraceReplay.h>
+#include <WeightFilter.h>
+
+// The scale task's grinding filter profile, seeded with the first sample
+// like the weight history so the estimate does not ramp up from zero
+class PipelineEstimator : public ReplayEstimator {
+public:
+    PipelineEstimator() {
+        char spec[96];
+        weightFilterGetProfile(FILTER_PROFILE_GRINDING, spec, sizeof(spec));
+        pipeline.configure(spec);
+    }
+    void reset() override { seeded = false; }
+    float update(uint32_t timestampMs, float fusedG) override {
+        if (!seeded) {
+            pipeline.reset(fusedG);
+            seeded = true;
+        }
+        return pipeline.update(timestampMs, fusedG);
+    }
+
+private:
+    FilterPipeline pipeline;
+    bool seeded = false;
+};
+
+void replayStoredTrace(uint8_t age, Stream &out) {
+    uint8_t *trace = (uint8_t *)malloc(TRACE_BUFFER_BYTES);
+    if (!trace) {
+        out.println("[Replay] Out of memory");
+        return;
+    }
+    size_t size = grindTraceLoad(age, trace, TRACE_BUFFER_BYTES);
+    if (size == 0) {
+        out.printf("[Replay] No stored trace %u shots back\n", age);
+        free(trace);
+        return;
+    }
+
+    GrindPredictor predictor = grindPredictorSnapshot();
+    PipelineEstimator estimator;
+    TraceReplay replay(predictor, estimator);
+    replay.setLimits(grindSession.getLimits());
+
+    int64_t t0 = esp_timer_get_time();
+    ReplayResult result = replay.run(trace, size);
+    int64_t elapsedUs = esp_timer_get_time() - t0;
+    GrindTraceHeader hdr;
+    memcpy(&hdr, trace, sizeof(hdr));
+    free(trace);
+
+    if (!result.valid) {
+        out.println("[Replay] Trace is corrupt");
+        return;
+    }
+    out.printf("[Replay] Shot #%u, target %.2fg, %u samples in %lld us\n", hdr.shotId, hdr.targetG,
+               result.samples, elapsedUs);
+    out.printf("[Replay] Recorded: stop at %d ms, settled %.2fg\n", result.recordedStopMs, result.recordedFinalG);
+    if (result.state == GrindSession::STOPPED) {
+        out.printf("[Replay] Replayed: stop at %d ms (%+d ms) at %.2fg, predicted final %.2fg%s\n",
+                   result.replayStopMs, result.replayStopMs - result.recordedStopMs, result.stopWeightG,
+                   result.predictedFinalG, result.predicted ? "" : " [threshold]");
+    } else if (result.state == GrindSession::FAILED) {
+        out.printf("[Replay] Replayed: failed at %d ms: %s\n", result.replayStopMs,
+                   GrindSession::failureName(result.failure));
+    } else {
+        out.println("[Replay] Replayed: no stop before the trace ended");
+    }
+}
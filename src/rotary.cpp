@@ -5,6 +5,11 @@
 #include "rotary.hpp"
 #include "display.hpp"
 #include "scale.hpp"
+#include "acquisition.hpp"
+#include "log.hpp"
+#include "settings.hpp"
+
+extern double scaleFactor;
 
 // Rotary encoder for user input
 AiEsp32RotaryEncoder rotaryEncoder = AiEsp32RotaryEncoder(
@@ -14,6 +19,8 @@ AiEsp32RotaryEncoder rotaryEncoder = AiEsp32RotaryEncoder(
     ROTARY_ENCODER_VCC_PIN,
     ROTARY_ENCODER_STEPS);
 
+TaskHandle_t UiTask = nullptr;
+
 // Vars
 int encoderDir = -1;   // Direction of the rotary encoder: 1 = normal, -1 = reversed
 int encoderValue = 0; // Current value of the rotary encoder
@@ -27,11 +34,12 @@ static void handleSingleClickTask(void *param) {
     // Ensure the task only acts if `scaleStatus` is valid for the menu
     if (*pendingFlag && scaleStatus == STATUS_EMPTY) {
         *pendingFlag = false;
-        Serial.println("Single click detected. Opening menu...");
+        LOGI(TAG_UI, "Single click detected. Opening menu...");
         scaleStatus = STATUS_IN_MENU;
         currentMenuItem = 0;
         rotaryEncoder.setAcceleration(0);
-        Serial.println("Entering Menu...");
+        LOGI(TAG_UI, "Entering Menu...");
+        displayNotify(DISPLAY_STATE);
     }
     vTaskDelete(NULL); // End the task
 }
@@ -49,7 +57,7 @@ void exitToMenu()
             scaleStatus = STATUS_IN_MENU;
         }
         currentSetting = -1;
-        Serial.println("Exiting to menu");
+        LOGI(TAG_UI, "Exiting to menu");
     }
     else if (scaleStatus == STATUS_IN_MENU)
     {
@@ -57,14 +65,14 @@ void exitToMenu()
             // Go back to main menu from submenu
             currentSubmenu = 0;
             currentSubmenuItem = 0;
-            Serial.println("Returning to main menu");
+            LOGI(TAG_UI, "Returning to main menu");
         } else {
             // Exit to empty state from main menu
             scaleStatus = STATUS_EMPTY;
             currentMenuItem = 0;
             currentSubmenu = 0;
             currentSubmenuItem = 0;
-            Serial.println("Exiting to empty state");
+            LOGI(TAG_UI, "Exiting to empty state");
         }
     }
 }
@@ -76,6 +84,18 @@ static void unlockDisplayTask(void *param) {
     delay(2000); // Wait 2 seconds
     displayLock = false;
     showingTaringMessage = false;
+    displayNotify(DISPLAY_STATE);
+    vTaskDelete(NULL);
+}
+
+// Keeps "Taring..." up until the new zero has settled (or the tare gave up)
+static void unlockAfterTareTask(void *param) {
+    if (!tareWait(TARE_TIMEOUT_MS)) {
+        LOGW(TAG_UI, "Tare did not complete");
+    }
+    displayLock = false;
+    showingTaringMessage = false;
+    displayNotify(DISPLAY_STATE);
     vTaskDelete(NULL);
 }
 
@@ -90,7 +110,7 @@ void rotary_onButtonClick()
     // pending). This moves the adjustment trigger from the timer to an
     // explicit user action.
     if (scaleStatus == STATUS_GRINDING_FINISHED) {
-        Serial.println("Button press while in FINISHED state: running shotOffset adjustment and exiting...");
+        LOGI(TAG_UI, "Button press while in FINISHED state: running shotOffset adjustment and exiting...");
         applyShotOffsetAdjustmentOnExit();
         // Reset grinding timestamps and transition to empty state
         startedGrindingAt = 0;
@@ -118,7 +138,7 @@ void rotary_onButtonClick()
     if (clickCount == 2)
     {
         menuPending = false; // Cancel pending single click action
-        Serial.println("Double press detected. Taring scale...");
+        LOGI(TAG_UI, "Double press detected. Taring scale...");
         
         // Reset click count immediately to prevent loops
         clickCount = 0;
@@ -129,7 +149,7 @@ void rotary_onButtonClick()
             currentMenuItem = 0;
             currentSetting = -1;
             rotaryEncoder.setAcceleration(100); // Restore encoder acceleration
-            Serial.println("Exited menu due to tare operation");
+            LOGI(TAG_UI, "Exited menu due to tare operation");
         }
         
         // Show taring message on display (non-blocking)
@@ -138,18 +158,18 @@ void rotary_onButtonClick()
         
         // Perform the tare operation
         if (!tareScale()) {
-            Serial.println("Tare failed: HX711 not ready. Returning to menu.");
+            LOGI(TAG_UI, "Tare failed: HX711 not ready. Returning to menu.");
             showErrorMessage("Tare failed\nHX711 not ready");
             displayLock = false;
             scaleStatus = STATUS_IN_MENU;
             return;
         }
         
-        // Use a task to unlock the display after a delay instead of relying on rotary_loop
+        // Use a task to unlock the display once the tare completed instead of relying on rotary_loop
         xTaskCreatePinnedToCore(
-            unlockDisplayTask,
+            unlockAfterTareTask,
             "UnlockDisplayTask",
-            1000,
+            2048,
             NULL,
             1,
             NULL,
@@ -183,7 +203,7 @@ void rotary_onButtonClick()
         scaleStatus = STATUS_IN_MENU;
         currentMenuItem = 0;
         rotaryEncoder.setAcceleration(0);
-        Serial.println("Entering Menu...");
+        LOGI(TAG_UI, "Entering Menu...");
     }
     else if (scaleStatus == STATUS_IN_MENU)
     {
@@ -199,28 +219,28 @@ void rotary_onButtonClick()
                 currentSubmenu = 0;                 // Reset submenu
                 currentSubmenuItem = 0;             // Reset submenu item
                 rotaryEncoder.setAcceleration(100); // Restore encoder acceleration
-                Serial.println("Exited Menu to main screen");
+                LOGI(TAG_UI, "Exited Menu to main screen");
                 delay(200); // Debounce to prevent immediate re-trigger
                 break;
             case 1: // Mode submenu
                 currentSubmenu = 1;
                 currentSubmenuItem = 0;
-                Serial.println("Entering Mode submenu");
+                LOGI(TAG_UI, "Entering Mode submenu");
                 break;
             case 2: // Shot Offset Menu
                 scaleStatus = STATUS_IN_SUBMENU;
                 currentSetting = 2;
-                Serial.println("Shot Offset Menu");
+                LOGI(TAG_UI, "Shot Offset Menu");
                 break;
             case 3: // Info Menu
                 scaleStatus = STATUS_IN_SUBMENU;
                 currentSetting = 5;
-                Serial.println("Info Menu");
+                LOGI(TAG_UI, "Info Menu");
                 break;
             case 4: // Configuration submenu
                 currentSubmenu = 2;
                 currentSubmenuItem = 0;
-                Serial.println("Entering Configuration submenu");
+                LOGI(TAG_UI, "Entering Configuration submenu");
                 break;
             }
         }
@@ -230,9 +250,7 @@ void rotary_onButtonClick()
             {
             case 0: // GBW mode
                 manualGrindMode = false;
-                preferences.begin("scale", false);
-                preferences.putBool("manualGrindMode", manualGrindMode);
-                preferences.end();
+                settingsTouch(SET_MANUAL_GRIND);
                 displayLock = true;
                 showModeChangeMessage("GBW", "Selected");
                 xTaskCreatePinnedToCore(
@@ -246,13 +264,11 @@ void rotary_onButtonClick()
                 );
                 currentSubmenu = 0; // Return to main menu
                 currentMenuItem = 0;
-                Serial.println("GBW mode selected");
+                LOGI(TAG_UI, "GBW mode selected");
                 break;
             case 1: // Manual mode
                 manualGrindMode = true;
-                preferences.begin("scale", false);
-                preferences.putBool("manualGrindMode", manualGrindMode);
-                preferences.end();
+                settingsTouch(SET_MANUAL_GRIND);
                 displayLock = true;
                 showModeChangeMessage("Manual", "Selected");
                 xTaskCreatePinnedToCore(
@@ -266,12 +282,12 @@ void rotary_onButtonClick()
                 );
                 currentSubmenu = 0; // Return to main menu
                 currentMenuItem = 0;
-                Serial.println("Manual mode selected");
+                LOGI(TAG_UI, "Manual mode selected");
                 break;
             case 2: // Back
                 currentSubmenu = 0; // Return to main menu
                 currentSubmenuItem = 0;
-                Serial.println("Returning to main menu from Mode submenu");
+                LOGI(TAG_UI, "Returning to main menu from Mode submenu");
                 break;
             }
         }
@@ -283,67 +299,65 @@ void rotary_onButtonClick()
                 scaleStatus = STATUS_IN_SUBMENU;
                 currentSetting = 1;
                 if (!tareScale()) {
-                    Serial.println("Tare failed: HX711 not ready. Returning to menu.");
+                    LOGI(TAG_UI, "Tare failed: HX711 not ready. Returning to menu.");
                     showErrorMessage("Tare failed\nHX711 not ready");
                     scaleStatus = STATUS_IN_MENU;
                     break;
                 }
-                Serial.println("Calibration Menu");
+                LOGI(TAG_UI, "Calibration Menu");
                 break;
             case 1: // Compensation Menu (new dedicated item)
                 scaleStatus = STATUS_IN_SUBMENU;
                 currentSetting = 9; // new submenu id for Compensation
-                Serial.println("Compensation Menu");
+                LOGI(TAG_UI, "Compensation Menu");
                 break;
             case 2: // Cup Weight Menu
                 scaleStatus = STATUS_IN_SUBMENU;
                 currentSetting = 0;
-                if (!tareScale()) {
-                    Serial.println("Tare failed: HX711 not ready. Returning to menu.");
-                    showErrorMessage("Tare failed\nHX711 not ready");
-                    scaleStatus = STATUS_IN_MENU;
-                    break;
-                }
-                delay(500);  // Wait for stabilization
-
+                // Weigh the cup against the previous zero before the tare
+                // (which runs in the background) zeroes it
                 if (scaleWeight > 0)
                 {
                     setCupWeight = scaleWeight;
-                    preferences.begin("scale", false);
-                    preferences.putDouble("cup", setCupWeight);
-                    preferences.end();
+                    settingsTouch(SET_CUP_WEIGHT);
 
-                    Serial.println("Cup weight set successfully");
+                    LOGI(TAG_UI, "Cup weight set successfully");
                 }
                 else
                 {
-                    Serial.println("Error: Invalid cup weight detected");
+                    LOGW(TAG_UI, "Invalid cup weight detected");
+                }
+                if (!tareScale()) {
+                    LOGI(TAG_UI, "Tare failed: HX711 not ready. Returning to menu.");
+                    showErrorMessage("Tare failed\nHX711 not ready");
+                    scaleStatus = STATUS_IN_MENU;
+                    break;
                 }
                 break;
             case 3: // Scale Mode Menu
                 scaleStatus = STATUS_IN_SUBMENU;
                 currentSetting = 3;
-                Serial.println("Scale Mode Menu");
+                LOGI(TAG_UI, "Scale Mode Menu");
                 break;
             case 4: // Grinding Mode Menu
                 scaleStatus = STATUS_IN_SUBMENU;
                 currentSetting = 4;
-                Serial.println("Grind Mode Menu");
+                LOGI(TAG_UI, "Grind Mode Menu");
                 break;
             case 5: // Grind Trigger Menu
                 scaleStatus = STATUS_IN_SUBMENU;
                 currentSetting = 8; // Use setting 8 for grind trigger
-                Serial.println("Grind Trigger Menu");
+                LOGI(TAG_UI, "Grind Trigger Menu");
                 break;
             case 6: // Reset Menu
                 scaleStatus = STATUS_IN_SUBMENU;
                 currentSetting = 6;
-                Serial.println("Reset Menu");
+                LOGI(TAG_UI, "Reset Menu");
                 break;
             case 7: // Back
                 currentSubmenu = 0; // Return to main menu
                 currentSubmenuItem = 0;
-                Serial.println("Returning to main menu from Configuration submenu");
+                LOGI(TAG_UI, "Returning to main menu from Configuration submenu");
                 break;
             }
         }
@@ -358,11 +372,9 @@ void rotary_onButtonClick()
             if (scaleWeight > 5)
             { // Ensure cup weight is valid
                 setCupWeight = scaleWeight;
-                Serial.println(setCupWeight);
+                LOGI(TAG_UI, "Cup weight: %.1fg", setCupWeight);
 
-                preferences.begin("scale", false);
-                preferences.putDouble("cup", setCupWeight);
-                preferences.end();
+                settingsTouch(SET_CUP_WEIGHT);
 
                 displayLock = true;
                 showCupWeightSetScreen(setCupWeight); // Show confirmation
@@ -372,12 +384,10 @@ void rotary_onButtonClick()
             }
             else
             {
-                Serial.println("Error: Invalid cup weight detected. Setting default value.");
+                LOGW(TAG_UI, "Invalid cup weight detected. Setting default value.");
                 setCupWeight = 10.0; // Assign a reasonable default value
-                preferences.begin("scale", false);
-                preferences.putDouble("cup", setCupWeight);
-                preferences.end();
-                Serial.println("Failsafe: Exiting cup weight menu due to zero weight");
+                settingsTouch(SET_CUP_WEIGHT);
+                LOGI(TAG_UI, "Failsafe: Exiting cup weight menu due to zero weight");
                 exitToMenu();
             }
             break;
@@ -385,6 +395,7 @@ void rotary_onButtonClick()
         case 1: // Calibration Menu
         {
             // Get the raw reading from the load cell (without scale factor applied)
+            Hx711Guard guard;
             loadcell.set_scale(1.0); // Temporarily set scale to 1 to get raw reading
             delay(500); // Allow stabilization
             double rawReading = loadcell.get_units(10); // Take 10 readings for accuracy
@@ -394,25 +405,20 @@ void rotary_onButtonClick()
             
             // Basic validation - ensure we got a reasonable reading
             if (abs(rawReading) < 1000 || abs(newCalibrationValue) < 100 || abs(newCalibrationValue) > 10000) {
-                Serial.printf("Error: Invalid calibration values (raw: %.2f, factor: %.2f). Using default.\n", 
-                             rawReading, newCalibrationValue);
+                LOGW(TAG_UI, "Invalid calibration values (raw: %.2f, factor: %.2f). Using default.",
+                     rawReading, newCalibrationValue);
                 newCalibrationValue = (double)LOADCELL_SCALE_FACTOR;
             }
             
             // Save and apply the new calibration
-            preferences.begin("scale", false);
-            preferences.putDouble("calibration", newCalibrationValue);
-            preferences.end();
-            
+            scaleFactor = newCalibrationValue;
             loadcell.set_scale(newCalibrationValue);
             
-            Serial.printf("Calibration completed: Raw reading = %.2f, New scale factor = %.2f\n", 
-                         rawReading, newCalibrationValue);
+            LOGI(TAG_UI, "Calibration completed: Raw reading = %.2f, New scale factor = %.2f",
+                 rawReading, newCalibrationValue);
             // Persist calibration and current display compensation value
-            preferences.begin("scale", false);
-            preferences.putDouble("calibration", newCalibrationValue);
-            preferences.putDouble("displayCompensation", display_compensation_g);
-            preferences.end();
+            settingsTouch(SET_CALIBRATION);
+            settingsTouch(SET_DISPLAY_COMP);
 
             scaleStatus = STATUS_IN_MENU;
             currentSetting = -1;
@@ -420,69 +426,51 @@ void rotary_onButtonClick()
         }
         case 2: // Shot Offset Menu
         {
-            preferences.begin("scale", false);
-            preferences.putDouble("shotOffset", shotOffset);
-            preferences.end();
+            settingsTouch(SET_SHOT_OFFSET);
             scaleStatus = STATUS_IN_MENU;
             currentSetting = -1;
             break;
         }
         case 9: // Compensation Menu - persist and exit
         {
-            preferences.begin("scale", false);
-            preferences.putDouble("displayCompensation", display_compensation_g);
-            preferences.end();
-            Serial.printf("Compensation saved: %.1fg\n", display_compensation_g);
+            settingsTouch(SET_DISPLAY_COMP);
+            LOGI(TAG_UI, "Compensation saved: %.1fg", display_compensation_g);
             scaleStatus = STATUS_IN_MENU;
             currentSetting = -1;
             break;
         }
         case 3: // Scale Mode Menu
         {
-            preferences.begin("scale", false);
-            preferences.putBool("scaleMode", scaleMode);
-            preferences.end();
+            settingsTouch(SET_SCALE_MODE);
             scaleStatus = STATUS_IN_MENU;
             currentSetting = -1;
             break;
         }
         case 4: // Grinding Mode Menu
         {
-            preferences.begin("scale", false);
-            preferences.putBool("grindMode", grindMode);
-            preferences.end();
+            settingsTouch(SET_GRIND_MODE);
             scaleStatus = STATUS_IN_MENU;
             currentSetting = -1;
             break;
         }
         case 5: // Info Menu
         {
-            displayLock = true;
-            showInfoMenu(); // Display info menu
-            delay(3000);
-            displayLock = false;
-            exitToMenu();
+            // The display task shows it for INFO_MENU_SHOW_MS and exits to the menu
+            scaleStatus = STATUS_INFO_MENU;
             break;
         }
         case 6: // Reset Menu
         {
             if (greset)
             {
-                preferences.begin("scale", false);
-                preferences.putDouble("calibration", (double)LOADCELL_SCALE_FACTOR);
-                setWeight = (double)COFFEE_DOSE_WEIGHT;
-                preferences.putDouble("setWeight", (double)COFFEE_DOSE_WEIGHT);
-                   shotOffset = (double)COFFEE_DOSE_OFFSET;
-                   preferences.putDouble("shotOffset", (double)COFFEE_DOSE_OFFSET);
-                setCupWeight = (double)CUP_WEIGHT;
-                preferences.putDouble("cup", (double)CUP_WEIGHT);
-                scaleMode = false;
-                preferences.putBool("scaleMode", false);
-                grindMode = false;
-                preferences.putBool("grindMode", false);
-                preferences.putUInt("shotCount", 0);
-                loadcell.set_scale((double)LOADCELL_SCALE_FACTOR);
-                preferences.end();
+                settingsReset(SET_CALIBRATION);
+                settingsReset(SET_SET_WEIGHT);
+                settingsReset(SET_SHOT_OFFSET);
+                settingsReset(SET_CUP_WEIGHT);
+                settingsReset(SET_SCALE_MODE);
+                settingsReset(SET_GRIND_MODE);
+                settingsReset(SET_SHOT_COUNT);
+                loadcell.set_scale(scaleFactor);
             }
             scaleStatus = STATUS_IN_MENU;
             currentSetting = -1;
@@ -491,11 +479,8 @@ void rotary_onButtonClick()
         case 8: // Grind Trigger Menu
         {
             // Save the current selection and exit
-            preferences.begin("scale", false);
-            preferences.putBool("grindTrigger", useButtonToGrind);
-            preferences.end();
-            Serial.print("Grind Trigger Mode set to: ");
-            Serial.println(useButtonToGrind ? "Button" : "Cup");
+            settingsTouch(SET_GRIND_TRIGGER);
+            LOGI(TAG_UI, "Grind Trigger Mode set to: %s", useButtonToGrind ? "Button" : "Cup");
             scaleStatus = STATUS_IN_MENU;
             currentSetting = -1;
             break;
@@ -525,13 +510,10 @@ void rotary_loop()
             longPressProcessed = true;
             manualGrindMode = !manualGrindMode;
             
-            Serial.print("Long press detected - Manual Grind Mode: ");
-            Serial.println(manualGrindMode ? "ENABLED" : "DISABLED");
+            LOGI(TAG_UI, "Long press detected - Manual Grind Mode: %s", manualGrindMode ? "ENABLED" : "DISABLED");
             
             // Save the setting
-            preferences.begin("scale", false);
-            preferences.putBool("manualGrindMode", manualGrindMode);
-            preferences.end();
+            settingsTouch(SET_MANUAL_GRIND);
             
             // Show mode change on display briefly
             displayLock = true;
@@ -565,7 +547,7 @@ void rotary_loop()
         // Wake the screen if it's asleep
         if (millis() - lastSignificantWeightChangeAt > sleepTime)
         {
-            Serial.println("Screen waking due to rotary movement...");
+            LOGI(TAG_UI, "Screen waking due to rotary movement...");
             wakeScreen();
         }
         switch (scaleStatus)
@@ -582,7 +564,7 @@ void rotary_loop()
             if (setWeight < 0)
             {
                 setWeight = 0;
-                Serial.println("Grind weight cannot be less than 0. Reset to 0.");
+                LOGI(TAG_UI, "Grind weight cannot be less than 0. Reset to 0.");
             }
             int newValue = rotaryEncoder.readEncoder();
             int encoderDelta = newValue - encoderValue;
@@ -599,17 +581,9 @@ void rotary_loop()
                 setWeight = round(setWeight * 10.0) / 10.0;
                 
                 encoderValue = newValue;
-                preferences.begin("scale", false);
-                preferences.putDouble("setWeight", setWeight);
-                preferences.end();
+                settingsTouch(SET_SET_WEIGHT);
                 
-                Serial.print("Weight: ");
-                Serial.print(setWeight, 1);
-                Serial.print("g (delta: ");
-                Serial.print(encoderDelta);
-                Serial.print(", increment: ");
-                Serial.print(increment, 3);
-                Serial.println(")");
+                LOGI(TAG_UI, "Weight: %.1fg (delta: %d, increment: %.3f)", setWeight, encoderDelta, increment);
             }
             break;
         }
@@ -628,20 +602,17 @@ void rotary_loop()
                     // Main menu navigation
                     currentMenuItem = (currentMenuItem + menuDirection) % menuItemsCount;
                     currentMenuItem = currentMenuItem < 0 ? menuItemsCount + currentMenuItem : currentMenuItem;
-                    Serial.print("Main menu item: ");
-                    Serial.println(currentMenuItem);
+                    LOGI(TAG_UI, "Main menu item: %d", currentMenuItem);
                 } else if (currentSubmenu == 1) {
                     // Mode submenu navigation
                     currentSubmenuItem = (currentSubmenuItem + menuDirection) % modeMenuItemsCount;
                     currentSubmenuItem = currentSubmenuItem < 0 ? modeMenuItemsCount + currentSubmenuItem : currentSubmenuItem;
-                    Serial.print("Mode submenu item: ");
-                    Serial.println(currentSubmenuItem);
+                    LOGI(TAG_UI, "Mode submenu item: %d", currentSubmenuItem);
                 } else if (currentSubmenu == 2) {
                     // Configuration submenu navigation
                     currentSubmenuItem = (currentSubmenuItem + menuDirection) % configMenuItemsCount;
                     currentSubmenuItem = currentSubmenuItem < 0 ? configMenuItemsCount + currentSubmenuItem : currentSubmenuItem;
-                    Serial.print("Config submenu item: ");
-                    Serial.println(currentSubmenuItem);
+                    LOGI(TAG_UI, "Config submenu item: %d", currentSubmenuItem);
                 }
                 
                 encoderValue = newValue;
@@ -663,7 +634,7 @@ void rotary_loop()
                 if (display_compensation_g > 20.0) display_compensation_g = 20.0;
                 // Round to 0.1g
                 display_compensation_g = round(display_compensation_g * 10.0) / 10.0;
-                Serial.printf("Display compensation: %.1fg\n", display_compensation_g);
+                LOGI(TAG_UI, "Display compensation: %.1fg", display_compensation_g);
             }
 
             if (currentSetting == 2 && encoderDelta != 0)
@@ -677,11 +648,7 @@ void rotary_loop()
                 // Round to nearest 0.01g
                 shotOffset = round(shotOffset * 100.0) / 100.0;
                 
-                Serial.print("ShotOffset: ");
-                Serial.print(shotOffset, 2);
-                Serial.print("g (delta: ");
-                Serial.print(encoderDelta);
-                Serial.println(")");
+                LOGI(TAG_UI, "ShotOffset: %.2fg (delta: %d)", shotOffset, encoderDelta);
             }
             else if (currentSetting == 3)
             {
@@ -703,12 +670,14 @@ void rotary_loop()
         }
         case STATUS_GRINDING_FAILED:
         {
-            Serial.println("Exiting Grinding Failed state to Main Menu...");
+            LOGI(TAG_UI, "Exiting Grinding Failed state to Main Menu...");
             scaleStatus = STATUS_IN_MENU;
             currentMenuItem = 0; // Reset to the main menu
+            displayNotify(DISPLAY_STATE);
             return; // Exit early to avoid further processing
         }
         }
+        displayNotify(DISPLAY_MENU);
     }
     if (rotaryEncoder.isEncoderButtonClicked())
     {
@@ -720,15 +689,32 @@ void rotary_loop()
         // Wake the screen if it's asleep
         if (millis() - lastSignificantWeightChangeAt > sleepTime)
         {
-            Serial.println("Screen waking due to button press...");
+            LOGI(TAG_UI, "Screen waking due to button press...");
             wakeScreen();
             return; // Exit early to prevent other button actions while waking
         }
         
         rotary_onButtonClick(); // Existing button click handling
+        displayNotify(DISPLAY_MENU);
     }
 }
 
+// Encoder and button handling, kept out of the status task so menu work
+// (taring messages, settings) never delays the grind state machine
+static void uiLoop(void *parameter)
+{
+    for (;;)
+    {
+        rotary_loop();
+        delay(UI_POLL_MS);
+    }
+}
+
+void setupRotaryTask()
+{
+    xTaskCreatePinnedToCore(uiLoop, "UI", TASK_UI_STACK, NULL, TASK_UI_PRIORITY, &UiTask, TASK_UI_CORE);
+}
+
 // ISR for reading encoder changes
 void readEncoderISR()
 {
@@ -2,6 +2,20 @@
 #include "rotary.hpp"
 #include "scale.hpp"
 #include "display.hpp"
+#include "acquisition.hpp"
+#include "grind_trace.hpp"
+#include "scale_hal.hpp"
+#include "log.hpp"
+#include "settings.hpp"
+#include "task_monitor.hpp"
+#include "relay_test.hpp"
+#include "weight_filter.hpp"
+#include "weight_stream.hpp"
+#include "grind_events.hpp"
+#include <GrindPredictor.h>
+#include <CountScale.h>
+#include <StabilityDetector.h>
+#include "freertos/event_groups.h"
 
 // Variables for scale functionality
 // HX711 operation flags
@@ -21,17 +35,46 @@ bool grindMode = false;       // Grinder mode: impulse (false) or continuous (tr
 bool grinderActive = false;   // Grinder state (on/off)
 unsigned int shotCount;
 
-// Buffer for storing recent weight history
-MathBuffer<double, 100> weightHistory;
-// Per-sensor history for AZT to operate on each cell individually
-MathBuffer<double, 100> weightHistory2;
+// Recent history, one row per acquired sample: raw counts of both cells (so
+// AZT can operate on each cell individually), fused grams and the filter
+// estimate, all sharing one timestamp. The window lengths queried every
+// status loop are registered in setupScale() and kept up to date on push.
+ScaleHistory weightHistory;
+
+// Predictive grind stop: fed with every fused sample while grinding, learns
+// relay latency and in-flight mass from the settled weight after each grind.
+GrindPredictor grindPredictor;
+// Persisted copy of the learned model (see settings.cpp)
+float predictorLatencyS = PREDICTOR_DEFAULT_LATENCY_S;
+float predictorInFlightG = PREDICTOR_DEFAULT_IN_FLIGHT_G;
+// Stop/failure decisions of the running grind. Shared between the scale task
+// (samples) and the status task (decisions), both guarded by sessionMux.
+GrindSession grindSession(systemClock, grinderRelay, grindPredictor);
+static portMUX_TYPE sessionMux = portMUX_INITIALIZER_UNLOCKED;
+
+#if WEIGHT_FIXED_POINT
+// Reciprocals of scaleFactor / scaleFactor2 for the integer weight path
+static CountScale countScale1;
+static CountScale countScale2;
+#endif
+
+// Stability of the fused weight (scale task), for cup detection and the
+// settled weight after a grind; the status loop reads the published copy
+static StabilityDetector weightStability(STABILITY_WEIGHT);
+static StabilityState weightStabilityState = {};
+static portMUX_TYPE stabilityMux = portMUX_INITIALIZER_UNLOCKED;
+// Weight the scale settled at after the last grind (0 = not yet)
+static unsigned long finishedSettledAt = 0;
+// Numbers the grinds since boot in the grind events
+static uint32_t grindNumber = 0;
+static unsigned long grindStartedAt = 0;
+static double finishedSettledWeight = 0;
 
 // Auto-Zero Tracking (AZT) - helps correct residual offsets when stable near zero
 bool auto_zero_enabled = true;
-int auto_zero_stable = 0;
-int auto_zero_stable2 = 0; // independent stability counter for sensor2
-const float AZT_WINDOW_G = 1.0f;   // grams window considered "near zero"
-const int AZT_REQUIRED = 8;        // consecutive stable cycles required to auto-zero
+// Per cell, in grams against the current offset; reset when the offset moves
+static StabilityDetector aztStability1(STABILITY_AZT);
+static StabilityDetector aztStability2(STABILITY_AZT);
 const float AZT_MIN_G = 0.25f;     // only allow AZT when very close to zero (smaller than this)
 bool history_seeded = false;       // seed history on first successful read
 
@@ -78,249 +121,411 @@ bool display_compensate_shot = false;
 double display_compensation_g = 1.0;
 
                     // displayWeight is updated in the display task when needed
+// Incremental tare: the new offsets are the mean raw counts of the next
+// samples from the acquisition stream, so sampling (and the grind state
+// machine reading the weight) never stops for a tare. A stability detector
+// per cell, fed grams relative to the first sample, tells when the zero has
+// stopped moving and its mean has settled; completion is signalled through
+// tareEvents.
+//
+// Every tareScale() gets the next sequence number, and a tare only reports
+// completion if no newer one was requested meanwhile: a caller waiting for
+// its tare cannot be released by an older one that happened to finish
+// (e.g. the grind button pressed while the startup tare runs). A new
+// request restarts a running tare.
+struct TareAccumulator {
+    bool active;
+    uint32_t sequence;      // tareRequested when it began
+    bool sensor2;           // also capture the secondary offset
+    unsigned long startedAt;
+    uint32_t count;
+    long base1, base2;      // first sample, keeps the float deltas small
+};
+static TareAccumulator tare = {};
+static StabilityDetector tareStability1(STABILITY_TARE);
+static StabilityDetector tareStability2(STABILITY_TARE);
+static EventGroupHandle_t tareEvents = nullptr;
+// Orders a new request against the completion of the running tare
+static SemaphoreHandle_t tareMutex = nullptr;
+static uint32_t tareRequested = 0;
+#define TARE_DONE_BIT BIT0
+#define TARE_FAILED_BIT BIT1
+#define TARE_STARTED_BIT BIT2
+// The scale task waits this long for a sample per loop; a request is picked
+// up, and the tare timeout checked, once per loop
+#define SAMPLE_WAIT_MS 300
+// Request to tareBegin(): at most one loop, doubled for margin. Settling
+// after a power-down happens after tareBegin() and counts against the tare.
+#define TARE_PICKUP_MS (2 * SAMPLE_WAIT_MS)
+
 bool tareScale()
 {
+    // A new zero would be subtracted from the dose that is being ground
+    if (scaleStatus == STATUS_GRINDING_IN_PROGRESS) {
+        LOGW(TAG_TARE, "Tare refused while grinding");
+        return false;
+    }
     // Set tare request flag, actual tare will be performed in updateScale
+    if (tareMutex) xSemaphoreTake(tareMutex, portMAX_DELAY);
+    tareRequested++;
+    if (tareEvents) xEventGroupClearBits(tareEvents, TARE_DONE_BIT | TARE_FAILED_BIT | TARE_STARTED_BIT);
     requestTare = true;
     // Also request that the secondary sensor's offset be captured when the tare runs.
     // This makes a single tare operation (e.g. rotary double-tap) apply to both HX711 modules.
     requestSetOffset = true;
+    if (tareMutex) xSemaphoreGive(tareMutex);
     // Do not perform HX711 operations here
     return true;
 }
 
-// Task to continuously update the scale readings
+bool tareInProgress() {
+    // tareScale() clears both bits, tareFinish() sets one
+    return !(xEventGroupGetBits(tareEvents) & (TARE_DONE_BIT | TARE_FAILED_BIT));
+}
+
+bool tareWait(uint32_t timeoutMs) {
+    if (timeoutMs == 0) return xEventGroupGetBits(tareEvents) & TARE_DONE_BIT;
+    // The scale task times the tare from tareBegin(), so do the same: first
+    // wait for it to pick the request up, then the timeout plus one loop
+    // (it checks the timeout only once per sample wait)
+    EventBits_t bits = xEventGroupWaitBits(tareEvents, TARE_STARTED_BIT, pdFALSE, pdFALSE,
+                                           pdMS_TO_TICKS(TARE_PICKUP_MS));
+    if (!(bits & TARE_STARTED_BIT)) return false;
+    bits = xEventGroupWaitBits(tareEvents, TARE_DONE_BIT | TARE_FAILED_BIT, pdFALSE, pdFALSE,
+                               pdMS_TO_TICKS(timeoutMs + SAMPLE_WAIT_MS));
+    return bits & TARE_DONE_BIT;
+}
+
+static void tareBegin() {
+    xSemaphoreTake(tareMutex, portMAX_DELAY);
+    tare = {};
+    tare.active = true;
+    tare.sequence = tareRequested;
+    tare.sensor2 = requestSetOffset && LOADCELL2_DOUT_PIN != -1;
+    tare.startedAt = millis();
+    tareStability1.reset();
+    tareStability2.reset();
+    requestTare = false;
+    requestSetOffset = false;
+    xEventGroupSetBits(tareEvents, TARE_STARTED_BIT);
+    xSemaphoreGive(tareMutex);
+    LOGI(TAG_TARE, "Taring scale from the sample stream...");
+}
+
+static void tareFinish(bool success) {
+    tare.active = false;
+    xSemaphoreTake(tareMutex, portMAX_DELAY);
+    // A newer request restarts the tare and reports for itself
+    if (tare.sequence == tareRequested) {
+        xEventGroupSetBits(tareEvents, success ? TARE_DONE_BIT : TARE_FAILED_BIT);
+    }
+    xSemaphoreGive(tareMutex);
+}
+
+// Standard error of the mean in grams
+static float tareStandardError(const StabilityDetector &detector) {
+    if (detector.count() < 2) return INFINITY;
+    return detector.stdDev() / sqrtf((float)detector.count());
+}
+
+// Scale task: feed one sample; applies the offsets once the zero settled
+static void tareAddSample(uint32_t timestampMs, long raw1, long raw2) {
+    if (tare.count == 0) {
+        tare.base1 = raw1;
+        tare.base2 = raw2;
+    }
+    tare.count++;
+    if (scaleFactor > 0) tareStability1.push(timestampMs, (float)((raw1 - tare.base1) / scaleFactor));
+    if (tare.sensor2 && scaleFactor2 > 0) tareStability2.push(timestampMs, (float)((raw2 - tare.base2) / scaleFactor2));
+
+    float error1 = tareStandardError(tareStability1);
+    float error2 = tare.sensor2 ? tareStandardError(tareStability2) : 0;
+    bool settled = tareStability1.stable() && (!tare.sensor2 || tareStability2.stable()) &&
+                   error1 <= TARE_SETTLED_G && error2 <= TARE_SETTLED_G;
+    if (!settled && tare.count < TARE_MEASURES) return;
+    if (!settled) {
+        LOGW(TAG_TARE, "Tare did not settle (+/-%.3fg), using the mean of %u samples", max(error1, error2), tare.count);
+    }
+
+    long off1 = tare.base1 + lround(tareStability1.mean() * scaleFactor);
+    loadcell.set_offset(off1);
+    loadcell_offset = off1; // store in runtime var
+    // persist primary HX711 counts so taring survives reboot
+    settingsTouch(SET_OFFSET1);
+    if (tare.sensor2) {
+        long off2 = tare.base2 + lround(tareStability2.mean() * scaleFactor2);
+        loadcell2.set_offset(off2);
+        loadcell2_offset = off2;
+        settingsTouch(SET_OFFSET2);
+        LOGI(TAG_TARE, "Sensor2 offset set to %ld", off2);
+        // Block AZT briefly after setting offsets
+        aztBlockUntil = millis() + 10000UL;
+    }
+    lastTareAt = millis();
+    scaleWeight = 0;
+    // Restart the filter at zero instead of letting it ramp down
+    weightFilterReset(0);
+    // Windows from before the new zero mean nothing now
+    weightStability.reset();
+    aztStability1.reset();
+    aztStability2.reset();
+    LOGI(TAG_TARE, "Scale tared from %u samples in %lu ms (+/-%.3fg)", tare.count, millis() - tare.startedAt, error1);
+    tareFinish(true);
+}
+
+// Task to continuously update the scale readings. Samples are produced by the
+// interrupt-driven acquisition task (acquisition.cpp); this task only consumes
+// them, so it runs once per HX711 conversion instead of on a fixed delay.
 void updateScale(void *parameter) {
     float lastEstimate;
-    const TickType_t xDelay = 50 / portTICK_PERIOD_MS; // 20Hz = 50ms interval (faster sampling)
     int hx711_fail_count = 0;
+    double lastNotifiedWeight = 0;
     for (;;) {
-        vTaskDelay(1); // Minimal delay to mitigate timing/race condition
         // Request tare on startup if needed (capture both primary and secondary offsets)
-        if (lastTareAt == 0) {
-            requestTare = true;
-            requestSetOffset = true; // ensure secondary HX711 offset is captured on first startup tare
+        if (lastTareAt == 0 && !requestTare && !tare.active) {
+            tareScale();
         }
-        // Serialize HX711 access: handle tare request first
         if (requestTare) {
-            Serial.println("Taring scale (serialized in updateScale)...");
-            bool tareSuccess = false;
-            for (int attempt = 1; attempt <= 3; ++attempt) {
-                Serial.printf("[tareScale] Attempt %d: Waiting for HX711 ready...\n", attempt);
-                unsigned long t0 = millis();
-                bool ready = loadcell.wait_ready_timeout(1000);
-                Serial.printf("[tareScale] wait_ready_timeout returned %s after %lu ms\n", ready ? "true" : "false", millis() - t0);
-                if (ready) {
-                    Serial.println("[tareScale] HX711 ready, reading average...");
-                    t0 = millis();
-                    long off1 = loadcell.read_average(10); // Average 10 readings for stability
-                    Serial.printf("[tareScale] read_average finished after %lu ms\n", millis() - t0);
-                    loadcell.set_offset(off1);
-                    loadcell_offset = off1; // store in runtime var
-                    // persist primary HX711 counts so taring survives reboot
-                    preferences.begin("scale", false);
-                    preferences.putLong("offset1", off1);
-                    preferences.end();
-                    lastTareAt = millis();
-                    scaleWeight = 0;
-                    // Reinitialize Kalman with the same responsive parameters used at startup
-                    kalmanFilter = SimpleKalmanFilter(0.5, 0.01, 0.01);
-                    Serial.println("Scale tared successfully");
-                    tareSuccess = true;
-                    break;
-                } else {
-                    Serial.print("Tare attempt ");
-                    Serial.print(attempt);
-                    Serial.println(": HX711 not ready, retrying...");
-                    Serial.println("[tareScale] Delaying for 200ms...");
-                    unsigned long d0 = millis();
-                    delay(200);
-                    Serial.printf("[tareScale] Delay finished after %lu ms\n", millis() - d0);
-                }
-            }
-            requestTare = false;
-            // If tare failed, skip regular sampling this cycle
-            if (!tareSuccess) {
-                vTaskDelay(xDelay);
-                continue;
-            }
-                // If requested, capture and persist the secondary HX711 offset now that primary tare succeeded
-                if (requestSetOffset && LOADCELL2_DOUT_PIN != -1) {
-                    Serial.println("[tareScale] Capturing secondary HX711 offset as requested...");
-                    if (loadcell2.wait_ready_timeout(1000)) {
-                        long off2 = loadcell2.read_average(20);
-                        loadcell2.set_offset(off2);
-                        loadcell2_offset = off2;
-                        preferences.begin("scale", false);
-                        preferences.putLong("offset2", off2);
-                        preferences.end();
-                        Serial.printf("[tareScale] Sensor2 offset set to %ld and saved to NVS\n", off2);
-                        // Block AZT briefly after setting offsets
-                        aztBlockUntil = millis() + 10000UL;
-                    } else {
-                        Serial.println("[tareScale] Warning: HX711(sensor2) not ready to capture offset");
-                    }
-                    requestSetOffset = false;
-                }
+            if (tare.active) LOGI(TAG_TARE, "Tare requested again, restarting");
+            tareBegin();
+        }
+        if (tare.active && millis() - tare.startedAt > TARE_TIMEOUT_MS) {
+            LOGW(TAG_TARE, "Tare failed: only %u samples in %d ms", tare.count, TARE_TIMEOUT_MS);
+            tareFinish(false);
         }
-        // Regular HX711 sampling
-        unsigned long t0 = millis();
-    bool ready = loadcell.wait_ready_timeout(300);
+        // Regular sampling: wait for the next conversion from the acquisition ring
+        RawSample sample;
+        bool ready = acquisitionNextSample(sample, SAMPLE_WAIT_MS);
         if (ready) {
             hx711_fail_count = 0;
-        long raw;
+            // Runs before the conversion, so the sample that completes a tare
+            // is already weighed against the new offsets
+            if (tare.active) tareAddSample((uint32_t)(sample.timestampUs / 1000), sample.raw1, sample.raw2);
+        long raw = sample.raw1;
         long raw_offset = loadcell.get_offset();
-        double grams;
         // Optional second sensor
-        long raw2 = 0;
+        long raw2 = sample.raw2;
         long raw2_offset = loadcell2_offset;
-        double grams2 = 0;
-                
-                // Seed history on first successful read to avoid large initial deltas
-                if (!history_seeded) {
-                    long seed_raw = loadcell.read_average(5);
-                    double seed_grams = (double)(seed_raw - raw_offset) / scaleFactor;
-                    for (int i = 0; i < 20; ++i) {  // Seed last 20 values
-                        weightHistory.push(seed_grams);
-                    }
-                    // Seed sensor2 history if present
-                    if (LOADCELL2_DOUT_PIN != -1) {
-                        long seed_raw2 = loadcell2.read_average(5);
-                        double seed_grams2 = (double)(seed_raw2 - raw2_offset) / scaleFactor2;
-                        for (int i = 0; i < 20; ++i) {
-                            weightHistory2.push(seed_grams2);
-                        }
-                    }
-                    history_seeded = true;
-                    Serial.println("Weight history seeded to reduce initial spikes.");
+#if WEIGHT_FIXED_POINT
+                // Integer path: counts to milligrams through the reciprocals,
+                // recomputed only when a calibration factor changed
+                countScale1.setFactor(scaleFactor);
+                int32_t mg = countScale1.toMg(raw - raw_offset);
+                int32_t mg2 = 0;
+                if (LOADCELL2_DOUT_PIN != -1) {
+                    countScale2.setFactor(scaleFactor2);
+                    mg2 = countScale2.toMg(raw2 - raw2_offset);
                 }
-                
-                if (scaleStatus == STATUS_GRINDING_IN_PROGRESS) {
-                    // When grinding, use single reads for speed
-                    raw = loadcell.read();
-                    grams = (double)(raw - raw_offset) / scaleFactor;
-                    if (LOADCELL2_DOUT_PIN != -1) {
-                        raw2 = loadcell2.read();
-                        grams2 = (double)(raw2 - raw2_offset) / scaleFactor2;
-                    }
-                } else {
-                    // Use minimal averaging to reduce latency; Kalman provides smoothing
-                    raw = loadcell.read_average(1);
-                    grams = (double)(raw - raw_offset) / scaleFactor;
-                    if (LOADCELL2_DOUT_PIN != -1) {
-                        raw2 = loadcell2.read_average(1);
-                        grams2 = (double)(raw2 - raw2_offset) / scaleFactor2;
-                    }
+                float grams = mg * 0.001f;
+                float grams2 = mg2 * 0.001f;
+                float combined = grams;
+#else
+                double grams = (double)(raw - raw_offset) / scaleFactor;
+                double grams2 = 0;
+                if (LOADCELL2_DOUT_PIN != -1) {
+                    grams2 = (double)(raw2 - raw2_offset) / scaleFactor2;
                 }
+                double combined = grams;
+#endif
                 // Debug: print raw HX711 values to help troubleshoot calibration/noise
                 if (LOADCELL2_DOUT_PIN != -1) {
-                    Serial.printf("[HX711-1] raw=%ld offset=%ld factor=%.5f grams=%.3f  |  [HX711-2] raw=%ld offset=%ld factor=%.5f grams=%.3f\n", 
-                                  raw, raw_offset, scaleFactor, grams, raw2, raw2_offset, scaleFactor2, grams2);
+                    LOGD(TAG_HX711, "s1 raw=%ld offset=%ld factor=%.5f grams=%.3f  |  s2 raw=%ld offset=%ld factor=%.5f grams=%.3f",
+                         raw, raw_offset, scaleFactor, grams, raw2, raw2_offset, scaleFactor2, grams2);
                     // Combine sensors by averaging their gram contributions when both are present.
                     // Many rigs have each sensor measuring the full platform load; averaging
                     // produces the correct single-mass reading when both sensors see the same
                     // mass. If you later want to revert to summing, change this back to (grams + grams2).
-                    double combined = (grams + grams2) / 2.0;
-                    scaleWeight = kalmanFilter.updateEstimate(combined);
+#if WEIGHT_FIXED_POINT
+                    combined = (mg + mg2) * 0.0005f; // mean in grams, without truncating the odd milligram
+#else
+                    combined = (grams + grams2) / 2.0;
+#endif
                     scaleWeight2 = grams2;
-                    // push per-sensor values for AZT
-                    weightHistory.push(scaleWeight);
-                    if (LOADCELL2_DOUT_PIN != -1) weightHistory2.push(scaleWeight2);
                 } else {
-                    Serial.printf("[HX711] raw=%ld offset=%ld factor=%.5f grams=%.3f\n", raw, raw_offset, scaleFactor, grams);
-                    scaleWeight = kalmanFilter.updateEstimate(grams);
-                    // push primary sensor value and seed sensor2 history with zero if absent
-                    weightHistory.push(scaleWeight);
-                    if (LOADCELL2_DOUT_PIN != -1) weightHistory2.push(scaleWeight2);
+                    LOGD(TAG_HX711, "raw=%ld offset=%ld factor=%.5f grams=%.3f", raw, raw_offset, scaleFactor, grams);
+                }
+                int64_t sampleMs = sample.timestampUs / 1000;
+                scaleWeight = weightFilterUpdate((uint32_t)sampleMs, combined, scaleStatus);
+                if (fabs(scaleWeight - lastNotifiedWeight) >= DISPLAY_WEIGHT_STEP_G) {
+                    lastNotifiedWeight = scaleWeight;
+                    displayNotify(DISPLAY_WEIGHT);
+                }
+
+                // Seed history on first successful read to avoid large initial deltas
+                float row[HISTORY_CHANNELS] = {(float)raw, (float)raw2, (float)combined, (float)scaleWeight};
+                if (!history_seeded) {
+                    float seed[HISTORY_CHANNELS] = {(float)raw, (float)raw2, (float)combined, (float)combined};
+                    for (int i = 0; i < 20; ++i) {  // Seed last 20 values
+                        weightHistory.push(seed, sampleMs);
+                    }
+                    history_seeded = true;
+                    LOGI(TAG_SCALE, "Weight history seeded to reduce initial spikes.");
                 }
+                weightHistory.push(row, sampleMs);
+                // Stop decision on every sample, right where it arrives: the
+                // relay is switched inside update(), so the sample that crosses
+                // the target never waits for the status task
+                portENTER_CRITICAL(&sessionMux);
+                grindSession.addSample((uint32_t)sampleMs, (float)combined, (float)scaleWeight);
+                bool running = grindSession.state() == GrindSession::RUNNING;
+                bool decided = running && grindSession.update((float)scaleWeight, true);
+                portEXIT_CRITICAL(&sessionMux);
+                if (decided) taskMonitorStopDecision(sample.timestampUs);
+                taskMonitorSampleProcessed(sample.timestampUs, running);
+                grindTraceSample((uint32_t)sampleMs, raw, raw2, combined, scaleStatus);
+                relayTestSample((uint32_t)sampleMs, (float)combined);
+
+                weightStability.push((uint32_t)sampleMs, (float)combined);
+                StabilityState stability = weightStability.state();
+                portENTER_CRITICAL(&stabilityMux);
+                weightStabilityState = stability;
+                portEXIT_CRITICAL(&stabilityMux);
+                weightStreamSample((uint32_t)sampleMs, (float)combined, scaleStatus, stability.stable);
+                aztStability1.push((uint32_t)sampleMs, (float)grams);
+                if (LOADCELL2_DOUT_PIN != -1) aztStability2.push((uint32_t)sampleMs, (float)grams2);
             
-            // Auto-Zero Tracking: gently correct tare when stable and very close to zero
+            // Auto-Zero Tracking: gently correct each cell's offset once its
+            // own zero has been stable and very close to 0 g for the AZT window
                 if (auto_zero_enabled && scaleStatus == STATUS_EMPTY) {
                 // Respect global AZT block (set by calibration commands) to avoid AZT fighting calibration
-                if (millis() < aztBlockUntil) {
-                    // AZT blocked during cooldown
-                    auto_zero_stable = 0;
-                    auto_zero_stable2 = 0;
-                } else if (scaleReady && fabs(scaleWeight) <= AZT_MIN_G) {
-                    // Check per-sensor stability and adjust each cell independently
-                    double recent_avg1 = weightHistory.averageSince(millis() - 2000);
-                    double recent_avg2 = 0.0;
-                    if (LOADCELL2_DOUT_PIN != -1) recent_avg2 = weightHistory2.averageSince(millis() - 2000);
-
+                if (millis() >= aztBlockUntil && scaleReady && fabs(scaleWeight) <= AZT_MIN_G) {
                     // Primary sensor AZT
-                    if (fabs(recent_avg1) <= AZT_MIN_G) {
-                        auto_zero_stable++;
-                        if (auto_zero_stable >= AZT_REQUIRED) {
-                            long adjustment = (long)(recent_avg1 * scaleFactor);
+                    float recent_avg1 = aztStability1.mean();
+                    if (aztStability1.stable() && fabsf(recent_avg1) <= AZT_MIN_G) {
+                        long adjustment = lroundf(recent_avg1 * (float)scaleFactor);
+                        if (adjustment != 0) {
                             long old_offset = loadcell.get_offset();
                             loadcell.set_offset(old_offset + adjustment);
-                            auto_zero_stable = 0;
-                            Serial.printf("[AZT] Auto-zero adjusted primary tare by %+ld counts (%.2fg)\n", adjustment, recent_avg1);
+                            LOGI(TAG_AZT, "Auto-zero adjusted primary tare by %+ld counts (%.2fg)", adjustment, recent_avg1);
                             // do not persist here; primary will be persisted on next manual tare
                         }
-                    } else {
-                        auto_zero_stable = 0;
+                        aztStability1.reset();
                     }
 
                     // Secondary sensor AZT (if available)
-                    if (LOADCELL2_DOUT_PIN != -1) {
-                        if (fabs(recent_avg2) <= AZT_MIN_G) {
-                            auto_zero_stable2++;
-                            if (auto_zero_stable2 >= AZT_REQUIRED) {
-                                long adjustment2 = (long)(recent_avg2 * scaleFactor2);
-                                long old_offset2 = loadcell2.get_offset();
-                                loadcell2.set_offset(old_offset2 + adjustment2);
-                                auto_zero_stable2 = 0;
-                                Serial.printf("[AZT] Auto-zero adjusted secondary tare by %+ld counts (%.2fg)\n", adjustment2, recent_avg2);
-                                // do not persist here; secondary offset persisted on manual tare
-                            }
-                        } else {
-                            auto_zero_stable2 = 0;
+                    float recent_avg2 = aztStability2.mean();
+                    if (LOADCELL2_DOUT_PIN != -1 && aztStability2.stable() && fabsf(recent_avg2) <= AZT_MIN_G) {
+                        long adjustment2 = lroundf(recent_avg2 * (float)scaleFactor2);
+                        if (adjustment2 != 0) {
+                            loadcell2_offset += adjustment2; // the offset the weight math uses
+                            loadcell2.set_offset(loadcell2_offset);
+                            LOGI(TAG_AZT, "Auto-zero adjusted secondary tare by %+ld counts (%.2fg)", adjustment2, recent_avg2);
+                            // do not persist here; secondary offset persisted on manual tare
                         }
+                        aztStability2.reset();
                     }
-                } else {
-                    auto_zero_stable = 0;
-                    auto_zero_stable2 = 0;
                 }
             }
             
             // Removed: always report true scaleWeight, even near zero
             scaleLastUpdatedAt = millis();
-            weightHistory.push(scaleWeight);
             scaleReady = true;
+        } else if (acquisitionSettling()) {
+            // Powered down while the display sleeps, or settling after a rate
+            // switch: no samples are expected
+            hx711_fail_count = 0;
         } else {
             hx711_fail_count++;
-            Serial.println("HX711 not found.");
+            LOGW(TAG_HX711, "HX711 not found.");
             scaleReady = false;
             if (scaleStatus != STATUS_GRINDING_IN_PROGRESS && hx711_fail_count >= 5) {
-                Serial.println("HX711 failed 5 times, skipping readings for 500ms.");
+                LOGW(TAG_HX711, "HX711 failed 5 times, skipping readings for 500ms.");
                 vTaskDelay(500 / portTICK_PERIOD_MS);
                 hx711_fail_count = 0;
             }
         }
-        vTaskDelay(xDelay); // Wait 100ms before next read (10Hz)
     }
 }
 
-// Toggles the grinder on or off based on mode
-void grinderToggle() {
-    Serial.println("[grinderToggle] called");
-    // Toggle grinder/LED output
-    if (!grinderActive) {
-        Serial.println("[grinderToggle] BEFORE digitalWrite ON");
-        digitalWrite(GRINDER_ACTIVE_PIN, LOW); // Relay/LED ON
-        delay(1); // Minimal delay after toggling ON
-        Serial.println("[grinderToggle] AFTER digitalWrite ON");
-        grinderActive = true;
-        Serial.println("Grinder/LED ON");
+StabilityState scaleStability() {
+    portENTER_CRITICAL(&stabilityMux);
+    StabilityState copy = weightStabilityState;
+    portEXIT_CRITICAL(&stabilityMux);
+    return copy;
+}
+
+bool grindSettledWeight(double &grams) {
+    if (finishedSettledAt == 0) return false;
+    grams = finishedSettledWeight;
+    return true;
+}
+
+bool grinderBusy() {
+    return scaleStatus == STATUS_GRINDING_IN_PROGRESS || scaleStatus == STATUS_RELAY_TEST || grinderActive;
+}
+
+GrindPredictor grindPredictorSnapshot() {
+    portENTER_CRITICAL(&sessionMux);
+    GrindPredictor copy = grindPredictor;
+    portEXIT_CRITICAL(&sessionMux);
+    return copy;
+}
+
+void grindPredictorSetModel(float latencyS, float inFlightG) {
+    portENTER_CRITICAL(&sessionMux);
+    grindPredictor.setModel(latencyS, inFlightG);
+    predictorLatencyS = grindPredictor.latency();
+    predictorInFlightG = grindPredictor.inFlight();
+    portEXIT_CRITICAL(&sessionMux);
+    settingsTouch(SET_PRED_LATENCY);
+    settingsTouch(SET_PRED_IN_FLIGHT);
+}
+
+// Computes the grind target and switches the grinder on through the session.
+// trigger is "button" or "cup" for the grind_start event.
+static void startGrind(const char *trigger) {
+    double currentOffset = shotOffset;
+    if (scaleMode || PREDICTIVE_STOP) {
+        // The predictor models runout itself; shotOffset only applies
+        // to the legacy threshold stop
+        currentOffset = 0;
+    }
+    double grindTarget;
+    if (grindMode && !manualGrindMode) {
+        // Button-activated automatic grinding: ignore cup weight
+        grindTarget = setWeight + currentOffset;
     } else {
-        Serial.println("[grinderToggle] BEFORE digitalWrite OFF");
-        digitalWrite(GRINDER_ACTIVE_PIN, HIGH); // Relay/LED OFF
-        delay(1); // Minimal delay after toggling OFF
-        Serial.println("[grinderToggle] AFTER digitalWrite OFF");
-        grinderActive = false;
-        Serial.println("Grinder/LED OFF");
+        // Other modes: include cup weight
+        grindTarget = cupWeightEmpty + setWeight + currentOffset;
     }
+    portENTER_CRITICAL(&sessionMux);
+    grindSession.start((float)grindTarget, (float)cupWeightEmpty, scaleMode, PREDICTIVE_STOP);
+    portEXIT_CRITICAL(&sessionMux);
+    finishedSettledAt = 0;
+    grindStartedAt = millis();
+    LOGI(TAG_SCALE, "Grinder ON, target %.2fg", grindTarget);
+    grindEventPublish(GRIND_EVENT_START,
+                      "{\"grind\":%u,\"target\":%.2f,\"cup\":%.2f,\"trigger\":\"%s\",\"mode\":\"%s\"}",
+                      ++grindNumber, setWeight, cupWeightEmpty, trigger, scaleMode ? "scale" : "weight");
+}
+
+// Wake the display when this task changed the status, so grind start/stop is
+// drawn without waiting for a deadline (the UI task notifies on its own)
+static void notifyStatusChange() {
+    static int lastStatus = -1;
+    if (scaleStatus != lastStatus) {
+        lastStatus = scaleStatus;
+        displayNotify(DISPLAY_STATE);
+    }
+}
+
+// HX711 mode for the current state: 80 SPS while grinding and until the
+// weight has settled after the stop (at most SAMPLE_RATE_FAST_HOLD_MS),
+// powered down while the display sleeps
+// if a button (which wakes the screen) starts the grind, 10 SPS otherwise.
+// Cup detection needs the weight, so it keeps sampling while asleep.
+static void updateSampleRate() {
+    SampleRate rate = RATE_IDLE;
+    bool asleep = millis() - lastSignificantWeightChangeAt > (unsigned long)sleepTime;
+    if (scaleStatus == STATUS_GRINDING_IN_PROGRESS || scaleStatus == STATUS_RELAY_TEST) {
+        rate = RATE_FAST;
+    } else if ((scaleStatus == STATUS_GRINDING_FINISHED || scaleStatus == STATUS_GRINDING_FAILED) &&
+               finishedSettledAt == 0 && millis() - finishedGrindingAt < SAMPLE_RATE_FAST_HOLD_MS) {
+        rate = RATE_FAST;
+    } else if (asleep && scaleStatus == STATUS_EMPTY && (grindMode || manualGrindMode)) {
+        rate = RATE_OFF;
+    }
+    acquisitionSetRate(rate);
 }
 
 // Task to manage the status of the scale
@@ -329,7 +534,9 @@ void scaleStatusLoop(void *p) {
         // Monitor heap and stack usage (deactivated)
         // Serial.printf("[Heap] Free: %u | [Stack] High Water Mark: %u\n", ESP.getFreeHeap(), uxTaskGetStackHighWaterMark(NULL));
         vTaskDelay(1); // Minimal delay to mitigate timing/race condition
-        double tenSecAvg = weightHistory.averageSince((int64_t)millis() - 10000);
+        notifyStatusChange();
+        updateSampleRate();
+        double tenSecAvg = weightHistory.averageOver(HISTORY_ESTIMATE, 10000);
         if (ABS(tenSecAvg - scaleWeight) > SIGNIFICANT_WEIGHT_CHANGE) {
             lastSignificantWeightChangeAt = millis();
         }
@@ -337,7 +544,6 @@ void scaleStatusLoop(void *p) {
             case STATUS_EMPTY: {
                 // Auto-tare is disabled except for startup (handled in updateScale)
                 static bool grinderButtonPressed = false;
-                static unsigned long grinderButtonPressedAt = 0;
                 static bool manualGrinderActive = false;
 
                 // Manual grind mode - direct control of grinder with button
@@ -346,20 +552,14 @@ void scaleStatusLoop(void *p) {
                     if (buttonCurrentlyPressed && !manualGrinderActive) {
                         // Button just pressed - start grinder
                         manualGrinderActive = true;
-                        Serial.println("[ManualGrind] BEFORE digitalWrite ON");
-                        digitalWrite(GRINDER_ACTIVE_PIN, LOW); // Relay ON
-                        delay(1); // Minimal delay after toggling ON
-                        Serial.println("[ManualGrind] AFTER digitalWrite ON");
-                        Serial.println("Manual grind: Grinder ON");
+                        grinderRelay.set(true);
+                        LOGI(TAG_SCALE, "Manual grind: Grinder ON");
                         wakeScreen();
                     } else if (!buttonCurrentlyPressed && manualGrinderActive) {
                         // Button just released - stop grinder
                         manualGrinderActive = false;
-                        Serial.println("[ManualGrind] BEFORE digitalWrite OFF");
-                        digitalWrite(GRINDER_ACTIVE_PIN, HIGH); // Relay OFF
-                        delay(1); // Minimal delay after toggling OFF
-                        Serial.println("[ManualGrind] AFTER digitalWrite OFF");
-                        Serial.println("Manual grind: Grinder OFF");
+                        grinderRelay.set(false);
+                        LOGI(TAG_SCALE, "Manual grind: Grinder OFF");
                     }
                     break; // Skip automatic grinding logic when in manual mode
                 }
@@ -367,25 +567,21 @@ void scaleStatusLoop(void *p) {
                 // Only allow button trigger if grindMode == true (automatic mode)
                 if (grindMode && digitalRead(GRIND_BUTTON_PIN) == LOW && !grinderButtonPressed) {
                     grinderButtonPressed = true;
-                    grinderButtonPressedAt = millis();
                     wakeScreen(); // wake screen immediately
-                    Serial.println("Grinder button pressed, taring and waking screen...");
+                    LOGI(TAG_SCALE, "Grinder button pressed, taring and waking screen...");
                     // Tare the scale before starting grinding
-                    requestTare = true;
+                    tareScale();
                 }
             
-                if (grindMode && grinderButtonPressed && millis() - grinderButtonPressedAt >= 600) {
+                // Start as soon as the new zero has settled
+                if (grindMode && grinderButtonPressed && !tareInProgress()) {
                     grinderButtonPressed = false; // reset flag
-                        // Capture a fresh, short-average reading for the empty cup weight so we don't
-                        // rely on heavily-filtered `scaleWeight` which can lag and introduce bias.
-                        if (loadcell.wait_ready_timeout(500)) {
-                            long raw_tare = loadcell.read_average(5);
-                            long off = loadcell.get_offset();
-                            cupWeightEmpty = (double)(raw_tare - off) / scaleFactor;
-                        } else {
-                            // fallback to filtered value if HX711 not ready
-                            cupWeightEmpty = scaleWeight;
-                        }
+                    // The tare zeroed the empty cup; if it failed fall back to
+                    // the filtered weight
+                    cupWeightEmpty = tareWait(0) ? 0 : scaleWeight;
+                    // Start the session first so the target is set before the
+                    // scale task (and the trace recorder) sees the new status
+                    startGrind("button");
                     scaleStatus = STATUS_GRINDING_IN_PROGRESS;
                     // Ensure display shows the stuck-grounds compensation from the
                     // start of the grind so the finished screen already reflects it.
@@ -394,17 +590,18 @@ void scaleStatusLoop(void *p) {
                         newOffset = true;
                         startedGrindingAt = millis();
                     }
-                    grinderToggle();
-                    Serial.println("Grinding started after tare and delay.");
+                    LOGI(TAG_SCALE, "Grinding started after tare.");
                     continue;
                 }
             
-                // Only allow cup trigger if grindMode == false
-                if (!grindMode &&
-                    ABS(weightHistory.minSince(millis() - 1000) - setCupWeight) < CUP_DETECTION_TOLERANCE &&
-                    ABS(weightHistory.maxSince(millis() - 1000) - setCupWeight) < CUP_DETECTION_TOLERANCE) {
-                    
-                    cupWeightEmpty = weightHistory.averageSince(millis() - 500);
+                // Only allow cup trigger if grindMode == false; starts as soon
+                // as a cup of about the set weight has stopped moving
+                StabilityState stability = scaleStability();
+                if (!grindMode && stability.stable && ABS(stability.mean - setCupWeight) < CUP_DETECTION_TOLERANCE) {
+                    cupWeightEmpty = stability.mean;
+                    // Start the session first so the target is set before the
+                    // scale task (and the trace recorder) sees the new status
+                    startGrind("cup");
                     scaleStatus = STATUS_GRINDING_IN_PROGRESS;
                     // Ensure display shows the stuck-grounds compensation from the
                     // start of the grind so the finished screen already reflects it.
@@ -413,8 +610,7 @@ void scaleStatusLoop(void *p) {
                         newOffset = true;
                         startedGrindingAt = millis();
                     }
-                    grinderToggle();
-                    Serial.println("Grinding started from cup detection.");
+                    LOGI(TAG_SCALE, "Grinding started from cup detection.");
                     continue;
                 }
             
@@ -422,105 +618,104 @@ void scaleStatusLoop(void *p) {
             }            
         case STATUS_GRINDING_IN_PROGRESS:
         {
-            if (scaleWeight < -10.0)
-            { // Only fail if weight is significantly negative (cup removed)
-                Serial.println("GRINDING FAILED: Significantly negative weight detected (cup removed).");
-                grinderToggle(); // Ensure grinder is off
-                scaleStatus = STATUS_GRINDING_FAILED;
-                continue;
-            }
-            if (!scaleReady)
-            {
-                Serial.println("GRINDING FAILED: Scale not ready");
-                grinderToggle();
-                scaleStatus = STATUS_GRINDING_FAILED;
-                continue;
-            }
-                if (scaleMode && startedGrindingAt == 0 && scaleWeight - cupWeightEmpty >= 0.1) {
-                startedGrindingAt = millis();
-                continue;
-            }
-                if (millis() - startedGrindingAt > MAX_GRINDING_TIME && !scaleMode) {
-                Serial.println("GRINDING FAILED: Max grinding time exceeded");
-                grinderToggle();
-                scaleStatus = STATUS_GRINDING_FAILED;
-                continue;
+            // The scale task takes the stop decision per sample. This call
+            // only catches what needs no new sample: the HX711 dropping out
+            // and the time limits.
+            portENTER_CRITICAL(&sessionMux);
+            grindSession.update((float)scaleWeight, scaleReady);
+            GrindSession::State state = grindSession.state();
+            GrindSession::Failure failure = grindSession.failure();
+            uint32_t startedAt = grindSession.startedAt();
+            bool byPrediction = grindSession.stoppedByPrediction();
+            float target = grindSession.target();
+            portEXIT_CRITICAL(&sessionMux);
+
+            if (scaleMode && startedGrindingAt == 0 && startedAt != 0) {
+                startedGrindingAt = startedAt; // first grounds arrived
             }
-            if (millis() - startedGrindingAt > 5000 &&
-                scaleWeight - weightHistory.firstValueOlderThan(millis() - 5000) < 1 &&
-                    !scaleMode) {
-                Serial.println("GRINDING FAILED: No weight increase after 2 seconds");
-                grinderToggle();
-                scaleStatus = STATUS_GRINDING_FAILED;
-                continue;
+            if (state == GrindSession::RUNNING) {
+                break;
             }
-                if (weightHistory.minSince((int64_t)millis() - 200) < cupWeightEmpty - CUP_DETECTION_TOLERANCE && !scaleMode) {
-                Serial.printf("GRINDING FAILED: Cup removed - min weight: %.2f, cup weight: %.2f, tolerance: %d\n", 
-                             weightHistory.minSince((int64_t)millis() - 200), cupWeightEmpty, CUP_DETECTION_TOLERANCE);
-                grinderToggle();
+            if (state == GrindSession::FAILED) {
+                LOGW(TAG_SCALE, "GRINDING FAILED: %s", GrindSession::failureName(failure));
+                grindEventPublish(GRIND_EVENT_FAILED,
+                                  "{\"grind\":%u,\"reason\":\"%s\",\"text\":\"%s\",\"weight\":%.2f,\"ms\":%lu}",
+                                  grindNumber, GrindSession::failureKey(failure), GrindSession::failureName(failure),
+                                  scaleWeight - cupWeightEmpty, millis() - grindStartedAt);
                 scaleStatus = STATUS_GRINDING_FAILED;
                 continue;
             }
-            double currentOffset = shotOffset;
-                if (scaleMode) {
-                currentOffset = 0;
-            }
-                double grindTarget;
-                if (grindMode && !manualGrindMode) {
-                    // Button-activated automatic grinding: ignore cup weight
-                    grindTarget = setWeight + currentOffset;
-                } else {
-                    // Other modes: include cup weight
-                    grindTarget = cupWeightEmpty + setWeight + currentOffset;
-                }
-                if (weightHistory.maxSince((int64_t)millis() - 200) >= grindTarget) {
-                    finishedGrindingAt = millis();
-                    grinderToggle();
-                    scaleStatus = STATUS_GRINDING_FINISHED;
-                    // Mark that the display should apply the stuck-grounds compensation
-                    // until the user leaves the "Grinding finished" screen.
-                    display_compensate_shot = true;
-                    continue;
-                }
-            break;
+            finishedGrindingAt = millis();
+            // One copy for the log and the event: the scale task keeps
+            // feeding the predictor while the weight coasts
+            GrindPredictor predictor = grindPredictorSnapshot();
+            float stopFlow = predictor.flowAtStop();
+            float stopWeight = predictor.weightAtStop();
+            float predictedFinal = stopWeight + stopFlow * predictor.latency() + predictor.inFlight();
+            LOGI(TAG_PREDICTOR, "Stop at %.2fg, flow %.2fg/s, predicted final %.2fg (target %.2fg)%s",
+                 stopWeight, stopFlow, predictedFinal, target, byPrediction ? "" : " [threshold]");
+            grindEventPublish(GRIND_EVENT_STOP,
+                              "{\"grind\":%u,\"weight\":%.2f,\"flow\":%.2f,\"predicted\":%.2f,\"by\":\"%s\",\"ms\":%lu}",
+                              grindNumber, stopWeight - cupWeightEmpty, stopFlow, predictedFinal - cupWeightEmpty,
+                              byPrediction ? "prediction" : "threshold", finishedGrindingAt - grindStartedAt);
+            scaleStatus = STATUS_GRINDING_FINISHED;
+            // Mark that the display should apply the stuck-grounds compensation
+            // until the user leaves the "Grinding finished" screen.
+            display_compensate_shot = true;
+            continue;
         }
         case STATUS_GRINDING_FINISHED:
         {
             static unsigned long grindingFinishedAt = 0;
+            // Stable windows that began before this do not count as settled
+            static unsigned long settleFrom = 0;
+            static bool vibed = false;
 
             // Record the time when grinding finished if not already recorded
             if (grindingFinishedAt == 0)
             {
                 grindingFinishedAt = millis();
-                Serial.print("Grinder was on for: ");
-                Serial.print(grindingFinishedAt);
-                Serial.println(" seconds");
+                settleFrom = finishedGrindingAt;
+                vibed = false;
+                LOGI(TAG_SCALE, "Grinder was on for: %.1f seconds", (grindingFinishedAt - startedGrindingAt) / 1000.0);
             }
 
-            // Short-term average of recent weights (used as fallback)
-            double currentWeight = weightHistory.averageSince((int64_t)millis() - 500);
             if (scaleWeight < 5) {
                 startedGrindingAt = 0;
                 grindingFinishedAt = 0; // Reset the timestamp
                 scaleWeight = 0;
                 scaleStatus = STATUS_EMPTY;
                 continue;
-            } else if (millis() - finishedGrindingAt > 5000) {
-                // After the finish timeout we may optionally pulse the grinder relay to
-                // help dislodge adhered grounds. The automatic shotOffset adjustment
-                // used to run here; the adjustment now occurs only when the user
-                // presses the button to leave the finished screen (see
-                // applyShotOffsetAdjustmentOnExit()).
-                if (auto_vibe_after_grind && !grinderActive) {
-                    Serial.println("Auto-vibe: pulsing grinder relay to settle grounds...");
-                    for (int i = 0; i < 2; ++i) {
-                        digitalWrite(GRINDER_ACTIVE_PIN, LOW); // ON
-                        delay(60);
-                        digitalWrite(GRINDER_ACTIVE_PIN, HIGH); // OFF
-                        delay(80);
+            } else if (finishedSettledAt == 0) {
+                // The settled weight is what the predictor learns from and
+                // what the finished screen shows. Once the grounds stopped
+                // moving we may optionally pulse the grinder relay to help
+                // dislodge adhered grounds, and wait for them to settle again.
+                StabilityState stability = scaleStability();
+                if (stability.stable && millis() - stability.stableForMs >= settleFrom) {
+                    if (auto_vibe_after_grind && !vibed && !grinderActive) {
+                        LOGI(TAG_SCALE, "Auto-vibe: pulsing grinder relay to settle grounds...");
+                        for (int i = 0; i < 2; ++i) {
+                            grinderRelay.set(true);
+                            delay(60);
+                            grinderRelay.set(false);
+                            delay(80);
+                        }
+                        vibed = true;
+                        settleFrom = millis();
+                    } else {
+                        finishedSettledAt = millis();
+                        finishedSettledWeight = stability.mean;
+                        LOGI(TAG_SCALE, "Weight settled at %.2fg, %lu ms after the stop", finishedSettledWeight,
+                             finishedSettledAt - finishedGrindingAt);
+                        displayNotify(DISPLAY_WEIGHT);
+                        double net = finishedSettledWeight - cupWeightEmpty;
+                        grindEventPublish(GRIND_EVENT_SETTLED,
+                                          "{\"grind\":%u,\"weight\":%.2f,\"target\":%.2f,\"error\":%.2f,"
+                                          "\"settleMs\":%lu}",
+                                          grindNumber, net, setWeight, net - setWeight,
+                                          finishedSettledAt - finishedGrindingAt);
                     }
-                    // small settle delay
-                    delay(150);
                 }
             }
 
@@ -529,14 +724,14 @@ void scaleStatusLoop(void *p) {
             { // 5-second delay after grinding finishes
                 if (scaleWeight >= 3)
                 { // If weight is still on the scale, wait for cup removal
-                    Serial.println("Waiting for cup to be removed...");
+                    LOGI(TAG_SCALE, "Waiting for cup to be removed...");
                 }
                 else
                 {
                     startedGrindingAt = 0;
                     grindingFinishedAt = 0; // Reset the timestamp
                     scaleStatus = STATUS_EMPTY;
-                    Serial.println("Grinding finished. Transitioning to main menu.");
+                    LOGI(TAG_SCALE, "Grinding finished. Transitioning to main menu.");
                 }
             }
             break;
@@ -551,7 +746,7 @@ void scaleStatusLoop(void *p) {
             break;
         }
         }
-        rotary_loop();
+        notifyStatusChange();
         delay(50);
     }
 }
@@ -610,46 +805,15 @@ void setupScale() {
     
     Serial.println("Initializing load cell...");
     // Set HX711 to 10Hz (default debug mode)
-    loadcell.begin(LOADCELL_DOUT_PIN, LOADCELL_SCK_PIN); // default 10 Hz mode
+    loadcell.begin(LOADCELL_DOUT_PIN, LOADCELL_SCK_PIN); // 10 SPS until the status loop asks for another rate
     pinMode(GRINDER_ACTIVE_PIN, OUTPUT);
     pinMode(GRIND_BUTTON_PIN, INPUT_PULLUP);
     digitalWrite(GRINDER_ACTIVE_PIN, HIGH); // Initialize HIGH = Relay OFF = Grinder stopped
     Serial.println("Load cell and pins initialized.");
 
-    preferences.begin("scale", false);
-
-    // Load stored calibration into the global scaleFactor (do NOT shadow)
-    scaleFactor = preferences.getDouble("calibration", (double)LOADCELL_SCALE_FACTOR);
-    if (scaleFactor <= 0 || std::isnan(scaleFactor)) {
-        scaleFactor = LOADCELL_SCALE_FACTOR;
-        preferences.putDouble("calibration", scaleFactor);
-        Serial.println("Invalid scale factor detected. Resetting to default.");
-    }
-    // Load secondary calibration if configured
-    if (LOADCELL2_DOUT_PIN != -1) {
-        scaleFactor2 = preferences.getDouble("calibration2", (double)LOADCELL2_SCALE_FACTOR);
-        loadcell2_offset = (long)preferences.getLong("offset2", 0);
-        if (scaleFactor2 <= 0 || std::isnan(scaleFactor2)) {
-            scaleFactor2 = LOADCELL2_SCALE_FACTOR;
-            preferences.putDouble("calibration2", scaleFactor2);
-            Serial.println("Invalid scaleFactor2 detected. Resetting to default.");
-        }
-    }
-    setWeight = preferences.getDouble("setWeight", (double)COFFEE_DOSE_WEIGHT);
-    // Load shotOffset with migration: prefer stored "shotOffset", fallback to legacy "offset"
-    shotOffset = preferences.getDouble("shotOffset", preferences.getDouble("offset", (double)COFFEE_DOSE_OFFSET));
-    // Load primary HX711 raw offset counts (fallback to current library offset)
-    loadcell_offset = (long)preferences.getLong("offset1", loadcell.get_offset());
-    setCupWeight = preferences.getDouble("cup", (double)CUP_WEIGHT);
-    scaleMode = preferences.getBool("scaleMode", false);
-    grindMode = preferences.getBool("grindMode", false);
-    shotCount = preferences.getUInt("shotCount", 0);
-    sleepTime = preferences.getInt("sleepTime", SLEEP_AFTER_MS); // Default to SLEEP_AFTER_MS if not set
-    useButtonToGrind = preferences.getBool("grindTrigger", DEFAULT_GRIND_TRIGGER_MODE);
-    manualGrindMode = preferences.getBool("manualGrindMode", false);
-    // Load persisted display compensation (fallback to current default)
-    display_compensation_g = preferences.getDouble("displayCompensation", display_compensation_g);
-    preferences.end();
+    // Calibration, offsets, dose and mode settings into their globals
+    settingsLoad();
+    grindPredictor.setModel(predictorLatencyS, predictorInFlightG);
     Serial.printf("→ scaleFactor = %.6f  |  shotOffset = %.6f\n", scaleFactor, shotOffset);
     // Apply calibration to HX711 library and set stored raw offset counts
     loadcell.set_scale(scaleFactor);
@@ -662,16 +826,29 @@ void setupScale() {
         Serial.printf("→ scaleFactor2 = %.6f  |  offset2 = %ld\n", scaleFactor2, loadcell2_offset);
         }
     Serial.printf("→ Manual Grind Mode: %s\n", manualGrindMode ? "ENABLED" : "DISABLED");
-        // Load optional micro-vibe preference (default disabled)
-        preferences.begin("scale", false);
-        auto_vibe_after_grind = preferences.getBool("autoVibe", false);
-        preferences.end();
         Serial.printf("→ autoVibeAfterGrind = %s\n", auto_vibe_after_grind ? "ENABLED" : "DISABLED");
         // loadcell.set_scale(scaleFactor); // Not used in debug form
         // loadcell.set_offset(offset); // Not used in debug form
 
-    xTaskCreatePinnedToCore(updateScale, "Scale", 20000, NULL, 0, &ScaleTask, 1);
-    xTaskCreatePinnedToCore(scaleStatusLoop, "ScaleStatus", 20000, NULL, 0, &ScaleStatusTask, 1);
+    // Windows used by the status loop (significant change, final weight
+    // fallback, grind stop); stability decisions use the detectors
+    weightHistory.addWindow(HISTORY_ESTIMATE, 10000);
+    weightHistory.addWindow(HISTORY_FUSED, 500);
+    weightHistory.addWindow(HISTORY_ESTIMATE, 200);
+
+    GrindLimits limits;
+    limits.maxGrindMs = MAX_GRINDING_TIME;
+    limits.cupToleranceG = CUP_DETECTION_TOLERANCE;
+    grindSession.setLimits(limits);
+
+    weightFilterSetup();
+    tareEvents = xEventGroupCreate();
+    tareMutex = xSemaphoreCreateMutex();
+    setupAcquisition();
+    xTaskCreatePinnedToCore(updateScale, "Scale", TASK_SCALE_STACK, NULL, TASK_SCALE_PRIORITY, &ScaleTask, TASK_SCALE_CORE);
+    xTaskCreatePinnedToCore(scaleStatusLoop, "ScaleStatus", TASK_STATUS_STACK, NULL, TASK_STATUS_PRIORITY, &ScaleStatusTask,
+                            TASK_STATUS_CORE);
+    setupRotaryTask();
 }
 
 // Perform the final raw reads and apply shotOffset adjustment if needed.
@@ -683,38 +860,44 @@ void applyShotOffsetAdjustmentOnExit()
 {
     if (!newOffset) {
         // Nothing to do
-        Serial.println("applyShotOffsetAdjustmentOnExit: no pending offset to adjust");
+        LOGI(TAG_SCALE, "applyShotOffsetAdjustmentOnExit: no pending offset to adjust");
         return;
     }
 
-    // Read fresh raw averages from both sensors for the final weight to avoid
-    // long filter tails; fall back to the filtered values if HX711 isn't ready.
-    double final1 = weightHistory.averageSince((int64_t)millis() - 500);
-    double final2 = 0.0;
-    if (loadcell.wait_ready_timeout(500)) {
-        long raw_final1 = loadcell.read_average(5);
-        final1 = (double)(raw_final1 - loadcell.get_offset()) / scaleFactor;
+    // The unfiltered mean the fused weight settled at after the stop (no
+    // filter tail, and still valid if the cup was lifted since); if it never
+    // settled, the last half second of fused weight.
+    double actualWeight;
+    if (!grindSettledWeight(actualWeight)) {
+        actualWeight = weightHistory.averageOver(HISTORY_FUSED, 500);
+        LOGW(TAG_SCALE, "Weight did not settle, using the last 500 ms (%.2fg)", actualWeight);
     }
-    if (LOADCELL2_DOUT_PIN != -1) {
-        if (loadcell2.wait_ready_timeout(500)) {
-            long raw_final2 = loadcell2.read_average(5);
-            final2 = (double)(raw_final2 - loadcell2.get_offset()) / scaleFactor2;
-        } else {
-            final2 = scaleWeight2; // fallback
-        }
-    }
-
-    double actualWeight = (LOADCELL2_DOUT_PIN != -1) ? ((final1 + final2) / 2.0) : final1;
     // Apply a small compensation for adhered grounds observed in some setups.
     if (startedGrindingAt > 0) {
         actualWeight += display_compensation_g;
-        Serial.printf("[AUTO ADJUST] Applied +%.2fg compensation to actualWeight to account for stuck grounds\n", display_compensation_g);
+        LOGI(TAG_SCALE, "Applied +%.2fg compensation to actualWeight to account for stuck grounds", display_compensation_g);
     }
 
     double targetTotalWeight = setWeight + cupWeightEmpty;
     double weightError = targetTotalWeight - actualWeight;
 
-#if defined(AUTO_OFFSET_ADJUSTMENT) && AUTO_OFFSET_ADJUSTMENT
+#if PREDICTIVE_STOP
+    // The predictor learns relay latency and in-flight mass from the settled
+    // weight instead of biasing the target with shotOffset
+    portENTER_CRITICAL(&sessionMux);
+    bool learned = grindPredictor.learn((float)actualWeight);
+    portEXIT_CRITICAL(&sessionMux);
+    shotCount++;
+    settingsTouch(SET_SHOT_COUNT);
+    if (learned) {
+        predictorLatencyS = grindPredictor.latency();
+        predictorInFlightG = grindPredictor.inFlight();
+        settingsTouch(SET_PRED_LATENCY);
+        settingsTouch(SET_PRED_IN_FLIGHT);
+        LOGI(TAG_PREDICTOR, "Error %.2fg -> latency %.3fs, in-flight %.2fg",
+             weightError, grindPredictor.latency(), grindPredictor.inFlight());
+    }
+#elif defined(AUTO_OFFSET_ADJUSTMENT) && AUTO_OFFSET_ADJUSTMENT
     if (ABS(weightError) > 0.3) { // Only adjust if error is significant (>0.3g)
         double oldShotOffset = shotOffset;
         shotOffset += weightError;
@@ -723,32 +906,23 @@ void applyShotOffsetAdjustmentOnExit()
         if (shotOffset > 10.0) shotOffset = 10.0;
         if (shotOffset < -10.0) shotOffset = -10.0;
 
-        Serial.printf("AUTO SHOT OFFSET ADJUSTMENT:\n");
-        Serial.printf("  Target: %.1fg, Actual: %.1fg, Error: %.1fg\n", 
-                     targetTotalWeight, actualWeight, weightError);
-        Serial.printf("  Old shotOffset: %.2fg -> New shotOffset: %.2fg\n", 
-                     oldShotOffset, shotOffset);
+        LOGI(TAG_SCALE, "Auto shot offset adjustment: target %.1fg, actual %.1fg, error %.1fg, shotOffset %.2fg -> %.2fg",
+             targetTotalWeight, actualWeight, weightError, oldShotOffset, shotOffset);
 
         shotCount++;
-        preferences.begin("scale", false);
-        preferences.putDouble("shotOffset", shotOffset);
-        preferences.putUInt("shotCount", shotCount);
-        preferences.end();
+        settingsTouch(SET_SHOT_OFFSET);
+        settingsTouch(SET_SHOT_COUNT);
     } else {
-        Serial.printf("Grinding accuracy good (error: %.1fg) - no shotOffset adjustment needed\n", weightError);
+        LOGI(TAG_SCALE, "Grinding accuracy good (error: %.1fg) - no shotOffset adjustment needed", weightError);
         shotCount++;
-        preferences.begin("scale", false);
-        preferences.putUInt("shotCount", shotCount);
-        preferences.end();
+        settingsTouch(SET_SHOT_COUNT);
     }
 #else
     // Auto-offset adjustment disabled - just increment shot count
     shotCount++;
-    preferences.begin("scale", false);
-    preferences.putUInt("shotCount", shotCount);
-    preferences.end();
+    settingsTouch(SET_SHOT_COUNT);
 #endif
 
     newOffset = false;
-    Serial.println("applyShotOffsetAdjustmentOnExit: finished");
+    LOGI(TAG_SCALE, "applyShotOffsetAdjustmentOnExit: finished");
 }
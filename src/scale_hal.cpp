@@ -0,0 +1,14 @@
+#include "scale_hal.hpp"
+#include "config.hpp"
+
+extern bool grinderActive;
+
+MillisClock systemClock;
+GpioRelay grinderRelay;
+
+void GpioRelay::set(bool on) {
+    // Writing the level that is already set is harmless, so off can be
+    // requested from any path without tracking who switched it on
+    digitalWrite(GRINDER_ACTIVE_PIN, on ? LOW : HIGH);
+    grinderActive = on;
+}
@@ -0,0 +1,275 @@
+#include "settings.hpp"
+#include "config.hpp"
+#include "log.hpp"
+#include <cmath>
+
+extern double scaleFactor;
+extern float predictorLatencyS;
+extern float predictorInFlightG;
+
+enum SettingType : uint8_t { TYPE_DOUBLE, TYPE_FLOAT, TYPE_LONG, TYPE_INT, TYPE_UINT, TYPE_BOOL };
+
+union SettingValue {
+    double d;
+    float f;
+    long l;
+    int i;
+    unsigned int u;
+    bool b;
+};
+
+struct Setting {
+    const char *key;
+    SettingType type;
+    void *value;             // the runtime global
+    SettingValue fallback;   // default when the key is missing
+    SettingValue stored;     // what NVS holds (valid once loaded)
+};
+
+#define DOUBLE_SETTING(key, var, def) { key, TYPE_DOUBLE, &var, { .d = (double)(def) }, {} }
+#define FLOAT_SETTING(key, var, def)  { key, TYPE_FLOAT, &var, { .f = (float)(def) }, {} }
+#define LONG_SETTING(key, var, def)   { key, TYPE_LONG, &var, { .l = (long)(def) }, {} }
+#define INT_SETTING(key, var, def)    { key, TYPE_INT, &var, { .i = (int)(def) }, {} }
+#define UINT_SETTING(key, var, def)   { key, TYPE_UINT, &var, { .u = (unsigned int)(def) }, {} }
+#define BOOL_SETTING(key, var, def)   { key, TYPE_BOOL, &var, { .b = (bool)(def) }, {} }
+
+// Order must match SettingKey
+static Setting settings[SETTING_COUNT] = {
+    DOUBLE_SETTING("calibration", scaleFactor, LOADCELL_SCALE_FACTOR),
+    DOUBLE_SETTING("calibration2", scaleFactor2, LOADCELL2_SCALE_FACTOR),
+    LONG_SETTING("offset1", loadcell_offset, 0),
+    LONG_SETTING("offset2", loadcell2_offset, 0),
+    DOUBLE_SETTING("setWeight", setWeight, COFFEE_DOSE_WEIGHT),
+    DOUBLE_SETTING("shotOffset", shotOffset, COFFEE_DOSE_OFFSET),
+    DOUBLE_SETTING("cup", setCupWeight, CUP_WEIGHT),
+    BOOL_SETTING("scaleMode", scaleMode, false),
+    BOOL_SETTING("grindMode", grindMode, false),
+    UINT_SETTING("shotCount", shotCount, 0),
+    INT_SETTING("sleepTime", sleepTime, SLEEP_AFTER_MS),
+    BOOL_SETTING("grindTrigger", useButtonToGrind, DEFAULT_GRIND_TRIGGER_MODE),
+    BOOL_SETTING("manualGrindMode", manualGrindMode, false),
+    DOUBLE_SETTING("displayCompensation", display_compensation_g, 1.0),
+    BOOL_SETTING("autoVibe", auto_vibe_after_grind, false),
+    FLOAT_SETTING("predLatency", predictorLatencyS, PREDICTOR_DEFAULT_LATENCY_S),
+    FLOAT_SETTING("predInFlight", predictorInFlightG, PREDICTOR_DEFAULT_IN_FLIGHT_G),
+};
+
+static portMUX_TYPE settingsMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t dirtyMask = 0;
+static uint32_t lastTouchAt = 0;
+static SettingsStats stats = {0, 0, 0, 0};
+
+static_assert(SETTING_COUNT <= 32, "dirty flags are kept in one 32-bit mask");
+
+static SettingValue readGlobal(const Setting &s) {
+    SettingValue v = {};
+    switch (s.type) {
+        case TYPE_DOUBLE: v.d = *(double *)s.value; break;
+        case TYPE_FLOAT: v.f = *(float *)s.value; break;
+        case TYPE_LONG: v.l = *(long *)s.value; break;
+        case TYPE_INT: v.i = *(int *)s.value; break;
+        case TYPE_UINT: v.u = *(unsigned int *)s.value; break;
+        case TYPE_BOOL: v.b = *(bool *)s.value; break;
+    }
+    return v;
+}
+
+static void writeGlobal(const Setting &s, const SettingValue &v) {
+    switch (s.type) {
+        case TYPE_DOUBLE: *(double *)s.value = v.d; break;
+        case TYPE_FLOAT: *(float *)s.value = v.f; break;
+        case TYPE_LONG: *(long *)s.value = v.l; break;
+        case TYPE_INT: *(int *)s.value = v.i; break;
+        case TYPE_UINT: *(unsigned int *)s.value = v.u; break;
+        case TYPE_BOOL: *(bool *)s.value = v.b; break;
+    }
+}
+
+static bool sameValue(const Setting &s, const SettingValue &a, const SettingValue &b) {
+    switch (s.type) {
+        case TYPE_DOUBLE: return a.d == b.d;
+        case TYPE_FLOAT: return a.f == b.f;
+        case TYPE_LONG: return a.l == b.l;
+        case TYPE_INT: return a.i == b.i;
+        case TYPE_UINT: return a.u == b.u;
+        case TYPE_BOOL: return a.b == b.b;
+    }
+    return false;
+}
+
+static SettingValue readNvs(const Setting &s, const SettingValue &fallback) {
+    SettingValue v = {};
+    switch (s.type) {
+        case TYPE_DOUBLE: v.d = preferences.getDouble(s.key, fallback.d); break;
+        case TYPE_FLOAT: v.f = preferences.getFloat(s.key, fallback.f); break;
+        case TYPE_LONG: v.l = preferences.getLong(s.key, fallback.l); break;
+        case TYPE_INT: v.i = preferences.getInt(s.key, fallback.i); break;
+        case TYPE_UINT: v.u = preferences.getUInt(s.key, fallback.u); break;
+        case TYPE_BOOL: v.b = preferences.getBool(s.key, fallback.b); break;
+    }
+    return v;
+}
+
+static bool writeNvs(const Setting &s, const SettingValue &v) {
+    switch (s.type) {
+        case TYPE_DOUBLE: return preferences.putDouble(s.key, v.d) > 0;
+        case TYPE_FLOAT: return preferences.putFloat(s.key, v.f) > 0;
+        case TYPE_LONG: return preferences.putLong(s.key, v.l) > 0;
+        case TYPE_INT: return preferences.putInt(s.key, v.i) > 0;
+        case TYPE_UINT: return preferences.putUInt(s.key, v.u) > 0;
+        case TYPE_BOOL: return preferences.putBool(s.key, v.b) > 0;
+    }
+    return false;
+}
+
+void settingsLoad() {
+    preferences.begin("scale", false);
+    for (int i = 0; i < SETTING_COUNT; ++i) {
+        Setting &s = settings[i];
+        SettingValue fallback = s.fallback;
+        if (i == SET_SHOT_OFFSET) {
+            // Migration: shotOffset used to be stored as "offset"
+            fallback.d = preferences.getDouble("offset", fallback.d);
+        }
+        // A missing key reads as the fallback; the shadow records the fallback
+        // too, so defaults are not written until they are changed
+        s.stored = readNvs(s, fallback);
+        writeGlobal(s, s.stored);
+    }
+    preferences.end();
+
+    // Reject corrupted calibration
+    if (scaleFactor <= 0 || std::isnan(scaleFactor)) {
+        scaleFactor = LOADCELL_SCALE_FACTOR;
+        settingsTouch(SET_CALIBRATION);
+        LOGW(TAG_SYSTEM, "Invalid scale factor detected. Resetting to default.");
+    }
+    if (scaleFactor2 <= 0 || std::isnan(scaleFactor2)) {
+        scaleFactor2 = LOADCELL2_SCALE_FACTOR;
+        settingsTouch(SET_CALIBRATION2);
+        LOGW(TAG_SYSTEM, "Invalid scaleFactor2 detected. Resetting to default.");
+    }
+}
+
+void settingsTouch(SettingKey key) {
+    if (key >= SETTING_COUNT) return;
+    portENTER_CRITICAL(&settingsMux);
+    dirtyMask |= 1UL << key;
+    lastTouchAt = millis();
+    stats.touches++;
+    portEXIT_CRITICAL(&settingsMux);
+}
+
+void settingsReset(SettingKey key) {
+    if (key >= SETTING_COUNT) return;
+    writeGlobal(settings[key], settings[key].fallback);
+    settingsTouch(key);
+}
+
+bool settingsDirty() {
+    return dirtyMask != 0;
+}
+
+void settingsFlush() {
+    portENTER_CRITICAL(&settingsMux);
+    uint32_t mask = dirtyMask;
+    dirtyMask = 0;
+    portEXIT_CRITICAL(&settingsMux);
+    if (mask == 0) return;
+
+    uint32_t written = 0, unchanged = 0, failed = 0;
+    bool opened = false;
+    for (int i = 0; i < SETTING_COUNT; ++i) {
+        if (!(mask & (1UL << i))) continue;
+        Setting &s = settings[i];
+        SettingValue current = readGlobal(s);
+        if (sameValue(s, current, s.stored)) {
+            unchanged++;
+            continue;
+        }
+        if (!opened) {
+            preferences.begin("scale", false);
+            opened = true;
+        }
+        if (writeNvs(s, current)) {
+            s.stored = current;
+            written++;
+        } else {
+            failed |= 1UL << i;
+        }
+    }
+    if (opened) preferences.end();
+
+    portENTER_CRITICAL(&settingsMux);
+    dirtyMask |= failed; // retry on the next flush
+    if (opened) stats.flushes++;
+    stats.writes += written;
+    stats.unchanged += unchanged;
+    portEXIT_CRITICAL(&settingsMux);
+    if (written > 0 || failed) {
+        LOGI(TAG_SYSTEM, "Settings flushed: %u written, %u unchanged%s", written, unchanged, failed ? ", some failed" : "");
+    }
+}
+
+void settingsService() {
+    if (dirtyMask == 0) return;
+    // Flush early when the display is about to sleep, the device may be
+    // unplugged without anyone touching it again
+    bool idle = millis() - lastSignificantWeightChangeAt > (unsigned long)sleepTime;
+    if (idle || millis() - lastTouchAt >= SETTINGS_QUIET_MS) {
+        settingsFlush();
+    }
+}
+
+SettingsStats settingsGetStats() {
+    portENTER_CRITICAL(&settingsMux);
+    SettingsStats copy = stats;
+    portEXIT_CRITICAL(&settingsMux);
+    return copy;
+}
+
+const char *settingsName(SettingKey key) {
+    return key < SETTING_COUNT ? settings[key].key : "";
+}
+
+SettingKey settingsFind(const char *name) {
+    for (int i = 0; i < SETTING_COUNT; ++i) {
+        if (strcmp(settings[i].key, name) == 0) return (SettingKey)i;
+    }
+    return SETTING_COUNT;
+}
+
+bool settingsIsBool(SettingKey key) {
+    return key < SETTING_COUNT && settings[key].type == TYPE_BOOL;
+}
+
+double settingsGet(SettingKey key) {
+    if (key >= SETTING_COUNT) return 0;
+    const Setting &s = settings[key];
+    SettingValue v = readGlobal(s);
+    switch (s.type) {
+        case TYPE_DOUBLE: return v.d;
+        case TYPE_FLOAT: return v.f;
+        case TYPE_LONG: return v.l;
+        case TYPE_INT: return v.i;
+        case TYPE_UINT: return v.u;
+        case TYPE_BOOL: return v.b ? 1 : 0;
+    }
+    return 0;
+}
+
+void settingsSet(SettingKey key, double value) {
+    if (key >= SETTING_COUNT) return;
+    const Setting &s = settings[key];
+    SettingValue v = {};
+    switch (s.type) {
+        case TYPE_DOUBLE: v.d = value; break;
+        case TYPE_FLOAT: v.f = (float)value; break;
+        case TYPE_LONG: v.l = lround(value); break;
+        case TYPE_INT: v.i = (int)lround(value); break;
+        case TYPE_UINT: v.u = (unsigned int)lround(value); break;
+        case TYPE_BOOL: v.b = value != 0; break;
+    }
+    writeGlobal(s, v);
+    settingsTouch(key);
+}
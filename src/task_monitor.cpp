@@ -0,0 +1,121 @@
+#include "task_monitor.hpp"
+#include "config.hpp"
+
+extern TaskHandle_t AcquisitionTask;
+extern TaskHandle_t DisplayTask;
+extern TaskHandle_t LogTask;
+extern TaskHandle_t UiTask;
+extern TaskHandle_t WebTask;
+
+struct MonitoredTask {
+    const char *name;
+    TaskHandle_t *handle;
+    uint8_t core;
+    uint32_t stackBytes;
+};
+
+static const MonitoredTask monitoredTasks[] = {
+    {"Acquisition", &AcquisitionTask, TASK_ACQUISITION_CORE, TASK_ACQUISITION_STACK},
+    {"Scale", &ScaleTask, TASK_SCALE_CORE, TASK_SCALE_STACK},
+    {"ScaleStatus", &ScaleStatusTask, TASK_STATUS_CORE, TASK_STATUS_STACK},
+    {"UI", &UiTask, TASK_UI_CORE, TASK_UI_STACK},
+    {"Display", &DisplayTask, TASK_DISPLAY_CORE, TASK_DISPLAY_STACK},
+    {"Log", &LogTask, TASK_LOG_CORE, TASK_LOG_STACK},
+    {"Web", &WebTask, TASK_WEB_CORE, TASK_WEB_STACK},
+};
+static const int MONITORED_COUNT = sizeof(monitoredTasks) / sizeof(monitoredTasks[0]);
+
+static portMUX_TYPE latencyMux = portMUX_INITIALIZER_UNLOCKED;
+static SampleLatencyStats latency = {0, 0, 0, 0, 0, 0, 0, 0};
+
+void taskMonitorSampleProcessed(int64_t sampleTimestampUs, bool grinding) {
+    int64_t age = esp_timer_get_time() - sampleTimestampUs;
+    portENTER_CRITICAL(&latencyMux);
+    latency.samples++;
+    latency.lastUs = age;
+    if (age > latency.maxUs) latency.maxUs = age;
+    if (grinding && age > latency.maxGrindingUs) latency.maxGrindingUs = age;
+    if (age > TASK_LATENCY_BUDGET_US) latency.late++;
+    portEXIT_CRITICAL(&latencyMux);
+}
+
+void taskMonitorStopDecision(int64_t sampleTimestampUs) {
+    int64_t age = esp_timer_get_time() - sampleTimestampUs;
+    portENTER_CRITICAL(&latencyMux);
+    latency.stops++;
+    latency.stopLastUs = age;
+    if (age > latency.stopMaxUs) latency.stopMaxUs = age;
+    portEXIT_CRITICAL(&latencyMux);
+}
+
+SampleLatencyStats taskMonitorGetLatency() {
+    portENTER_CRITICAL(&latencyMux);
+    SampleLatencyStats copy = latency;
+    portEXIT_CRITICAL(&latencyMux);
+    return copy;
+}
+
+#if configUSE_TRACE_FACILITY == 1 && configGENERATE_RUN_TIME_STATS == 1
+// Run-time counters at the previous report, so each report covers the time
+// since the one before; the last two slots are the idle tasks of core 0/1
+static uint32_t previousRunTime[MONITORED_COUNT + 2];
+static uint32_t previousTotal = 0;
+
+static uint32_t findRunTime(const TaskStatus_t *status, UBaseType_t count, TaskHandle_t handle) {
+    for (UBaseType_t i = 0; i < count; ++i) {
+        if (status[i].xHandle == handle) return status[i].ulRunTimeCounter;
+    }
+    return 0;
+}
+#endif
+
+void taskMonitorReport(Stream &out) {
+    out.println("\n=== Tasks ===");
+#if configUSE_TRACE_FACILITY == 1 && configGENERATE_RUN_TIME_STATS == 1
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *status = (TaskStatus_t *)malloc(capacity * sizeof(TaskStatus_t));
+    uint32_t total = 0;
+    UBaseType_t count = status ? uxTaskGetSystemState(status, capacity, &total) : 0;
+    // The total is wall time; each core has that much run time available
+    uint32_t window = total - previousTotal;
+    previousTotal = total;
+#endif
+
+    out.println("Task         Core Prio  Stack free/size  CPU");
+    for (int i = 0; i < MONITORED_COUNT; ++i) {
+        const MonitoredTask &task = monitoredTasks[i];
+        TaskHandle_t handle = *task.handle;
+        if (!handle) {
+            out.printf("%-12s   -    -  not running\n", task.name);
+            continue;
+        }
+        out.printf("%-12s %4u %4u  %6u/%-6u", task.name, task.core, (unsigned)uxTaskPriorityGet(handle),
+                   (unsigned)uxTaskGetStackHighWaterMark(handle), task.stackBytes);
+#if configUSE_TRACE_FACILITY == 1 && configGENERATE_RUN_TIME_STATS == 1
+        uint32_t runTime = findRunTime(status, count, handle);
+        out.printf("  %5.1f%%", window ? 100.0 * (runTime - previousRunTime[i]) / window : 0.0);
+        previousRunTime[i] = runTime;
+#endif
+        out.println();
+    }
+
+#if configUSE_TRACE_FACILITY == 1 && configGENERATE_RUN_TIME_STATS == 1
+    for (int core = 0; core < 2; ++core) {
+        uint32_t idle = findRunTime(status, count, xTaskGetIdleTaskHandleForCPU(core));
+        uint32_t &previous = previousRunTime[MONITORED_COUNT + core];
+        out.printf("Core %d load: %.1f%%\n", core, window ? 100.0 - 100.0 * (idle - previous) / window : 0.0);
+        previous = idle;
+    }
+    free(status);
+#else
+    out.println("CPU usage needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS");
+#endif
+
+    SampleLatencyStats l = taskMonitorGetLatency();
+    out.printf("Sample age at grind session: last %lld us, max %lld us, max while grinding %lld us\n",
+               l.lastUs, l.maxUs, l.maxGrindingUs);
+    out.printf("Late samples (> %d us): %u of %u\n", TASK_LATENCY_BUDGET_US, l.late, l.samples);
+    out.printf("Deciding sample to relay write: last %lld us, max %lld us over %u stops\n", l.stopLastUs, l.stopMaxUs,
+               l.stops);
+    out.println("=============\n");
+}
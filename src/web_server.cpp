@@ -1,80 +1,77 @@
 #include "web_server.hpp"
-#include <WiFi.h>
 #include <ESPAsyncWebServer.h>
 #include "api_handler.hpp"
 #include "config.hpp"
+#include "log.hpp"
+#include "weight_stream.hpp"
+#include "grind_events.hpp"
+#include "web_assets.hpp"
+#include "wifi_provisioning.hpp"
 
 AsyncWebServer server(80);
+TaskHandle_t WebTask = nullptr;
 
-String currentIPAddress = "192.168.4.1"; // Default AP mode IP
-
-const char *apSSID = "ESP32_Config_openGBW";  // AP SSID
-const char *apPassword = "12345678";           // AP Password (must be at least 8 characters)
-
-void updateIPAddress() {
-    if (WiFi.status() == WL_CONNECTED) {
-        currentIPAddress = WiFi.localIP().toString();
+// The UI files from web/, gzip'd in flash (tools/embed_web.py). Sent straight
+// from flash; "no-cache" makes the browser revalidate, and an unchanged file
+// then costs a 304 without a body.
+static void serveAsset(AsyncWebServerRequest *request, const WebAsset &asset) {
+    AsyncWebHeader *match = request->getHeader("If-None-Match");
+    AsyncWebServerResponse *response;
+    if (match && match->value() == asset.etag) {
+        response = request->beginResponse(304);
     } else {
-        currentIPAddress = "192.168.4.1";
+        response = request->beginResponse_P(200, asset.contentType, asset.data, asset.length);
+        response->addHeader("Content-Encoding", "gzip");
     }
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
 }
 
-void connectToWiFi() {
-    preferences.begin("wifi", true);  // Open preferences in read mode
-    String storedSSID = preferences.getString("wifi_ssid", "");
-    String storedPass = preferences.getString("wifi_pass", "");
-    preferences.end();  // Close preferences
-
-    if (storedSSID.length() > 0) {
-        Serial.print("Connecting to WiFi: ");
-        Serial.println(storedSSID);
-
-        WiFi.begin(storedSSID.c_str(), storedPass.c_str());
-        unsigned long startAttemptTime = millis();
-
-        while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < 10000) {
-            delay(500);
-            Serial.print(".");
-        }
-
-        if (WiFi.status() == WL_CONNECTED) {
-            Serial.println("\nWiFi Connected!");
-            Serial.print("IP Address: ");
-            Serial.println(WiFi.localIP());
-            updateIPAddress();
-            return;
-        }
+// Everything the scale and status tasks hand to web clients goes out from
+// here, so a slow client or a busy network never holds those tasks up
+static void webLoop(void *parameter) {
+    for (;;) {
+        provisioningService();
+        weightStreamService();
+        grindEventsService();
+        vTaskDelay(pdMS_TO_TICKS(WEB_TASK_INTERVAL_MS));
     }
-
-    Serial.println("Failed to connect. Starting AP mode...");
-    WiFi.mode(WIFI_AP);
-    WiFi.softAP(apSSID, apPassword);
-    delay(500); // Ensure the AP starts properly
-    updateIPAddress();
-    Serial.print("AP IP Address: ");
-    Serial.println(WiFi.softAPIP());
 }
 
-void handleWiFiConfig(AsyncWebServerRequest *request) {
-    if (request->hasParam("ssid") && request->hasParam("pass")) {
-        String newSSID = request->getParam("ssid")->value();
-        String newPass = request->getParam("pass")->value();
-
-        preferences.begin("wifi", false);
-        preferences.putString("wifi_ssid", newSSID);
-        preferences.putString("wifi_pass", newPass);
-        preferences.end(); // Close preferences
-
-        Serial.println("WiFi credentials SAVED. Rebooting in 5 seconds...");
-        request->send(200, "text/plain", "WiFi credentials SAVED. Rebooting...");
-        delay(5000);
-        ESP.restart();
-    } else {
-        Serial.println("Missing SSID or Password");
-        request->send(400, "text/plain", "Missing SSID or Password");
+void setupWebServer() {
+    provisioningBegin();
+    for (const WebAsset &asset : WEB_ASSETS) {
+        server.on(asset.url, HTTP_GET, [&asset](AsyncWebServerRequest *request) { serveAsset(request, asset); });
     }
+    setupApiEndpoints(server);
+    setupWeightStream(server);
+    setupGrindEvents(server);
+    server.begin();
+    xTaskCreatePinnedToCore(webLoop, "Web", TASK_WEB_STACK, NULL, TASK_WEB_PRIORITY, &WebTask, TASK_WEB_CORE);
+    LOGI(TAG_WEB, "Web server started, weight stream on %s, grind events on %s", WEB_STREAM_PATH, WEB_EVENTS_PATH);
 }
 
-// void setupWebServer() {
-//     // Web server disabled
-// }
+void webServerReport(Stream &out) {
+    if (!WEB_SERVER_ENABLED) {
+        out.println("[Web] Disabled (WEB_SERVER_ENABLED)");
+        return;
+    }
+    WeightStreamStats stream = weightStreamStats();
+    out.println("\n=== Web server ===");
+    ProvisioningStatus wifi = provisioningStatus();
+    out.printf("WiFi: %s for %u s, network \"%s\", %u connections\n", provisioningStateName(wifi.state),
+               wifi.sinceMs / 1000, wifi.ssid, wifi.connects);
+    out.printf("Address: http://%s\n", IPAddress(wifi.address).toString().c_str());
+    if (wifi.restartInMs >= 0) out.printf("Restart in %d ms\n", wifi.restartInMs);
+    out.printf("Weight stream %s: %u clients, %u messages, %u samples\n", WEB_STREAM_PATH, stream.clients,
+               stream.messages, stream.samples);
+    out.printf("  coalesced for slow clients %u, lost in the ring %u\n", stream.coalesced, stream.ringDropped);
+    out.printf("Grind events %s: %u published\n", WEB_EVENTS_PATH, grindEventsPublished());
+    ApiStats api = apiStats();
+    out.printf("API: %u responses (%u errors), largest %u bytes, %u overflowed\n", api.requests, api.errors,
+               api.largestBody, api.overflows);
+    out.printf("API heap per response: last %d bytes, largest %d bytes\n", api.lastHeapDelta, api.largestHeapDelta);
+    out.printf("Heap: %u free, %u lowest since boot\n", ESP.getFreeHeap(), ESP.getMinFreeHeap());
+    out.println("==================\n");
+}
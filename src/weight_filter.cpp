@@ -0,0 +1,196 @@
+#include "weight_filter.hpp"
+#include "config.hpp"
+#include "log.hpp"
+#include <WeightFilter.h>
+#include <CountScale.h>
+
+extern double scaleFactor;
+
+static const char *const profileNames[FILTER_PROFILE_COUNT] = {"idle", "grinding", "finished"};
+static const char *const profileDefaults[FILTER_PROFILE_COUNT] = {FILTER_IDLE, FILTER_GRINDING, FILTER_FINISHED};
+
+// One pipeline per profile, so each keeps its own metrics; only the active
+// one is fed. Guarded by filterMux against the serial command.
+static FilterPipeline pipelines[FILTER_PROFILE_COUNT];
+static FilterProfile activeProfile = FILTER_PROFILE_IDLE;
+static float lastOutput = 0;
+static portMUX_TYPE filterMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t filterClock() {
+    return (uint32_t)esp_timer_get_time();
+}
+
+static FilterProfile profileForStatus(int status) {
+    switch (status) {
+        case STATUS_GRINDING_IN_PROGRESS: return FILTER_PROFILE_GRINDING;
+        case STATUS_GRINDING_FINISHED:
+        case STATUS_GRINDING_FAILED: return FILTER_PROFILE_FINISHED;
+        default: return FILTER_PROFILE_IDLE;
+    }
+}
+
+void weightFilterSetup() {
+    for (int i = 0; i < FILTER_PROFILE_COUNT; ++i) {
+        if (!pipelines[i].configure(profileDefaults[i])) {
+            LOGW(TAG_SCALE, "Filter profile %s: invalid spec \"%s\", passing weight through", profileNames[i],
+                 profileDefaults[i]);
+        }
+        pipelines[i].setClock(filterClock);
+        pipelines[i].reset(0);
+    }
+}
+
+float weightFilterUpdate(uint32_t timestampMs, float fusedG, int status) {
+    FilterProfile profile = profileForStatus(status);
+    portENTER_CRITICAL(&filterMux);
+    if (profile != activeProfile) {
+        activeProfile = profile;
+        pipelines[profile].reset(lastOutput);
+    }
+    lastOutput = pipelines[profile].update(timestampMs, fusedG);
+    float output = lastOutput;
+    portEXIT_CRITICAL(&filterMux);
+    return output;
+}
+
+void weightFilterReset(double value) {
+    portENTER_CRITICAL(&filterMux);
+    lastOutput = (float)value;
+    pipelines[activeProfile].reset(lastOutput);
+    portEXIT_CRITICAL(&filterMux);
+}
+
+bool weightFilterSetProfile(FilterProfile profile, const char *spec) {
+    if (profile >= FILTER_PROFILE_COUNT) return false;
+    // Parse outside the critical section, swap in under it
+    FilterPipeline parsed;
+    if (!parsed.configure(spec)) return false;
+    parsed.setClock(filterClock);
+    portENTER_CRITICAL(&filterMux);
+    parsed.reset(lastOutput);
+    pipelines[profile] = parsed;
+    portEXIT_CRITICAL(&filterMux);
+    return true;
+}
+
+bool weightFilterGetProfile(FilterProfile profile, char *spec, size_t size) {
+    if (profile >= FILTER_PROFILE_COUNT) return false;
+    portENTER_CRITICAL(&filterMux);
+    FilterPipeline copy = pipelines[profile];
+    portEXIT_CRITICAL(&filterMux);
+    copy.describe(spec, size);
+    return true;
+}
+
+void weightFilterCommand(const String &args, Stream &out) {
+    String rest = args;
+    rest.trim();
+    if (rest.length() > 0) {
+        int space = rest.indexOf(' ');
+        String name = space < 0 ? rest : rest.substring(0, space);
+        String spec = space < 0 ? String("") : rest.substring(space + 1);
+        spec.trim();
+        int profile = -1;
+        for (int i = 0; i < FILTER_PROFILE_COUNT; ++i) {
+            if (name.equalsIgnoreCase(profileNames[i])) profile = i;
+        }
+        if (profile < 0 || spec.length() == 0) {
+            out.println("[Filter] Usage: F <idle|grinding|finished> <spec>, e.g. F idle median:5 kalman:0.5,0.01,0.01");
+            return;
+        }
+        if (!weightFilterSetProfile((FilterProfile)profile, spec.c_str())) {
+            out.printf("[Filter] Invalid spec \"%s\"\n", spec.c_str());
+            return;
+        }
+    }
+
+    out.println("\n=== Weight filter ===");
+    for (int i = 0; i < FILTER_PROFILE_COUNT; ++i) {
+        portENTER_CRITICAL(&filterMux);
+        FilterPipeline copy = pipelines[i];
+        bool active = activeProfile == i;
+        portEXIT_CRITICAL(&filterMux);
+        char spec[96];
+        copy.describe(spec, sizeof(spec));
+        out.printf("%-9s%s %s\n", profileNames[i], active ? "*" : " ", spec);
+        for (size_t s = 0; s < copy.stageCount(); ++s) {
+            const FilterStageMetrics &m = copy.metrics(s);
+            out.printf("  %-7s samples %u  noise %.3fg  lag %+.3fg  time %u us (max %u)\n",
+                       FilterStage::typeName(copy.stage(s).type()), m.samples, m.noiseG, m.lagG, m.lastUs, m.maxUs);
+        }
+    }
+    out.println("=====================\n");
+}
+
+// Best of a few rounds, so a task switch during one round does not count
+#define BENCH_SAMPLES 256
+#define BENCH_ROUNDS 5
+
+void weightPathBenchmark(Stream &out) {
+    static int32_t raw1[BENCH_SAMPLES];
+    static int32_t raw2[BENCH_SAMPLES];
+    long offset1 = loadcell.get_offset();
+    long offset2 = loadcell2_offset;
+    double factor1 = scaleFactor;
+    double factor2 = scaleFactor2;
+    // 0..~200 g of counts from a small LCG, generated outside the timed loops
+    uint32_t seed = 12345;
+    for (int i = 0; i < BENCH_SAMPLES; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        raw1[i] = offset1 + (int32_t)((seed >> 8) % (uint32_t)(200 * factor1));
+        raw2[i] = offset2 + (int32_t)((seed >> 8) % (uint32_t)(200 * factor2));
+    }
+
+    CountScale scale1, scale2;
+    scale1.setFactor(factor1);
+    scale2.setFactor(factor2);
+    portENTER_CRITICAL(&filterMux);
+    FilterPipeline pipeline = pipelines[activeProfile];
+    portEXIT_CRITICAL(&filterMux);
+    pipeline.setClock(nullptr);
+
+    volatile float sink = 0;
+    uint32_t doubleCycles = UINT32_MAX, fixedCycles = UINT32_MAX, filterCycles = UINT32_MAX;
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        uint32_t start = ESP.getCycleCount();
+        for (int i = 0; i < BENCH_SAMPLES; ++i) {
+            double grams = (double)(raw1[i] - offset1) / factor1;
+            double grams2 = (double)(raw2[i] - offset2) / factor2;
+            sink = (grams + grams2) / 2.0;
+        }
+        doubleCycles = min(doubleCycles, ESP.getCycleCount() - start);
+
+        start = ESP.getCycleCount();
+        for (int i = 0; i < BENCH_SAMPLES; ++i) {
+            int32_t mg = scale1.toMg(raw1[i] - offset1);
+            int32_t mg2 = scale2.toMg(raw2[i] - offset2);
+            sink = (mg + mg2) * 0.0005f;
+        }
+        fixedCycles = min(fixedCycles, ESP.getCycleCount() - start);
+
+        pipeline.reset(0);
+        start = ESP.getCycleCount();
+        for (int i = 0; i < BENCH_SAMPLES; ++i) {
+            sink = pipeline.update(i * 100, (raw1[i] - offset1) * 0.001f);
+        }
+        filterCycles = min(filterCycles, ESP.getCycleCount() - start);
+    }
+    (void)sink;
+
+    // Both conversions must agree to within rounding
+    double maxErrorMg = 0;
+    for (int i = 0; i < BENCH_SAMPLES; ++i) {
+        double reference = (double)(raw1[i] - offset1) / factor1 * 1000.0;
+        maxErrorMg = max(maxErrorMg, fabs(scale1.toMg(raw1[i] - offset1) - reference));
+    }
+
+    char spec[96];
+    pipeline.describe(spec, sizeof(spec));
+    out.println("\n=== Weight path benchmark ===");
+    out.printf("Counts to grams, 2 sensors: double %u cycles/sample, fixed-point %u cycles/sample\n",
+               doubleCycles / BENCH_SAMPLES, fixedCycles / BENCH_SAMPLES);
+    out.printf("Fixed-point error vs double: max %.2f mg\n", maxErrorMg);
+    out.printf("Filter \"%s\": %u cycles/sample\n", spec, filterCycles / BENCH_SAMPLES);
+    out.printf("Scale task uses the %s path (WEIGHT_FIXED_POINT)\n", WEIGHT_FIXED_POINT ? "fixed-point" : "double");
+    out.println("=============================\n");
+}
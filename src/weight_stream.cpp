@@ -0,0 +1,145 @@
+#include "weight_stream.hpp"
+#include "config.hpp"
+#include "log.hpp"
+#include <SampleRing.h>
+#include <atomic>
+
+struct StreamSample {
+    uint32_t timestampMs;
+    int32_t fusedMg;
+    uint8_t status;
+    uint8_t flags;
+};
+
+#define STREAM_HEADER_BYTES 4
+#define STREAM_SAMPLE_BYTES 10
+
+static AsyncWebSocket weightSocket(WEB_STREAM_PATH);
+static SampleRing<StreamSample, WEB_STREAM_RING> streamRing;
+// Set by the web task while at least one client is connected, so the
+// scale task skips the ring when nobody listens
+static std::atomic<bool> streaming(false);
+
+// Samples each client missed while its queue was full; only the web
+// task touches these. Client ids start at 1 and are never reused.
+struct ClientBacklog {
+    uint32_t id;       // 0 = free
+    uint32_t dropped;
+};
+static ClientBacklog backlogs[WEB_STREAM_MAX_CLIENTS];
+
+static WeightStreamStats stats = {};
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void put16(uint8_t *out, uint16_t value) {
+    out[0] = value;
+    out[1] = value >> 8;
+}
+
+static void put32(uint8_t *out, uint32_t value) {
+    out[0] = value;
+    out[1] = value >> 8;
+    out[2] = value >> 16;
+    out[3] = value >> 24;
+}
+
+static ClientBacklog *backlogFor(uint32_t id) {
+    for (ClientBacklog &backlog : backlogs) {
+        if (backlog.id == id) return &backlog;
+    }
+    for (ClientBacklog &backlog : backlogs) {
+        if (backlog.id == 0) {
+            backlog = {id, 0};
+            return &backlog;
+        }
+    }
+    return nullptr; // over the limit until cleanupClients() closes one
+}
+
+static void onSocketEvent(AsyncWebSocket *socket, AsyncWebSocketClient *client, AwsEventType type, void *arg,
+                          uint8_t *data, size_t len) {
+    if (type == WS_EVT_CONNECT) {
+        LOGI(TAG_WEB, "Weight stream: client %u connected from %s", client->id(),
+             client->remoteIP().toString().c_str());
+    } else if (type == WS_EVT_DISCONNECT) {
+        LOGI(TAG_WEB, "Weight stream: client %u disconnected", client->id());
+    }
+}
+
+void weightStreamService() {
+    static StreamSample batch[WEB_STREAM_MAX_BATCH];
+    static uint8_t message[STREAM_HEADER_BYTES + WEB_STREAM_MAX_BATCH * STREAM_SAMPLE_BYTES];
+    // AsyncTCP adds, removes and runs clients from its own task; hold its
+    // lock for every use of the socket so no client goes away under us
+    AsyncWebLockGuard lock(weightSocket.clientsLock());
+    weightSocket.cleanupClients(WEB_STREAM_MAX_CLIENTS);
+    size_t clients = weightSocket.count();
+    streaming.store(clients > 0, std::memory_order_relaxed);
+    portENTER_CRITICAL(&statsMux);
+    stats.clients = clients;
+    portEXIT_CRITICAL(&statsMux);
+
+    // Newest WEB_STREAM_MAX_BATCH samples, in order
+    uint32_t taken = 0;
+    StreamSample sample;
+    while (streamRing.pop(sample)) batch[taken++ % WEB_STREAM_MAX_BATCH] = sample;
+    if (clients == 0 || taken == 0) return;
+    uint32_t count = min(taken, (uint32_t)WEB_STREAM_MAX_BATCH);
+    uint32_t first = taken - count;
+    uint8_t *out = message + STREAM_HEADER_BYTES;
+    for (uint32_t i = first; i < taken; ++i, out += STREAM_SAMPLE_BYTES) {
+        const StreamSample &s = batch[i % WEB_STREAM_MAX_BATCH];
+        put32(out, s.timestampMs);
+        put32(out + 4, (uint32_t)s.fusedMg);
+        out[8] = s.status;
+        out[9] = s.flags;
+    }
+    size_t length = out - message;
+    message[0] = WEB_STREAM_VERSION;
+    message[1] = count;
+
+    for (ClientBacklog &backlog : backlogs) {
+        if (backlog.id != 0 && !weightSocket.hasClient(backlog.id)) backlog.id = 0;
+    }
+    uint32_t sent = 0, coalesced = 0;
+    for (AsyncWebSocketClient *client : weightSocket.getClients()) {
+        ClientBacklog *backlog = backlogFor(client->id());
+        if (!backlog || client->status() != WS_CONNECTED) continue;
+        backlog->dropped += first;
+        if (client->queueIsFull()) {
+            // Coalesce: this client gets the newer samples next time
+            backlog->dropped += count;
+            coalesced += count;
+            continue;
+        }
+        put16(message + 2, (uint16_t)min(backlog->dropped, (uint32_t)UINT16_MAX));
+        client->binary(message, length);
+        backlog->dropped = 0;
+        sent++;
+    }
+
+    portENTER_CRITICAL(&statsMux);
+    stats.messages += sent;
+    stats.samples += taken;
+    stats.coalesced += coalesced;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+void setupWeightStream(AsyncWebServer &server) {
+    weightSocket.onEvent(onSocketEvent);
+    server.addHandler(&weightSocket);
+}
+
+void weightStreamSample(uint32_t timestampMs, float fusedG, int status, bool stable) {
+    if (!streaming.load(std::memory_order_relaxed)) return;
+    StreamSample sample = {timestampMs, (int32_t)lroundf(fusedG * 1000.0f), (uint8_t)status, (uint8_t)(stable ? 1 : 0)};
+    streamRing.push(sample); // a full ring counts the sample as dropped
+}
+
+WeightStreamStats weightStreamStats() {
+    portENTER_CRITICAL(&statsMux);
+    WeightStreamStats copy = stats;
+    portEXIT_CRITICAL(&statsMux);
+    copy.ringDropped = streamRing.dropped();
+    return copy;
+}
@@ -0,0 +1,195 @@
+#include "wifi_provisioning.hpp"
+#include "config.hpp"
+#include "log.hpp"
+#include "scale.hpp"
+#include "settings.hpp"
+#include <Preferences.h>
+#include <WiFi.h>
+
+static const char *AP_SSID = "ESP32_Config_openGBW";
+static const char *AP_PASSWORD = "12345678"; // at least 8 characters
+
+static ProvisioningStatus status = {PROV_OFF, 0, "", 0, 0, -1, false};
+static uint32_t stateAt = 0;
+static uint32_t restartAt = 0; // 0 = none
+// Written by the HTTP handlers, taken by the web task
+static char pendingSsid[33];
+static char pendingPassword[64];
+static portMUX_TYPE provMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Separate from the global preferences, which the settings store and
+// loop() use; NVS itself may be used from several tasks
+static Preferences wifiPreferences;
+
+static void setState(ProvisioningState state, IPAddress address) {
+    portENTER_CRITICAL(&provMux);
+    status.state = state;
+    status.address = (uint32_t)address;
+    if (state == PROV_CONNECTED) status.connects++;
+    stateAt = millis();
+    portEXIT_CRITICAL(&provMux);
+}
+
+static void startAccessPoint() {
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_AP);
+    WiFi.softAP(AP_SSID, AP_PASSWORD);
+    setState(PROV_AP, WiFi.softAPIP());
+    LOGW(TAG_WEB, "WiFi: configuration AP \"%s\" on %s", AP_SSID, WiFi.softAPIP().toString().c_str());
+}
+
+void provisioningBegin() {
+    char ssid[33], password[64];
+    wifiPreferences.begin("wifi", true);
+    // The configuration page used to save under ssid / password
+    String storedSsid = wifiPreferences.getString("wifi_ssid", wifiPreferences.getString("ssid", ""));
+    String storedPassword = wifiPreferences.getString("wifi_pass", wifiPreferences.getString("password", ""));
+    wifiPreferences.end();
+    strlcpy(ssid, storedSsid.c_str(), sizeof(ssid));
+    strlcpy(password, storedPassword.c_str(), sizeof(password));
+
+    portENTER_CRITICAL(&provMux);
+    strlcpy(status.ssid, ssid, sizeof(status.ssid));
+    portEXIT_CRITICAL(&provMux);
+    if (ssid[0] == '\0') {
+        LOGI(TAG_WEB, "WiFi: no network stored");
+        startAccessPoint();
+        return;
+    }
+    LOGI(TAG_WEB, "WiFi: connecting to \"%s\"", ssid);
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(true);
+    WiFi.begin(ssid, password);
+    setState(PROV_CONNECTING, IPAddress());
+}
+
+static void saveCredentials() {
+    char ssid[33], password[64];
+    portENTER_CRITICAL(&provMux);
+    memcpy(ssid, pendingSsid, sizeof(ssid));
+    memcpy(password, pendingPassword, sizeof(password));
+    portEXIT_CRITICAL(&provMux);
+
+    wifiPreferences.begin("wifi", false);
+    bool saved = wifiPreferences.putString("wifi_ssid", ssid) > 0;
+    wifiPreferences.putString("wifi_pass", password);
+    wifiPreferences.remove("ssid");
+    wifiPreferences.remove("password");
+    wifiPreferences.end();
+    memset(password, 0, sizeof(password));
+
+    portENTER_CRITICAL(&provMux);
+    memset(pendingPassword, 0, sizeof(pendingPassword));
+    status.credentialsPending = false;
+    if (saved) strlcpy(status.ssid, ssid, sizeof(status.ssid));
+    portEXIT_CRITICAL(&provMux);
+    if (saved) {
+        LOGI(TAG_WEB, "WiFi: saved network \"%s\", restarting", ssid);
+        provisioningScheduleRestart(WIFI_RESTART_DELAY_MS);
+    } else {
+        LOGW(TAG_WEB, "WiFi: could not save the network");
+    }
+}
+
+void provisioningService() {
+    portENTER_CRITICAL(&provMux);
+    ProvisioningState state = status.state;
+    bool pending = status.credentialsPending;
+    uint32_t restart = restartAt;
+    uint32_t since = stateAt;
+    portEXIT_CRITICAL(&provMux);
+    uint32_t now = millis();
+
+    if (pending) saveCredentials();
+
+    bool connected = WiFi.status() == WL_CONNECTED;
+    switch (state) {
+        case PROV_CONNECTING:
+            if (connected) {
+                setState(PROV_CONNECTED, WiFi.localIP());
+                LOGI(TAG_WEB, "WiFi: connected, %s", WiFi.localIP().toString().c_str());
+            } else if (now - since > WIFI_CONNECT_TIMEOUT_MS) {
+                LOGW(TAG_WEB, "WiFi: no connection after %u ms", WIFI_CONNECT_TIMEOUT_MS);
+                startAccessPoint();
+            }
+            break;
+        case PROV_CONNECTED:
+            if (!connected) {
+                // The station reconnects on its own; the AP would take the
+                // scale off a network that is only briefly gone
+                setState(PROV_RECONNECTING, IPAddress());
+                LOGW(TAG_WEB, "WiFi: connection lost, reconnecting");
+            }
+            break;
+        case PROV_RECONNECTING:
+            if (connected) {
+                setState(PROV_CONNECTED, WiFi.localIP());
+                LOGI(TAG_WEB, "WiFi: reconnected, %s", WiFi.localIP().toString().c_str());
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (restart == 0 || (int32_t)(now - restart) < 0) return;
+    // Never while the relay may be on: the grinder would run on (or stop
+    // with the dose half done). Rescheduling gives the settings store its
+    // quiet time after the grind as well.
+    if (grinderBusy()) {
+        LOGI(TAG_WEB, "Restart deferred until the grinder is idle");
+        provisioningScheduleRestart(WIFI_RESTART_DELAY_MS);
+        return;
+    }
+    // Restart once the delay passed and the settings store has written what
+    // was changed (it waits for SETTINGS_QUIET_MS), or a while after that
+    if (!settingsDirty() || now - restart > 2 * SETTINGS_QUIET_MS) {
+        LOGW(TAG_WEB, "Restarting");
+        ESP.restart();
+    }
+}
+
+bool provisioningSetCredentials(const char *ssid, const char *password) {
+    size_t ssidLength = strlen(ssid), passwordLength = strlen(password);
+    if (ssidLength == 0 || ssidLength > 32) return false;
+    if (passwordLength != 0 && (passwordLength < 8 || passwordLength > 63)) return false;
+    portENTER_CRITICAL(&provMux);
+    strlcpy(pendingSsid, ssid, sizeof(pendingSsid));
+    strlcpy(pendingPassword, password, sizeof(pendingPassword));
+    status.credentialsPending = true;
+    portEXIT_CRITICAL(&provMux);
+    return true;
+}
+
+void provisioningScheduleRestart(uint32_t delayMs) {
+    portENTER_CRITICAL(&provMux);
+    restartAt = max(millis() + delayMs, 1UL);
+    portEXIT_CRITICAL(&provMux);
+}
+
+ProvisioningStatus provisioningStatus() {
+    portENTER_CRITICAL(&provMux);
+    ProvisioningStatus copy = status;
+    uint32_t now = millis();
+    copy.sinceMs = now - stateAt;
+    copy.restartInMs = restartAt == 0 ? -1 : max((int32_t)(restartAt - now), (int32_t)0);
+    portEXIT_CRITICAL(&provMux);
+    return copy;
+}
+
+const char *provisioningStateName(ProvisioningState state) {
+    switch (state) {
+        case PROV_OFF: return "off";
+        case PROV_CONNECTING: return "connecting";
+        case PROV_CONNECTED: return "connected";
+        case PROV_RECONNECTING: return "reconnecting";
+        case PROV_AP: return "ap";
+    }
+    return "unknown";
+}
+
+IPAddress provisioningAddress() {
+    portENTER_CRITICAL(&provMux);
+    uint32_t address = status.address;
+    portEXIT_CRITICAL(&provMux);
+    return IPAddress(address);
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// Host stand-in for the parts of Arduino.h the libraries use (env:native).
+// Tests that need millis() define it, usually on a clock they control.
+unsigned long millis();
@@ -0,0 +1,338 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <DualHx711.h>
+#include <SampleRing.h>
+
+// The acquisition pipeline on the host: a model of two HX711s on a shared
+// SCK line, read with hx711ShiftOutDual() by a producer that follows
+// acquisition.cpp (edge, wait for sensor2 within one period, one clock
+// train, push), SampleRing in between and a consumer draining it at the
+// scale task's pace. IntervalStats measures rate and jitter the way the
+// serial 's' command reports them on the device.
+
+// One HX711: converts every periodUs on its own oscillator, pulls DOUT low
+// when a conversion is ready and shifts it out MSB first on rising SCK
+// edges; pulse 25-27 end the train and select the next gain. A conversion
+// that completes while the module is being clocked is latched after the
+// train, so the word in flight stays intact.
+class FakeHx711 {
+public:
+  FakeHx711(int64_t periodUs, int64_t firstUs, int32_t seed) :
+      periodUs(periodUs), nextUs(firstUs), seed(seed) {}
+
+  void advance(int64_t nowUs) {
+    while (nowUs >= nextUs) {
+      if (pulses > 0 && nowUs - lastRiseUs < 5) {
+        if (!latchPending) latchedAfterTrain++;
+        latchPending = true;
+        return;
+      }
+      latchPending = false;
+      if (pulses >= 25) gainPulses = pulses - 24;
+      if (ready && pulses == 0) overwritten++;
+      data = value(conversions++);
+      ready = true;
+      pulses = 0;
+      nextUs += periodUs;
+    }
+  }
+
+  void sck(bool high, int64_t nowUs) {
+    if (high && !sckHigh) {
+      highSinceUs = nowUs;
+      lastRiseUs = nowUs;
+      if (pulses > 0) {
+        pulses++;
+      } else if (ready) {
+        pulses = 1;
+      } else {
+        busyPulses++; // clocked while converting
+      }
+      if (pulses >= 1 && pulses <= 24) bit = (data >> (24 - pulses)) & 1;
+      if (pulses == 24) delivered[deliveredCount++ % HISTORY] = data;
+      if (pulses == 25) ready = false;
+    }
+    if (!high && sckHigh && nowUs - highSinceUs > 60) poweredDown = true;
+    sckHigh = high;
+  }
+
+  // Low while a conversion waits, then the bit of the last rising edge
+  bool dout() const {
+    if (pulses == 0) return !ready;
+    if (pulses <= 24) return bit;
+    return true;
+  }
+
+  bool isReady() const { return ready && pulses == 0; }
+  int64_t nextConversionUs() const { return nextUs; }
+  int32_t value(uint32_t n) const { return (int32_t)((n * 104729u + (uint32_t)seed) % 16777216u) - 8388608; }
+  // Sign-extended word shifted out as the index-th reading
+  int32_t deliveredAt(uint32_t index) const {
+    uint32_t word = delivered[index % HISTORY];
+    return hx711SignExtend(word & 0xFFFFFF);
+  }
+
+  static constexpr uint32_t HISTORY = 256;
+  int64_t periodUs;
+  int64_t nextUs;
+  int32_t seed;
+  uint32_t conversions = 0;
+  int32_t data = 0;
+  bool ready = false;
+  int pulses = 0;
+  int bit = 0;
+  bool sckHigh = false;
+  int64_t highSinceUs = 0;
+  int64_t lastRiseUs = 0;
+  bool latchPending = false;
+  int gainPulses = 1;
+  uint32_t delivered[HISTORY] = {};
+  uint32_t deliveredCount = 0;
+  uint32_t busyPulses = 0;
+  uint32_t latchedAfterTrain = 0;
+  uint32_t overwritten = 0;
+  bool poweredDown = false;
+};
+
+static const uint32_t MASK1 = 1u << 16;
+static const uint32_t MASK2 = 1u << 17;
+
+// Shared SCK; every phase of the clock train takes 1 us like delayMicroseconds(1)
+struct FakeBus {
+  int64_t &nowUs;
+  FakeHx711 &cell1;
+  FakeHx711 &cell2;
+
+  void sck(bool high) {
+    cell1.advance(nowUs);
+    cell2.advance(nowUs);
+    cell1.sck(high, nowUs);
+    cell2.sck(high, nowUs);
+  }
+  void pause() { nowUs += 1; }
+  uint32_t inputs() { return (cell1.dout() ? MASK1 : 0) | (cell2.dout() ? MASK2 : 0); }
+};
+
+struct Sample {
+  int64_t timestampUs;
+  int32_t raw1;
+  int32_t raw2;
+};
+
+struct PipelineResult {
+  IntervalStats intervals;
+  uint32_t consumed = 0;
+  uint32_t dropped = 0;
+  uint32_t pairTimeouts = 0;
+  uint32_t mismatches = 0;
+  double seconds = 0;
+};
+
+struct PipelineConfig {
+  int64_t period1Us;
+  int64_t period2Us;
+  int64_t offset2Us;        // sensor2's first conversion after sensor1's
+  int64_t durationUs;
+  int64_t consumerUs;       // the scale task drains the ring this often
+  int64_t stallFromUs = -1; // consumer stops for stallUs from here
+  int64_t stallUs = 0;
+};
+
+static const int64_t TICK_US = 1000; // vTaskDelay(1)
+
+static PipelineResult runPipeline(const PipelineConfig &config, FakeHx711 &cell1, FakeHx711 &cell2) {
+  PipelineResult result;
+  SampleRing<Sample, 64> ring;
+  int64_t now = 0;
+  FakeBus bus = {now, cell1, cell2};
+  int64_t nextConsumerUs = config.consumerUs;
+  uint32_t expected = 0; // index of the next reading the consumer should see
+  srand(1);
+
+  auto drain = [&](int64_t atUs) {
+    if (config.stallFromUs >= 0 && atUs >= config.stallFromUs && atUs < config.stallFromUs + config.stallUs) return;
+    Sample sample;
+    while (ring.pop(sample)) {
+      // Skip readings the ring dropped: they were never pushed
+      while (expected < cell1.deliveredCount && cell1.deliveredAt(expected) != sample.raw1) expected++;
+      if (expected >= cell1.deliveredCount || cell2.deliveredAt(expected) != sample.raw2) result.mismatches++;
+      expected++;
+      result.consumed++;
+    }
+  };
+
+  while (now < config.durationUs) {
+    cell1.advance(now);
+    cell2.advance(now);
+    int64_t edgeUs = cell1.isReady() ? now : cell1.nextConversionUs();
+    while (nextConsumerUs <= edgeUs) {
+      drain(nextConsumerUs);
+      nextConsumerUs += config.consumerUs;
+    }
+    // ISR timestamp a little after the edge, the task runs after that
+    now = edgeUs + 5 + rand() % 30;
+    int64_t stampUs = now;
+    now += 20 + rand() % 80;
+    cell1.advance(now);
+    cell2.advance(now);
+
+    if (!cell2.isReady()) {
+      int64_t waitStart = now;
+      bool timedOut = false;
+      while (!cell2.isReady()) {
+        if (now - waitStart > config.period1Us) {
+          timedOut = true;
+          break;
+        }
+        now += TICK_US;
+        cell2.advance(now);
+      }
+      if (timedOut) {
+        result.pairTimeouts++;
+        continue;
+      }
+      stampUs = now;
+    }
+
+    uint32_t word1, word2;
+    hx711ShiftOutDual(bus, MASK1, MASK2, 1, word1, word2);
+    Sample sample = {stampUs, hx711SignExtend(word1), hx711SignExtend(word2)};
+    result.intervals.record(stampUs);
+    ring.push(sample);
+  }
+  drain(now);
+  result.dropped = ring.dropped();
+  result.seconds = config.durationUs / 1e6;
+  return result;
+}
+
+static void report(const char *name, const PipelineResult &result) {
+  char line[160];
+  snprintf(line, sizeof(line), "%s: %.2f SPS, interval mean %.1f us, jitter %.1f us, min %lld max %lld",
+           name, result.intervals.samples() / result.seconds, result.intervals.meanUs(),
+           result.intervals.jitterUs(), (long long)result.intervals.minUs(), (long long)result.intervals.maxUs());
+  TEST_MESSAGE(line);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_shift_out_decodes_both_words() {
+  const int32_t values[] = {0, 1, -1, 12345, -12345, 8388607, -8388608};
+  for (int32_t value : values) {
+    int64_t now = 0;
+    FakeHx711 cell1(100000, 0, 0), cell2(100000, 0, 0);
+    cell1.advance(0);
+    cell2.advance(0);
+    cell1.data = value & 0xFFFFFF;
+    cell2.data = (-value) & 0xFFFFFF;
+    FakeBus bus = {now, cell1, cell2};
+    uint32_t word1, word2;
+    hx711ShiftOutDual(bus, MASK1, MASK2, 1, word1, word2);
+    TEST_ASSERT_EQUAL_INT32(value, hx711SignExtend(word1));
+    TEST_ASSERT_EQUAL_INT32(value == -8388608 ? value : -value, hx711SignExtend(word2));
+    TEST_ASSERT_FALSE(cell1.isReady());
+    TEST_ASSERT_FALSE(cell1.poweredDown);
+  }
+}
+
+static void test_gain_pulses() {
+  for (int pulses = 1; pulses <= 3; pulses++) {
+    int64_t now = 0;
+    FakeHx711 cell1(100000, 0, 0), cell2(100000, 0, 0);
+    FakeBus bus = {now, cell1, cell2};
+    bus.sck(false);
+    uint32_t word1, word2;
+    hx711ShiftOutDual(bus, MASK1, MASK2, pulses, word1, word2);
+    now = 100000;
+    bus.sck(false);
+    TEST_ASSERT_EQUAL(pulses, cell1.gainPulses);
+    TEST_ASSERT_EQUAL(pulses, cell2.gainPulses);
+    TEST_ASSERT_EQUAL_UINT32(0, cell1.busyPulses);
+  }
+}
+
+static void test_interval_stats() {
+  IntervalStats stats;
+  const int64_t stamps[] = {1000, 2000, 3100, 3900, 5000};
+  for (int64_t stamp : stamps) stats.record(stamp);
+  TEST_ASSERT_EQUAL_UINT32(5, stats.samples());
+  TEST_ASSERT_EQUAL_UINT32(4, stats.intervals());
+  TEST_ASSERT_EQUAL_INT32(800, stats.minUs());
+  TEST_ASSERT_EQUAL_INT32(1100, stats.maxUs());
+  TEST_ASSERT_EQUAL_INT32(1100, stats.lastUs());
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 1000, stats.meanUs());
+  TEST_ASSERT_FLOAT_WITHIN(0.1, 141.4, stats.jitterUs()); // sample stddev of 1000, 1100, 800, 1100
+  // A rate switch does not count as one long interval
+  stats.restart();
+  stats.record(900000);
+  TEST_ASSERT_EQUAL_INT32(1100, stats.maxUs());
+  TEST_ASSERT_EQUAL_UINT32(6, stats.samples());
+}
+
+// 80 SPS with oscillators 0.3 % apart: sensor2's lag sweeps through the
+// whole period over the run
+static void test_pipeline_80_sps() {
+  PipelineConfig config = {12500, 12463, 4000, 20000000, 20000};
+  FakeHx711 cell1(config.period1Us, 1000, 11), cell2(config.period2Us, 1000 + config.offset2Us, 23);
+  PipelineResult result = runPipeline(config, cell1, cell2);
+  report("80 SPS", result);
+  double sps = result.intervals.samples() / result.seconds;
+  TEST_ASSERT_FLOAT_WITHIN(0.5, 80, sps);
+  TEST_ASSERT_FLOAT_WITHIN(100, 12500, result.intervals.meanUs());
+  // Waiting for sensor2 in 1 ms ticks is the main source of jitter
+  TEST_ASSERT_LESS_THAN(250, result.intervals.jitterUs());
+  TEST_ASSERT_EQUAL_UINT32(0, result.dropped);
+  TEST_ASSERT_EQUAL_UINT32(0, result.pairTimeouts);
+  TEST_ASSERT_EQUAL_UINT32(0, result.mismatches);
+  TEST_ASSERT_EQUAL_UINT32(result.intervals.samples(), result.consumed);
+  TEST_ASSERT_EQUAL_UINT32(0, cell1.busyPulses + cell2.busyPulses);
+  TEST_ASSERT_FALSE(cell1.poweredDown || cell2.poweredDown);
+}
+
+static void test_pipeline_10_sps() {
+  PipelineConfig config = {100000, 100300, 30000, 30000000, 50000};
+  FakeHx711 cell1(config.period1Us, 1000, 5), cell2(config.period2Us, 1000 + config.offset2Us, 7);
+  PipelineResult result = runPipeline(config, cell1, cell2);
+  report("10 SPS", result);
+  TEST_ASSERT_FLOAT_WITHIN(0.1, 10, result.intervals.samples() / result.seconds);
+  TEST_ASSERT_EQUAL_UINT32(0, result.dropped);
+  TEST_ASSERT_EQUAL_UINT32(0, result.mismatches);
+  TEST_ASSERT_EQUAL_UINT32(0, cell1.busyPulses + cell2.busyPulses);
+}
+
+// A consumer that stalls for 2 s at 80 SPS overflows the 63-slot ring: the
+// newest samples are dropped and counted, the ones kept stay in order
+static void test_stalled_consumer_drops() {
+  PipelineConfig config = {12500, 12500, 2000, 5000000, 20000, 1000000, 2000000};
+  FakeHx711 cell1(config.period1Us, 1000, 3), cell2(config.period2Us, 1000 + config.offset2Us, 9);
+  PipelineResult result = runPipeline(config, cell1, cell2);
+  TEST_ASSERT_INT_WITHIN(3, 160 - 63, result.dropped);
+  TEST_ASSERT_EQUAL_UINT32(result.intervals.samples(), result.consumed + result.dropped);
+  TEST_ASSERT_EQUAL_UINT32(0, result.mismatches);
+}
+
+// Sensor2 never converts: every pair times out and SCK is never clocked
+// through a module that is not ready
+static void test_sensor2_missing() {
+  PipelineConfig config = {12500, 12500, 0, 1000000, 20000};
+  FakeHx711 cell1(config.period1Us, 1000, 3), cell2(config.period2Us, INT64_MAX / 2, 9);
+  PipelineResult result = runPipeline(config, cell1, cell2);
+  TEST_ASSERT_EQUAL_UINT32(0, result.intervals.samples());
+  TEST_ASSERT_GREATER_THAN(0, result.pairTimeouts);
+  TEST_ASSERT_EQUAL_UINT32(0, cell1.busyPulses + cell2.busyPulses);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_shift_out_decodes_both_words);
+  RUN_TEST(test_gain_pulses);
+  RUN_TEST(test_interval_stats);
+  RUN_TEST(test_pipeline_80_sps);
+  RUN_TEST(test_pipeline_10_sps);
+  RUN_TEST(test_stalled_consumer_drops);
+  RUN_TEST(test_sensor2_missing);
+  return UNITY_END();
+}
@@ -0,0 +1,99 @@
+#include <unity.h>
+#include <math.h>
+#include <CountScale.h>
+
+// CountScale against the double divide it replaces: rounding, signs, the
+// 24-bit extremes and factors small enough to leave the fixed-point path.
+
+static int64_t referenceMg(int32_t counts, double factor) {
+  return (int64_t)floor((double)counts * 1000.0 / factor + 0.5);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_rounding() {
+  CountScale scale;
+  scale.setFactor(3000);
+  TEST_ASSERT_EQUAL_INT32(0, scale.toMg(0));
+  TEST_ASSERT_EQUAL_INT32(0, scale.toMg(1));    // 0.333 mg
+  TEST_ASSERT_EQUAL_INT32(1, scale.toMg(2));    // 0.667 mg
+  TEST_ASSERT_EQUAL_INT32(1000, scale.toMg(3000));
+  scale.setFactor(2000);
+  TEST_ASSERT_EQUAL_INT32(1, scale.toMg(1));    // 0.5 mg rounds up
+  TEST_ASSERT_EQUAL_INT32(2, scale.toMg(3));    // 1.5 mg
+}
+
+static void test_negative_counts() {
+  CountScale scale;
+  scale.setFactor(3000);
+  TEST_ASSERT_EQUAL_INT32(0, scale.toMg(-1));   // -0.333 mg
+  TEST_ASSERT_EQUAL_INT32(-1, scale.toMg(-2));  // -0.667 mg
+  TEST_ASSERT_EQUAL_INT32(-1000, scale.toMg(-3000));
+  scale.setFactor(2000);
+  TEST_ASSERT_EQUAL_INT32(0, scale.toMg(-1));   // -0.5 mg rounds up as well
+  TEST_ASSERT_EQUAL_INT32(-1, scale.toMg(-3));  // -1.5 mg
+}
+
+// Full-scale readings, and the difference of two of them (raw - offset),
+// over the factors real load cells have
+static void test_24_bit_extremes() {
+  const double factors[] = {200.0, 432.7, 1000.0, 2150.25, 7000.0};
+  const int32_t counts[] = {8388607, -8388608, 16777215, -16777215, 12345, -54321};
+  CountScale scale;
+  for (double factor : factors) {
+    scale.setFactor(factor);
+    for (int32_t count : counts) {
+      TEST_ASSERT_INT32_WITHIN(1, referenceMg(count, factor), scale.toMg(count));
+    }
+  }
+}
+
+// Below ~8 counts/g the double path takes over; results that do not fit
+// int32 saturate instead of wrapping
+static void test_small_factors() {
+  CountScale scale;
+  scale.setFactor(10.0);
+  TEST_ASSERT_EQUAL_INT32(838860700, scale.toMg(8388607));
+  TEST_ASSERT_EQUAL_INT32(-838860800, scale.toMg(-8388608));
+
+  scale.setFactor(2.0);
+  TEST_ASSERT_EQUAL_INT32(50000, scale.toMg(100));
+  TEST_ASSERT_EQUAL_INT32(-50000, scale.toMg(-100));
+  TEST_ASSERT_EQUAL_INT32(INT32_MAX, scale.toMg(8388607));
+  TEST_ASSERT_EQUAL_INT32(INT32_MIN, scale.toMg(-8388608));
+
+  scale.setFactor(0.001);
+  TEST_ASSERT_EQUAL_INT32(1000000, scale.toMg(1));
+  TEST_ASSERT_EQUAL_INT32(INT32_MAX, scale.toMg(INT32_MAX));
+  TEST_ASSERT_EQUAL_INT32(INT32_MIN, scale.toMg(INT32_MIN));
+
+  // Just above the switch the fixed-point product still fits 64 bits
+  scale.setFactor(8.0);
+  TEST_ASSERT_EQUAL_INT32(INT32_MAX, scale.toMg(INT32_MAX));
+  TEST_ASSERT_EQUAL_INT32(INT32_MIN, scale.toMg(INT32_MIN));
+  TEST_ASSERT_INT32_WITHIN(1, 125000, scale.toMg(1000));
+}
+
+static void test_factor_changes() {
+  CountScale scale;
+  TEST_ASSERT_EQUAL_INT32(0, scale.toMg(1000)); // no factor yet
+  TEST_ASSERT_TRUE(scale.setFactor(1000));
+  TEST_ASSERT_FALSE(scale.setFactor(1000));
+  TEST_ASSERT_TRUE(scale.setFactor(-5));
+  TEST_ASSERT_EQUAL_INT32(0, scale.toMg(1000));
+  TEST_ASSERT_TRUE(scale.setFactor(2.0));
+  TEST_ASSERT_TRUE(scale.setFactor(500));
+  TEST_ASSERT_EQUAL_INT32(2000, scale.toMg(1000)); // back on the fixed-point path
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rounding);
+  RUN_TEST(test_negative_counts);
+  RUN_TEST(test_24_bit_extremes);
+  RUN_TEST(test_small_factors);
+  RUN_TEST(test_factor_changes);
+  return UNITY_END();
+}
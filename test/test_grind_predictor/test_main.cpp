@@ -0,0 +1,110 @@
+#include <unity.h>
+#include <GrindPredictor.h>
+
+void setUp() {}
+
+void tearDown() {}
+
+// Constant flow at 10 SPS from startG
+static void feed(GrindPredictor &predictor, float startG, float flowGps, int samples, int64_t startMs = 0) {
+  for (int i = 0; i < samples; i++) {
+    predictor.addSample(startMs + i * 100, startG + flowGps * i * 0.1f);
+  }
+}
+
+static void test_no_flow_before_three_samples() {
+  GrindPredictor predictor;
+  predictor.begin();
+  feed(predictor, 70, 2, 2);
+  TEST_ASSERT_FLOAT_WITHIN(0, 0, predictor.flowRate());
+  TEST_ASSERT_FALSE(predictor.shouldStop(0));
+}
+
+static void test_flow_rate() {
+  GrindPredictor predictor;
+  predictor.begin();
+  feed(predictor, 70, 2.5f, 20);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.5f, predictor.flowRate());
+}
+
+// Only the last FLOW_WINDOW_MS count, so the estimate follows a change
+static void test_flow_follows_change() {
+  GrindPredictor predictor;
+  predictor.begin();
+  feed(predictor, 70, 1, 20);
+  feed(predictor, 71.9f, 3, 10, 2000);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 3, predictor.flowRate());
+}
+
+// Grinding never removes mass
+static void test_negative_flow_is_zero() {
+  GrindPredictor predictor;
+  predictor.begin();
+  feed(predictor, 80, -1, 10);
+  TEST_ASSERT_FLOAT_WITHIN(0, 0, predictor.flowRate());
+}
+
+static void test_should_stop() {
+  GrindPredictor predictor;
+  predictor.setModel(0.5f, 0.4f);
+  predictor.begin();
+  feed(predictor, 80, 2, 10);
+  // 81.8 g now, 1 g on its way in latency, 0.4 g in the chute
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 83.2f, predictor.predictedFinal());
+  TEST_ASSERT_TRUE(predictor.shouldStop(83.1f));
+  TEST_ASSERT_FALSE(predictor.shouldStop(83.3f));
+}
+
+static void test_model_is_clamped() {
+  GrindPredictor predictor;
+  predictor.setModel(5, 10);
+  TEST_ASSERT_FLOAT_WITHIN(0, 2, predictor.latency());
+  TEST_ASSERT_FLOAT_WITHIN(0, 5, predictor.inFlight());
+  predictor.setModel(-1, -10);
+  TEST_ASSERT_FLOAT_WITHIN(0, 0, predictor.latency());
+  TEST_ASSERT_FLOAT_WITHIN(0, -2, predictor.inFlight());
+}
+
+static void test_learn_needs_a_stop() {
+  GrindPredictor predictor;
+  predictor.begin();
+  feed(predictor, 70, 2, 10);
+  TEST_ASSERT_FALSE(predictor.learn(72));
+  // Too slow to tell latency from the chute
+  predictor.begin();
+  feed(predictor, 70, 0.1f, 10);
+  predictor.markStopped();
+  TEST_ASSERT_FALSE(predictor.learn(72));
+  TEST_ASSERT_FALSE(predictor.stopped());
+}
+
+// Grinds at different flows with a grinder that overshoots by
+// flow * 0.6 s + 0.8 g: the model converges to it
+static void test_learn_converges() {
+  GrindPredictor predictor;
+  const float flows[] = {1.5f, 2.5f, 2.0f, 3.0f, 1.8f};
+  for (int grind = 0; grind < 30; grind++) {
+    float flow = flows[grind % 5];
+    predictor.begin();
+    feed(predictor, 70, flow, 60);
+    predictor.markStopped();
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, flow, predictor.flowAtStop());
+    float settled = predictor.weightAtStop() + flow * 0.6f + 0.8f;
+    TEST_ASSERT_TRUE(predictor.learn(settled));
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.6f, predictor.latency());
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 0.8f, predictor.inFlight());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_flow_before_three_samples);
+  RUN_TEST(test_flow_rate);
+  RUN_TEST(test_flow_follows_change);
+  RUN_TEST(test_negative_flow_is_zero);
+  RUN_TEST(test_should_stop);
+  RUN_TEST(test_model_is_clamped);
+  RUN_TEST(test_learn_needs_a_stop);
+  RUN_TEST(test_learn_converges);
+  return UNITY_END();
+}
@@ -0,0 +1,173 @@
+#include <unity.h>
+#include <GrindSession.h>
+
+class TestClock : public GrindClock {
+public:
+  uint32_t nowMs() override { return now; }
+  uint32_t now = 1000;
+};
+
+class TestRelay : public GrindRelay {
+public:
+  void set(bool on) override { isOn = on; }
+  bool isOn = false;
+};
+
+static const float CUP_G = 70.0f;
+static const float TARGET_G = 88.0f; // 18 g dose on the cup
+
+static TestClock testClock;
+static TestRelay testRelay;
+static GrindPredictor predictor;
+
+void setUp() {
+  testClock.now = 1000;
+  testRelay.isOn = false;
+  predictor = GrindPredictor();
+}
+
+void tearDown() {}
+
+// One sample at 10 SPS: advance the clock, feed it, let the session decide
+static bool step(GrindSession &session, float grams) {
+  testClock.now += 100;
+  session.addSample(testClock.now, grams, grams);
+  return session.update(grams, true);
+}
+
+// Cup detection starts the grind as the cup lands, before the scale task
+// has fed a sample into the session; the empty stop window must not read
+// as 0 g and fail the grind as "cup removed"
+static void test_empty_window_on_start() {
+  GrindSession session(testClock, testRelay, predictor);
+  session.start(TARGET_G, CUP_G, false, true);
+  TEST_ASSERT_FALSE(session.update(CUP_G, true));
+  TEST_ASSERT_EQUAL(GrindSession::RUNNING, session.state());
+  TEST_ASSERT_TRUE(testRelay.isOn);
+}
+
+// Same across a gap in the samples (e.g. a sample rate switch)
+static void test_stale_window() {
+  GrindSession session(testClock, testRelay, predictor);
+  session.start(TARGET_G, CUP_G, false, false);
+  session.addSample(testClock.now, CUP_G, CUP_G);
+  testClock.now += 300;
+  TEST_ASSERT_FALSE(session.update(CUP_G, true));
+  TEST_ASSERT_EQUAL(GrindSession::RUNNING, session.state());
+}
+
+static void test_threshold_stop() {
+  GrindSession session(testClock, testRelay, predictor);
+  session.start(TARGET_G, CUP_G, false, false);
+  float grams = CUP_G;
+  while (session.state() == GrindSession::RUNNING && grams < TARGET_G + 5) {
+    grams += 0.2f;
+    step(session, grams);
+  }
+  TEST_ASSERT_EQUAL(GrindSession::STOPPED, session.state());
+  TEST_ASSERT_FALSE(session.stoppedByPrediction());
+  TEST_ASSERT_FALSE(testRelay.isOn);
+  TEST_ASSERT_FLOAT_WITHIN(0.2f, TARGET_G, grams);
+}
+
+static void test_predictive_stop_is_early() {
+  GrindSession session(testClock, testRelay, predictor);
+  session.start(TARGET_G, CUP_G, false, true);
+  float grams = CUP_G;
+  while (session.state() == GrindSession::RUNNING && grams < TARGET_G + 5) {
+    grams += 0.2f;
+    step(session, grams);
+  }
+  TEST_ASSERT_EQUAL(GrindSession::STOPPED, session.state());
+  TEST_ASSERT_TRUE(session.stoppedByPrediction());
+  TEST_ASSERT_TRUE(grams < TARGET_G);
+}
+
+static void test_cup_removed() {
+  GrindSession session(testClock, testRelay, predictor);
+  session.start(TARGET_G, CUP_G, false, false);
+  step(session, CUP_G + 1);
+  step(session, CUP_G + 2);
+  TEST_ASSERT_TRUE(step(session, CUP_G - 10));
+  TEST_ASSERT_EQUAL(GrindSession::FAILED, session.state());
+  TEST_ASSERT_EQUAL(GrindSession::FAIL_CUP_REMOVED, session.failure());
+  TEST_ASSERT_FALSE(testRelay.isOn);
+}
+
+static void test_cup_lifted() {
+  GrindSession session(testClock, testRelay, predictor);
+  session.start(TARGET_G, CUP_G, false, false);
+  step(session, CUP_G);
+  TEST_ASSERT_TRUE(step(session, -20));
+  TEST_ASSERT_EQUAL(GrindSession::FAIL_CUP_LIFTED, session.failure());
+}
+
+static void test_not_ready() {
+  GrindSession session(testClock, testRelay, predictor);
+  session.start(TARGET_G, CUP_G, false, false);
+  TEST_ASSERT_TRUE(session.update(CUP_G, false));
+  TEST_ASSERT_EQUAL(GrindSession::FAIL_NOT_READY, session.failure());
+}
+
+static void test_no_flow() {
+  GrindSession session(testClock, testRelay, predictor);
+  session.start(TARGET_G, CUP_G, false, false);
+  uint32_t startMs = testClock.now;
+  while (session.state() == GrindSession::RUNNING && testClock.now - startMs < 10000) {
+    step(session, CUP_G + 0.1f);
+  }
+  TEST_ASSERT_EQUAL(GrindSession::FAIL_NO_FLOW, session.failure());
+  TEST_ASSERT_UINT32_WITHIN(200, session.getLimits().noFlowMs, session.stoppedAt() - startMs);
+}
+
+static void test_timeout() {
+  GrindSession session(testClock, testRelay, predictor);
+  GrindLimits limits;
+  limits.noFlowMs = 60000;
+  session.setLimits(limits);
+  session.start(TARGET_G, CUP_G, false, false);
+  uint32_t startMs = testClock.now;
+  while (session.state() == GrindSession::RUNNING && testClock.now - startMs < 30000) {
+    step(session, CUP_G);
+  }
+  TEST_ASSERT_EQUAL(GrindSession::FAIL_TIMEOUT, session.failure());
+  TEST_ASSERT_UINT32_WITHIN(100, limits.maxGrindMs, session.stoppedAt() - startMs);
+}
+
+// Scale mode only times the grind, from the first grounds on
+static void test_scale_mode_timing() {
+  GrindSession session(testClock, testRelay, predictor);
+  session.start(TARGET_G, CUP_G, true, true);
+  TEST_ASSERT_TRUE(testRelay.isOn);
+  for (int i = 0; i < 100; i++) step(session, CUP_G);
+  TEST_ASSERT_EQUAL(GrindSession::RUNNING, session.state());
+  TEST_ASSERT_EQUAL_UINT32(0, session.startedAt());
+  step(session, CUP_G + 0.5f);
+  TEST_ASSERT_EQUAL_UINT32(testClock.now, session.startedAt());
+  TEST_ASSERT_FALSE(session.stoppedByPrediction());
+}
+
+static void test_abort() {
+  GrindSession session(testClock, testRelay, predictor);
+  session.start(TARGET_G, CUP_G, false, false);
+  session.abort();
+  TEST_ASSERT_EQUAL(GrindSession::IDLE, session.state());
+  TEST_ASSERT_FALSE(testRelay.isOn);
+  TEST_ASSERT_FALSE(step(session, TARGET_G));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_window_on_start);
+  RUN_TEST(test_stale_window);
+  RUN_TEST(test_threshold_stop);
+  RUN_TEST(test_predictive_stop_is_early);
+  RUN_TEST(test_cup_removed);
+  RUN_TEST(test_cup_lifted);
+  RUN_TEST(test_not_ready);
+  RUN_TEST(test_no_flow);
+  RUN_TEST(test_timeout);
+  RUN_TEST(test_scale_mode_timing);
+  RUN_TEST(test_abort);
+  return UNITY_END();
+}
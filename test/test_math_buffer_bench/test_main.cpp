@@ -0,0 +1,101 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <MathBuffer.h>
+#include <MultiChannelBuffer.h>
+
+// Registered windows of MultiChannelBuffer against the linear MathBuffer
+// walks they replaced, on the status loop's queries: a 100-sample history,
+// one sample per 25 ms, average/min/max over the window lengths scale.cpp
+// registers, once per pushed sample.
+
+static unsigned long nowMs = 0;
+unsigned long millis() { return nowMs; }
+
+static const size_t HISTORY = 100;
+static const int64_t WINDOWS[] = {10000, 2000, 500, 200};
+static const size_t WINDOW_COUNT = sizeof(WINDOWS) / sizeof(WINDOWS[0]);
+static const int ROUNDS = 20000;
+static const unsigned long SAMPLE_MS = 25;
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile float sink;
+
+void setUp() {
+  nowMs = 1000;
+  srand(3);
+}
+
+void tearDown() {}
+
+static float noisySample(int i) {
+  return 18.0f + 0.01f * i + (rand() % 200 - 100) * 0.001f;
+}
+
+static double nsPerQuery(Clock::duration elapsed) {
+  return std::chrono::duration<double, std::nano>(elapsed).count() / (ROUNDS * WINDOW_COUNT * 3);
+}
+
+// Both give the same answers over a stream that wraps the ring many times
+static void test_windows_match_linear_queries() {
+  MathBuffer<float, HISTORY> linear;
+  MultiChannelBuffer<float, HISTORY, 1, WINDOW_COUNT> windowed;
+  for (int64_t length : WINDOWS) windowed.addWindow(0, length);
+
+  for (int i = 0; i < 2000; i++) {
+    nowMs += SAMPLE_MS + (i % 7 == 0 ? 40 : 0); // jitter and gaps
+    float row[1] = {noisySample(i)};
+    linear.push(row[0]);
+    windowed.push(row, nowMs);
+    for (int64_t length : WINDOWS) {
+      int64_t cutoff = (int64_t)nowMs - length;
+      TEST_ASSERT_EQUAL_size_t(linear.countSamplesSince(cutoff), windowed.countOver(0, length));
+      TEST_ASSERT_FLOAT_WITHIN(1e-3f, linear.averageSince(cutoff), windowed.averageOver(0, length));
+      TEST_ASSERT_FLOAT_WITHIN(0, linear.minSince(cutoff), windowed.minOver(0, length));
+      TEST_ASSERT_FLOAT_WITHIN(0, linear.maxSince(cutoff), windowed.maxOver(0, length));
+    }
+  }
+}
+
+static void test_benchmark() {
+  MathBuffer<float, HISTORY> linear;
+  MultiChannelBuffer<float, HISTORY, 1, WINDOW_COUNT> windowed;
+  for (int64_t length : WINDOWS) windowed.addWindow(0, length);
+
+  Clock::duration linearTime = Clock::duration::zero();
+  Clock::duration windowedTime = Clock::duration::zero();
+  for (int i = 0; i < ROUNDS; i++) {
+    nowMs += SAMPLE_MS;
+    float row[1] = {noisySample(i)};
+    linear.push(row[0]);
+    windowed.push(row, nowMs);
+
+    Clock::time_point begin = Clock::now();
+    for (int64_t length : WINDOWS) {
+      int64_t cutoff = (int64_t)nowMs - length;
+      sink = linear.averageSince(cutoff) + linear.minSince(cutoff) + linear.maxSince(cutoff);
+    }
+    Clock::time_point middle = Clock::now();
+    for (int64_t length : WINDOWS) {
+      sink = windowed.averageOver(0, length) + windowed.minOver(0, length) + windowed.maxOver(0, length);
+    }
+    Clock::time_point end = Clock::now();
+    linearTime += middle - begin;
+    windowedTime += end - middle;
+  }
+
+  char line[128];
+  snprintf(line, sizeof(line), "linear walk: %.1f ns/query, registered window: %.1f ns/query (%.1fx)",
+           nsPerQuery(linearTime), nsPerQuery(windowedTime),
+           nsPerQuery(linearTime) / nsPerQuery(windowedTime));
+  TEST_MESSAGE(line);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_windows_match_linear_queries);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,94 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <MathBuffer.h>
+
+// The template visitors of MathBuffer against the same statistics through
+// executeOnSamplesSince(), which takes a std::function: a full 100-sample
+// buffer, every query walking all of it.
+
+static unsigned long nowMs = 0;
+unsigned long millis() { return nowMs; }
+
+static const size_t HISTORY = 100;
+static const int ROUNDS = 50000;
+
+typedef std::chrono::steady_clock Clock;
+typedef MathBuffer<float, HISTORY> Buffer;
+
+static volatile float sink;
+
+void setUp() {
+  nowMs = 1000;
+}
+
+void tearDown() {}
+
+static void fill(Buffer &buffer) {
+  for (size_t i = 0; i < HISTORY * 3; i++) {
+    nowMs += 25;
+    buffer.push(18.0f + (i % 17) * 0.01f);
+  }
+}
+
+// What averageSince() and minSince() did before the visitors
+static float averageThroughFunction(Buffer &buffer, int64_t cutoffMs) {
+  size_t sampleCount = 0;
+  float sum = 0;
+  buffer.executeOnSamplesSince(cutoffMs, [&sum, &sampleCount](float value, int64_t) {
+    sum += value;
+    sampleCount += 1;
+  });
+  return sampleCount > 0 ? sum / sampleCount : 0;
+}
+
+static float minThroughFunction(Buffer &buffer, int64_t cutoffMs) {
+  float min = 0;
+  bool isFirst = true;
+  buffer.executeOnSamplesSince(cutoffMs, [&min, &isFirst](float value, int64_t) {
+    if (isFirst || value < min) {
+      min = value;
+      isFirst = false;
+    }
+  });
+  return min;
+}
+
+static void test_same_results() {
+  Buffer buffer;
+  fill(buffer);
+  int64_t cutoff = (int64_t)nowMs - 1000;
+  TEST_ASSERT_FLOAT_WITHIN(0, averageThroughFunction(buffer, cutoff), buffer.averageSince(cutoff));
+  TEST_ASSERT_FLOAT_WITHIN(0, minThroughFunction(buffer, cutoff), buffer.minSince(cutoff));
+  TEST_ASSERT_EQUAL_size_t(41, buffer.countSamplesSince(cutoff));
+}
+
+static void test_benchmark() {
+  Buffer buffer;
+  fill(buffer);
+  int64_t cutoff = 0; // the whole buffer
+
+  Clock::time_point begin = Clock::now();
+  for (int i = 0; i < ROUNDS; i++) {
+    sink = averageThroughFunction(buffer, cutoff) + minThroughFunction(buffer, cutoff);
+  }
+  Clock::time_point middle = Clock::now();
+  for (int i = 0; i < ROUNDS; i++) {
+    sink = buffer.averageSince(cutoff) + buffer.minSince(cutoff);
+  }
+  Clock::time_point end = Clock::now();
+
+  double functionNs = std::chrono::duration<double, std::nano>(middle - begin).count() / (ROUNDS * 2);
+  double visitorNs = std::chrono::duration<double, std::nano>(end - middle).count() / (ROUNDS * 2);
+  char line[128];
+  snprintf(line, sizeof(line), "std::function: %.1f ns/query, template visitor: %.1f ns/query (%.1fx), %u samples",
+           functionNs, visitorNs, functionNs / visitorNs, (unsigned)HISTORY);
+  TEST_MESSAGE(line);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_same_results);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
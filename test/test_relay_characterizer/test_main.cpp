@@ -0,0 +1,184 @@
+#include <unity.h>
+#include <RelayCharacterizer.h>
+
+// Synthetic pulses through RelayCharacterizer: the grinder delivers a
+// constant flow from the moment the relay closes, keeps delivering it for
+// `latency` after the cut and then the in-flight mass lands over 200 ms.
+// Samples come at 80 SPS like during the relay test on the device.
+
+static const float CUP_G = 100.0f;
+static const float LANDING_S = 0.2f;
+static const uint32_t SETTLE_MS = 2500;
+
+struct PulseModel {
+  float flowGps;
+  float latencyS;
+  float inFlightG;
+  uint32_t onMs;
+};
+
+static float weightAt(const PulseModel &model, float t) {
+  if (t <= 0) return CUP_G;
+  float offS = model.onMs / 1000.0f;
+  float flowing = t < offS + model.latencyS ? t : offS + model.latencyS;
+  float landed = (t - offS - model.latencyS) / LANDING_S;
+  if (landed < 0) landed = 0;
+  if (landed > 1) landed = 1;
+  return CUP_G + model.flowGps * flowing + model.inFlightG * landed;
+}
+
+// Runs one pulse starting at startMs; at most samplesAfterCut samples are
+// added once the relay is off (-1: until the end of the settle time)
+static RelayPulse runPulse(RelayCharacterizer &characterizer, uint32_t startMs, const PulseModel &model,
+                           int samplesAfterCut = -1, uint32_t settleMs = SETTLE_MS) {
+  characterizer.beginPulse(startMs);
+  bool cut = false;
+  int afterCut = 0;
+  for (int k = 0;; k++) {
+    uint32_t t = (uint32_t)(k * 12.5f + 0.5f);
+    if (t > model.onMs + settleMs) break;
+    if (!cut && t > model.onMs) {
+      characterizer.relayOff(startMs + model.onMs);
+      cut = true;
+    }
+    if (cut && samplesAfterCut >= 0 && afterCut >= samplesAfterCut) break;
+    characterizer.addSample(startMs + t, weightAt(model, t / 1000.0f));
+    if (cut) afterCut++;
+  }
+  if (!cut) characterizer.relayOff(startMs + model.onMs);
+  return characterizer.endPulse();
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_fits_known_latency_and_in_flight() {
+  RelayCharacterizer characterizer;
+  const float flows[] = {1.0f, 1.8f, 2.6f, 3.4f};
+  uint32_t startMs = 5000;
+  for (float flow : flows) {
+    PulseModel model = {flow, 0.3f, 0.5f, 1000};
+    RelayPulse pulse = runPulse(characterizer, startMs, model);
+    TEST_ASSERT_TRUE(pulse.valid);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, flow, pulse.flowAtOffGps);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, flow * 0.3f + 0.5f, pulse.overshootG);
+    // Flow for the latency, then the in-flight mass to within 0.1 g
+    TEST_ASSERT_INT_WITHIN(15, 300 + 160, pulse.coastMs);
+    startMs += 10000;
+  }
+  TEST_ASSERT_EQUAL_size_t(4, characterizer.pulseCount());
+
+  RelayFit fit = characterizer.fit(0.25f);
+  TEST_ASSERT_TRUE(fit.valid);
+  TEST_ASSERT_TRUE(fit.latencyFitted);
+  TEST_ASSERT_EQUAL_size_t(4, fit.pulses);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.3f, fit.latencyS);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.5f, fit.inFlightG);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 0, fit.rmsErrorG);
+}
+
+// Fewer than the settled samples after the cut: the pulse is counted but
+// invalid, and the fit leaves it out
+static void test_too_few_samples_after_cut() {
+  RelayCharacterizer characterizer;
+  PulseModel model = {2.0f, 0.3f, 0.5f, 1000};
+  RelayPulse pulse = runPulse(characterizer, 1000, model, 2);
+  TEST_ASSERT_FALSE(pulse.valid);
+  TEST_ASSERT_EQUAL_size_t(1, characterizer.pulseCount());
+  TEST_ASSERT_FALSE(characterizer.fit(0.25f).valid);
+
+  pulse = runPulse(characterizer, 10000, model, 3);
+  TEST_ASSERT_TRUE(pulse.valid);
+  TEST_ASSERT_EQUAL_size_t(1, characterizer.fit(0.25f).pulses);
+}
+
+// A pulse that never got relayOff() is dropped altogether
+static void test_pulse_without_cut() {
+  RelayCharacterizer characterizer;
+  characterizer.beginPulse(0);
+  for (uint32_t t = 0; t < 1000; t += 12) characterizer.addSample(t, CUP_G);
+  TEST_ASSERT_FALSE(characterizer.endPulse().valid);
+  TEST_ASSERT_EQUAL_size_t(0, characterizer.pulseCount());
+  TEST_ASSERT_FALSE(characterizer.collecting());
+}
+
+// Flows within MIN_FLOW_SPREAD_GPS cannot separate latency from in-flight
+// mass: the fallback latency is kept and only the mass is fitted
+static void test_fallback_latency_when_flows_similar() {
+  RelayCharacterizer characterizer;
+  const float flows[] = {2.0f, 2.1f, 2.2f};
+  uint32_t startMs = 0;
+  for (float flow : flows) {
+    PulseModel model = {flow, 0.4f, 0.6f, 1000};
+    TEST_ASSERT_TRUE(runPulse(characterizer, startMs, model).valid);
+    startMs += 10000;
+  }
+  RelayFit fit = characterizer.fit(0.25f);
+  TEST_ASSERT_TRUE(fit.valid);
+  TEST_ASSERT_FALSE(fit.latencyFitted);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.25f, fit.latencyS);
+  // Mean overshoot (flow * 0.4 + 0.6 at flow 2.1) minus 0.25 * 2.1
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 2.1f * 0.4f + 0.6f - 2.1f * 0.25f, fit.inFlightG);
+  TEST_ASSERT_GREATER_THAN(0, fit.rmsErrorG);
+}
+
+// A slope outside 0..2 s is not a latency: keep the fallback
+static void test_slope_clamp() {
+  // Overshoot falling with flow: negative slope
+  RelayCharacterizer falling;
+  PulseModel low = {1.0f, 0.6f, 0.5f, 1000};
+  PulseModel high = {3.0f, 0.05f, 0.5f, 1000};
+  runPulse(falling, 0, low);
+  runPulse(falling, 10000, high);
+  RelayFit fit = falling.fit(0.25f);
+  TEST_ASSERT_TRUE(fit.valid);
+  TEST_ASSERT_FALSE(fit.latencyFitted);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.25f, fit.latencyS);
+
+  // Overshoot growing 2.5 g per g/s: slope above LATENCY_MAX_S
+  RelayCharacterizer steep;
+  PulseModel slow = {1.0f, 0.1f, 0.0f, 1000};
+  PulseModel fast = {2.0f, 1.3f, 0.0f, 1000};
+  runPulse(steep, 0, slow);
+  runPulse(steep, 10000, fast);
+  fit = steep.fit(0.25f);
+  TEST_ASSERT_TRUE(fit.valid);
+  TEST_ASSERT_FALSE(fit.latencyFitted);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.25f, fit.latencyS);
+}
+
+// More samples than MAX_SAMPLES: the pulse is dropped rather than settled on
+// a truncated tail; a pulse that just fits is fine
+static void test_max_samples_saturation() {
+  RelayCharacterizer characterizer;
+  PulseModel model = {2.0f, 0.3f, 0.5f, 1000};
+  // 384 samples at 12.5 ms are 4787.5 ms
+  RelayPulse pulse = runPulse(characterizer, 0, model, -1, 3787);
+  TEST_ASSERT_TRUE(pulse.valid);
+  pulse = runPulse(characterizer, 10000, model, -1, 3800);
+  TEST_ASSERT_FALSE(pulse.valid);
+  TEST_ASSERT_EQUAL_size_t(1, characterizer.pulseCount());
+  TEST_ASSERT_EQUAL_size_t(1, characterizer.fit(0.25f).pulses);
+}
+
+static void test_max_pulses() {
+  RelayCharacterizer characterizer;
+  PulseModel model = {2.0f, 0.3f, 0.5f, 1000};
+  for (size_t i = 0; i < RelayCharacterizer::MAX_PULSES + 2; i++) runPulse(characterizer, i * 10000, model);
+  TEST_ASSERT_EQUAL_size_t(RelayCharacterizer::MAX_PULSES, characterizer.pulseCount());
+  characterizer.reset();
+  TEST_ASSERT_EQUAL_size_t(0, characterizer.pulseCount());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fits_known_latency_and_in_flight);
+  RUN_TEST(test_too_few_samples_after_cut);
+  RUN_TEST(test_pulse_without_cut);
+  RUN_TEST(test_fallback_latency_when_flows_similar);
+  RUN_TEST(test_slope_clamp);
+  RUN_TEST(test_max_samples_saturation);
+  RUN_TEST(test_max_pulses);
+  return UNITY_END();
+}
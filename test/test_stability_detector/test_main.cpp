@@ -0,0 +1,138 @@
+#include <unity.h>
+#include <StabilityDetector.h>
+
+// StabilityDetector on synthetic signals: alternating +/-amplitude noise has
+// a standard deviation of (almost exactly) the amplitude.
+
+static const StabilityConfig CONFIG = {1000, 500, 5, 0.01f, 0.2f, 0.1f, 3.0f};
+
+static float alternating(uint32_t i, float base, float amplitude) {
+  return base + (i % 2 ? amplitude : -amplitude);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+// Constant input: stable once the window spans minSpanMs with minSamples
+static void test_span_and_count_gate() {
+  StabilityDetector detector(CONFIG);
+  for (uint32_t t = 0; t < 500; t += 100) TEST_ASSERT_FALSE(detector.push(t, 18.0f));
+  TEST_ASSERT_TRUE(detector.push(500, 18.0f));
+  TEST_ASSERT_EQUAL_UINT32(6, detector.count());
+  TEST_ASSERT_EQUAL_UINT32(500, detector.spanMs());
+
+  StabilityConfig manySamples = CONFIG;
+  manySamples.minSamples = 10;
+  detector.configure(manySamples);
+  for (uint32_t t = 0; t < 900; t += 100) TEST_ASSERT_FALSE(detector.push(t, 18.0f));
+  TEST_ASSERT_TRUE(detector.push(900, 18.0f));
+
+  // The window drops samples older than windowMs
+  for (uint32_t t = 1000; t <= 3000; t += 100) detector.push(t, 18.0f);
+  TEST_ASSERT_EQUAL_UINT32(11, detector.count());
+  TEST_ASSERT_EQUAL_UINT32(1000, detector.spanMs());
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 18.0f, detector.mean());
+}
+
+// A creeping weight is not stable even when its spread is within the limit
+static void test_slope_rejection() {
+  StabilityDetector detector(CONFIG);
+  for (uint32_t t = 0; t <= 2000; t += 25) detector.push(t, 18.0f + 0.2f * t / 1000.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.2f, detector.slope());
+  TEST_ASSERT_TRUE(detector.stdDev() < detector.limit());
+  TEST_ASSERT_FALSE(detector.stable());
+
+  detector.reset();
+  for (uint32_t t = 0; t <= 2000; t += 25) detector.push(t, 18.0f + 0.05f * t / 1000.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.05f, detector.slope());
+  TEST_ASSERT_TRUE(detector.stable());
+}
+
+// The floor starts permissive, follows quiet windows down quickly and noisier
+// ones up only slowly and only while stable
+static void test_noise_floor() {
+  StabilityDetector detector(CONFIG);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.2f, detector.limit());
+
+  uint32_t t = 0, i = 0;
+  for (; i < 60; i++, t += 25) detector.push(t, alternating(i, 18.0f, 0.001f));
+  // Clamped at minStdDev / noiseFactor
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.01f / 3.0f, detector.noiseFloor());
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.01f, detector.limit());
+
+  // Noise above the limit: not stable, and the floor does not follow it
+  // (only the first windows, still stable, nudge it up)
+  for (uint32_t n = 0; n < 200; n++, i++, t += 25) detector.push(t, alternating(i, 18.0f, 0.05f));
+  TEST_ASSERT_FALSE(detector.stable());
+  TEST_ASSERT_TRUE(detector.noiseFloor() < 0.004f);
+
+  // Slightly noisier but still stable: the floor creeps up towards it
+  detector.reset();
+  for (uint32_t n = 0; n < 40; n++, i++, t += 25) detector.push(t, alternating(i, 18.0f, 0.008f));
+  TEST_ASSERT_TRUE(detector.stable());
+  float early = detector.noiseFloor();
+  for (uint32_t n = 0; n < 400; n++, i++, t += 25) detector.push(t, alternating(i, 18.0f, 0.008f));
+  TEST_ASSERT_TRUE(detector.stable());
+  TEST_ASSERT_TRUE(detector.noiseFloor() > early);
+  TEST_ASSERT_FLOAT_WITHIN(5e-4f, 0.008f, detector.noiseFloor());
+  TEST_ASSERT_FLOAT_WITHIN(2e-3f, 0.024f, detector.limit());
+}
+
+static void test_reset_keeps_floor() {
+  StabilityDetector detector(CONFIG);
+  for (uint32_t i = 0; i < 60; i++) detector.push(i * 25, alternating(i, 18.0f, 0.001f));
+  TEST_ASSERT_TRUE(detector.stable());
+  float floor = detector.noiseFloor();
+
+  detector.reset();
+  TEST_ASSERT_FALSE(detector.stable());
+  TEST_ASSERT_EQUAL_UINT32(0, detector.count());
+  TEST_ASSERT_FLOAT_WITHIN(0, floor, detector.noiseFloor());
+
+  // configure() starts over from the permissive floor
+  detector.configure(CONFIG);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.2f / 3.0f, detector.noiseFloor());
+}
+
+// A timestamp before the previous one (e.g. a restarted clock) restarts the
+// window instead of producing a negative span
+static void test_timestamp_rewind_restarts() {
+  StabilityDetector detector(CONFIG);
+  for (uint32_t t = 10000; t <= 11000; t += 100) detector.push(t, 18.0f);
+  TEST_ASSERT_TRUE(detector.stable());
+  TEST_ASSERT_FALSE(detector.push(5000, 30.0f));
+  TEST_ASSERT_EQUAL_UINT32(1, detector.count());
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 30.0f, detector.mean());
+  for (uint32_t t = 5100; t <= 5500; t += 100) detector.push(t, 30.0f);
+  TEST_ASSERT_TRUE(detector.stable());
+}
+
+static void test_stable_for() {
+  StabilityDetector detector(CONFIG);
+  for (uint32_t t = 0; t <= 1500; t += 100) detector.push(t, 18.0f);
+  // Stable since the sample at 500 ms
+  TEST_ASSERT_EQUAL_UINT32(1000, detector.stableForMs());
+  TEST_ASSERT_EQUAL_UINT32(1000, detector.state().stableForMs);
+
+  // A jump breaks it; the count starts again once the window is flat
+  detector.push(1600, 25.0f);
+  TEST_ASSERT_FALSE(detector.stable());
+  TEST_ASSERT_EQUAL_UINT32(0, detector.stableForMs());
+  uint32_t t = 1700;
+  while (!detector.push(t, 25.0f)) t += 100;
+  TEST_ASSERT_EQUAL_UINT32(0, detector.stableForMs());
+  detector.push(t + 300, 25.0f);
+  TEST_ASSERT_EQUAL_UINT32(300, detector.stableForMs());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_span_and_count_gate);
+  RUN_TEST(test_slope_rejection);
+  RUN_TEST(test_noise_floor);
+  RUN_TEST(test_reset_keeps_floor);
+  RUN_TEST(test_timestamp_rewind_restarts);
+  RUN_TEST(test_stable_for);
+  return UNITY_END();
+}
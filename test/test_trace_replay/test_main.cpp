@@ -0,0 +1,142 @@
+#include <unity.h>
+#include <TraceReplay.h>
+
+static const float CUP_G = 70.0f;
+static const float TARGET_G = 88.0f;
+static const float SETTLED_G = 88.6f;
+static const uint32_t RECORDED_STOP_MS = 9000; // 2 g/s from the cup to 88 g
+static const uint8_t STATE_GRINDING = 1;
+static const uint8_t STATE_FINISHED = 2;
+
+static uint8_t traceBuffer[4096];
+
+// A grind as the device records it at 10 SPS: 2 g/s until the threshold
+// stop, the weight settling above the target, then the cup lifted off
+static size_t recordTrace(bool withSettled) {
+  GrindTraceHeader info = {};
+  info.shotId = 7;
+  info.factor1 = 1000.0f;
+  info.factor2 = 1000.0f;
+  info.targetG = TARGET_G;
+  info.cupG = CUP_G;
+  GrindTraceWriter writer;
+  writer.begin(traceBuffer, sizeof(traceBuffer), info);
+
+  GrindTraceSample sample = {};
+  uint32_t now = 5000;
+  for (uint32_t ms = 0; ms <= RECORDED_STOP_MS; ms += 100, now += 100) {
+    sample.timeMs = now;
+    sample.fusedMg = (int32_t)(CUP_G * 1000) + (int32_t)(ms * 2);
+    sample.state = STATE_GRINDING;
+    writer.append(sample);
+  }
+  for (int i = 0; i < 15; i++, now += 100) {
+    sample.timeMs = now;
+    sample.fusedMg = i < 5 ? 88000 + i * 120 : (int32_t)(SETTLED_G * 1000) + (i % 2 ? 20 : -20);
+    sample.state = STATE_FINISHED;
+    writer.append(sample);
+  }
+  for (int i = 0; i < 5; i++, now += 100) {
+    sample.timeMs = now;
+    sample.fusedMg = -1000 * (i + 1);
+    sample.state = STATE_FINISHED;
+    writer.append(sample);
+  }
+  if (withSettled) writer.setSettled((int32_t)(SETTLED_G * 1000));
+  return writer.finish();
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_invalid_trace() {
+  GrindPredictor predictor;
+  ReplayEstimator estimator;
+  TraceReplay replay(predictor, estimator);
+  uint8_t garbage[80] = {};
+  ReplayResult result = replay.run(garbage, sizeof(garbage));
+  TEST_ASSERT_FALSE(result.valid);
+  TEST_ASSERT_EQUAL_INT32(-1, result.replayStopMs);
+}
+
+static void test_threshold_replay_matches_recording() {
+  GrindPredictor predictor;
+  ReplayEstimator estimator;
+  TraceReplay replay(predictor, estimator);
+  size_t length = recordTrace(true);
+  ReplayResult result = replay.run(traceBuffer, length, -1, false);
+  TEST_ASSERT_TRUE(result.valid);
+  TEST_ASSERT_EQUAL(GrindSession::STOPPED, result.state);
+  TEST_ASSERT_FALSE(result.predicted);
+  TEST_ASSERT_EQUAL_INT32(RECORDED_STOP_MS + 100, result.recordedStopMs);
+  TEST_ASSERT_INT32_WITHIN(100, RECORDED_STOP_MS, result.replayStopMs);
+  TEST_ASSERT_FLOAT_WITHIN(0.25f, TARGET_G, result.stopWeightG);
+}
+
+static void test_predictive_replay_stops_early() {
+  GrindPredictor predictor;
+  ReplayEstimator estimator;
+  TraceReplay replay(predictor, estimator);
+  size_t length = recordTrace(true);
+  ReplayResult result = replay.run(traceBuffer, length);
+  TEST_ASSERT_EQUAL(GrindSession::STOPPED, result.state);
+  TEST_ASSERT_TRUE(result.predicted);
+  TEST_ASSERT_TRUE(result.replayStopMs < result.recordedStopMs);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, TARGET_G, result.predictedFinalG);
+}
+
+static void test_target_override() {
+  GrindPredictor predictor;
+  ReplayEstimator estimator;
+  TraceReplay replay(predictor, estimator);
+  size_t length = recordTrace(true);
+  ReplayResult result = replay.run(traceBuffer, length, CUP_G + 10, false);
+  TEST_ASSERT_EQUAL(GrindSession::STOPPED, result.state);
+  TEST_ASSERT_INT32_WITHIN(100, 5000, result.replayStopMs);
+}
+
+// The trace ends with the cup lifted off; the recorded result is the
+// settled weight the device stored, not the last samples
+static void test_recorded_settled_weight() {
+  GrindPredictor predictor;
+  ReplayEstimator estimator;
+  TraceReplay replay(predictor, estimator);
+  size_t length = recordTrace(true);
+  ReplayResult result = replay.run(traceBuffer, length);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, SETTLED_G, result.recordedFinalG);
+}
+
+// Older traces without it: the first stable run of finished samples
+static void test_settled_weight_from_samples() {
+  GrindPredictor predictor;
+  ReplayEstimator estimator;
+  TraceReplay replay(predictor, estimator);
+  size_t length = recordTrace(false);
+  ReplayResult result = replay.run(traceBuffer, length);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, SETTLED_G, result.recordedFinalG);
+}
+
+static void test_deterministic() {
+  GrindPredictor predictor;
+  ReplayEstimator estimator;
+  TraceReplay replay(predictor, estimator);
+  size_t length = recordTrace(true);
+  ReplayResult first = replay.run(traceBuffer, length);
+  ReplayResult second = replay.run(traceBuffer, length);
+  TEST_ASSERT_EQUAL_UINT32(first.samples, second.samples);
+  TEST_ASSERT_EQUAL_INT32(first.replayStopMs, second.replayStopMs);
+  TEST_ASSERT_FLOAT_WITHIN(0, first.stopWeightG, second.stopWeightG);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_invalid_trace);
+  RUN_TEST(test_threshold_replay_matches_recording);
+  RUN_TEST(test_predictive_replay_stops_early);
+  RUN_TEST(test_target_override);
+  RUN_TEST(test_recorded_settled_weight);
+  RUN_TEST(test_settled_weight_from_samples);
+  RUN_TEST(test_deterministic);
+  return UNITY_END();
+}
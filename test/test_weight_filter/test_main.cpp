@@ -0,0 +1,149 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <WeightFilter.h>
+
+// FilterPipeline spec parsing and the stages' behaviour on synthetic input.
+
+// SimpleKalmanFilter::updateEstimate(), the filter the kalman stage replaces
+struct ReferenceKalman {
+  float errMeasure, errEstimate, q, lastEstimate;
+  ReferenceKalman(float mea_e, float est_e, float q) : errMeasure(mea_e), errEstimate(est_e), q(q), lastEstimate(0) {}
+  float updateEstimate(float mea) {
+    float gain = errEstimate / (errEstimate + errMeasure);
+    float current = lastEstimate + gain * (mea - lastEstimate);
+    errEstimate = (1.0f - gain) * errEstimate + fabsf(lastEstimate - current) * q;
+    lastEstimate = current;
+    return current;
+  }
+};
+
+static void assertDescribes(const char *expected, const FilterPipeline &pipeline) {
+  char text[96];
+  pipeline.describe(text, sizeof(text));
+  TEST_ASSERT_EQUAL_STRING(expected, text);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_describe_round_trip() {
+  const char *specs[] = {
+    "median:5 kalman:0.5,0.01,0.01",
+    "average:8",
+    "euro:1,0.05,1",
+    "median:3 average:4 kalman:2,1,0.5",
+  };
+  for (const char *spec : specs) {
+    FilterPipeline pipeline;
+    TEST_ASSERT_TRUE(pipeline.configure(spec));
+    assertDescribes(spec, pipeline);
+
+    char text[96];
+    pipeline.describe(text, sizeof(text));
+    FilterPipeline again;
+    TEST_ASSERT_TRUE(again.configure(text));
+    assertDescribes(spec, again);
+  }
+}
+
+static void test_defaults_and_spacing() {
+  FilterPipeline pipeline;
+  TEST_ASSERT_TRUE(pipeline.configure("  median   kalman:1 "));
+  TEST_ASSERT_EQUAL_size_t(2, pipeline.stageCount());
+  assertDescribes("median:5 kalman:1,0.01,0.01", pipeline);
+
+  TEST_ASSERT_TRUE(pipeline.configure(""));
+  TEST_ASSERT_EQUAL_size_t(0, pipeline.stageCount());
+  assertDescribes("none", pipeline);
+}
+
+// A rejected spec leaves the current stages in place
+static void test_rejected_specs() {
+  const char *bad[] = {
+    "median:4",                       // even window
+    "median:11",                      // above MAX_MEDIAN
+    "median:0",
+    "average:33",                     // above MAX_WINDOW
+    "kalman:0,0.01,0.01",             // measurement error must be positive
+    "kalman:abc",
+    "kalman:0.5,0.01,0.01,1",         // four parameters
+    "kalman:0.5,",
+    "median:5x",
+    "lowpass:3",
+    "median:3 median:3 median:3 none", // more than MAX_STAGES
+  };
+  FilterPipeline pipeline;
+  TEST_ASSERT_TRUE(pipeline.configure("median:3 kalman:0.5,0.01,0.01"));
+  for (const char *spec : bad) {
+    TEST_ASSERT_FALSE(pipeline.configure(spec));
+    assertDescribes("median:3 kalman:0.5,0.01,0.01", pipeline);
+  }
+}
+
+static void test_kalman_matches_simple_kalman_filter() {
+  FilterPipeline pipeline;
+  TEST_ASSERT_TRUE(pipeline.configure("kalman:0.5,0.01,0.01"));
+  ReferenceKalman reference(0.5f, 0.01f, 0.01f);
+  uint32_t seed = 7;
+  for (uint32_t i = 0; i < 500; i++) {
+    seed = seed * 1103515245u + 12345u;
+    float noise = ((seed >> 16) % 1000) / 1000.0f - 0.5f;
+    float value = (i < 200 ? 0.0f : 18.0f) + noise * 0.2f;
+    TEST_ASSERT_FLOAT_WITHIN(0, reference.updateEstimate(value), pipeline.update(i * 12, value));
+  }
+}
+
+static void test_median_rejects_spikes() {
+  FilterPipeline pipeline;
+  TEST_ASSERT_TRUE(pipeline.configure("median:5"));
+  pipeline.reset(10.0f);
+  // Isolated spikes and two in a row never reach the output
+  const float input[] = {10, 50, 10, 10, -40, 10, 10, 60, 60, 10, 10, 10};
+  uint32_t t = 0;
+  for (float value : input) TEST_ASSERT_FLOAT_WITHIN(0, 10.0f, pipeline.update(t += 12, value));
+  // A real step passes once it holds the majority of the window
+  TEST_ASSERT_FLOAT_WITHIN(0, 10.0f, pipeline.update(t += 12, 20));
+  TEST_ASSERT_FLOAT_WITHIN(0, 10.0f, pipeline.update(t += 12, 20));
+  TEST_ASSERT_FLOAT_WITHIN(0, 20.0f, pipeline.update(t += 12, 20));
+}
+
+// After reset(value) every stage starts at value: no ramp up from zero
+static void test_reset_starts_at_value() {
+  const char *specs[] = {"kalman", "median:9", "average:32", "euro", "median:3 average:8 kalman"};
+  for (const char *spec : specs) {
+    FilterPipeline pipeline;
+    TEST_ASSERT_TRUE(pipeline.configure(spec));
+    for (uint32_t i = 0; i < 50; i++) pipeline.update(i * 12, 5.0f);
+    pipeline.reset(18.0f);
+    for (uint32_t i = 0; i < 5; i++) {
+      TEST_ASSERT_FLOAT_WITHIN(1e-4f, 18.0f, pipeline.update(1000 + i * 12, 18.0f));
+    }
+  }
+}
+
+static void test_metrics() {
+  FilterPipeline pipeline;
+  TEST_ASSERT_TRUE(pipeline.configure("average:8"));
+  pipeline.reset(0);
+  for (uint32_t i = 0; i < 200; i++) pipeline.update(i * 12, i * 0.01f); // 0.01 g per sample ramp
+  const FilterStageMetrics &m = pipeline.metrics(0);
+  TEST_ASSERT_EQUAL_UINT32(200, m.samples);
+  // A moving average of 8 trails a ramp by 3.5 samples
+  TEST_ASSERT_FLOAT_WITHIN(0.002f, 0.035f, m.lagG);
+  pipeline.resetMetrics();
+  TEST_ASSERT_EQUAL_UINT32(0, pipeline.metrics(0).samples);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_describe_round_trip);
+  RUN_TEST(test_defaults_and_spacing);
+  RUN_TEST(test_rejected_specs);
+  RUN_TEST(test_kalman_matches_simple_kalman_filter);
+  RUN_TEST(test_median_rejects_spikes);
+  RUN_TEST(test_reset_starts_at_value);
+  RUN_TEST(test_metrics);
+  return UNITY_END();
+}
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Decode grind traces recorded by the scale (see lib/GrindTrace/src/GrindTrace.h).
+
+Input is either a serial log captured while sending the 'D' command (lines
+"TRACE <shot> <hex>" / "TRACE <shot> END"; other lines are ignored), or raw
+trace files copied from the LittleFS image (/traces/NN.bin).
+
+    pio device monitor | tee dump.log      # then type D
+    tools/decode_traces.py dump.log                 # one summary line per shot
+    tools/decode_traces.py dump.log --csv out/      # plus out/shot_<id>.csv
+"""
+import argparse
+import csv
+import os
+import struct
+import sys
+
+MAGIC = 0x54574247
+VERSION = 1
+FLAG_TRUNCATED = 0x0001
+FLAG_SETTLED = 0x0002
+HEADER = struct.Struct("<IHHIIIiiiIiiffffI")
+assert HEADER.size == 64
+
+STATES = {0: "empty", 1: "grinding", 2: "finished", 3: "failed", 6: "relay test"}
+STATE_FINISHED = 2
+
+# Fallback for traces without a recorded settled weight: the first run of
+# SETTLED_SAMPLES finished samples within SETTLED_SPREAD_G of each other
+SETTLED_SAMPLES = 5
+SETTLED_SPREAD_G = 0.2
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def decode(blob):
+    """Returns (header dict, list of samples) for one encoded trace."""
+    fields = HEADER.unpack_from(blob)
+    names = ("magic", "version", "flags", "shot_id", "sample_count", "data_length",
+             "raw1_base", "raw2_base", "fused_base_mg", "start_ms", "offset1", "offset2",
+             "factor1", "factor2", "target_g", "cup_g", "settled_mg")
+    hdr = dict(zip(names, fields))
+    if hdr["magic"] != MAGIC or hdr["version"] != VERSION:
+        raise ValueError("not a grind trace (magic %08x, version %d)" % (hdr["magic"], hdr["version"]))
+    data = blob[HEADER.size:HEADER.size + hdr["data_length"]]
+
+    samples = []
+    t, raw1, raw2, mg, state = hdr["start_ms"], hdr["raw1_base"], hdr["raw2_base"], hdr["fused_base_mg"], None
+    pos = 0
+    for _ in range(hdr["sample_count"]):
+        dt, pos = read_varint(data, pos)
+        if dt & 1:
+            state = data[pos]
+            pos += 1
+        d1, pos = read_varint(data, pos)
+        d2, pos = read_varint(data, pos)
+        dm, pos = read_varint(data, pos)
+        t = (t + (dt >> 1)) & 0xFFFFFFFF
+        raw1 += unzigzag(d1)
+        raw2 += unzigzag(d2)
+        mg += unzigzag(dm)
+        samples.append((t, raw1, raw2, mg, state))
+    return hdr, samples
+
+
+def load_blobs(path):
+    with open(path, "rb") as f:
+        content = f.read()
+    if len(content) >= 4 and struct.unpack_from("<I", content)[0] == MAGIC:
+        return [content]
+
+    # Serial dump: concatenate the hex payload of every shot
+    shots = {}
+    order = []
+    for line in content.decode("utf-8", errors="replace").splitlines():
+        parts = line.strip().split()
+        if len(parts) != 3 or parts[0] != "TRACE":
+            continue
+        shot = int(parts[1])
+        if shot not in shots:
+            shots[shot] = bytearray()
+            order.append(shot)
+        if parts[2] != "END":
+            shots[shot] += bytes.fromhex(parts[2])
+    return [bytes(shots[s]) for s in order]
+
+
+def settled_weight(hdr, samples):
+    """Weight the grind settled at, None if unknown. The last samples of a
+    trace are taken while the cup is lifted off, so they do not tell."""
+    if hdr["flags"] & FLAG_SETTLED:
+        return hdr["settled_mg"] / 1000.0
+    run = []
+    for sample in samples:
+        if sample[4] != STATE_FINISHED:
+            run = []
+            continue
+        run.append(sample[3] / 1000.0)
+        run = run[-SETTLED_SAMPLES:]
+        if len(run) == SETTLED_SAMPLES and max(run) - min(run) <= SETTLED_SPREAD_G:
+            return sum(run) / len(run)
+    return None
+
+
+def grams(hdr, raw, offset, factor):
+    return (raw - offset) / factor if factor else 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("inputs", nargs="+", help="serial dump log(s) or raw trace file(s)")
+    parser.add_argument("--csv", metavar="DIR", help="write one CSV per shot into DIR")
+    args = parser.parse_args()
+
+    if args.csv:
+        os.makedirs(args.csv, exist_ok=True)
+
+    for path in args.inputs:
+        for blob in load_blobs(path):
+            try:
+                hdr, samples = decode(blob)
+            except (ValueError, IndexError, struct.error) as err:
+                print("%s: skipping corrupt trace: %s" % (path, err), file=sys.stderr)
+                continue
+
+            duration = (samples[-1][0] - samples[0][0]) / 1000.0 if samples else 0.0
+            final = settled_weight(hdr, samples)
+            print("shot %5d  %4d samples  %6.2fs  target %5.2fg  cup %6.2fg  settled %7s  end %-8s%s" % (
+                hdr["shot_id"], len(samples), duration, hdr["target_g"], hdr["cup_g"],
+                "%6.2fg" % final if final is not None else "-",
+                STATES.get(samples[-1][4], "?") if samples else "-",
+                "  [truncated]" if hdr["flags"] & FLAG_TRUNCATED else ""))
+
+            if args.csv:
+                out = os.path.join(args.csv, "shot_%05d.csv" % hdr["shot_id"])
+                with open(out, "w", newline="") as f:
+                    writer = csv.writer(f)
+                    writer.writerow(["t_ms", "raw1", "raw2", "grams1", "grams2", "fused_g", "state"])
+                    t0 = samples[0][0] if samples else 0
+                    for t, raw1, raw2, mg, state in samples:
+                        writer.writerow([(t - t0) & 0xFFFFFFFF, raw1, raw2,
+                                         "%.3f" % grams(hdr, raw1, hdr["offset1"], hdr["factor1"]),
+                                         "%.3f" % grams(hdr, raw2, hdr["offset2"], hdr["factor2"]),
+                                         "%.3f" % (mg / 1000.0), STATES.get(state, state)])
+
+
+if __name__ == "__main__":
+    main()
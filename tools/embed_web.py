@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""Embed the web UI (web/) into the firmware as gzip-compressed byte arrays.
+
+Writes include/web_assets.hpp: one const (flash) array per file, gzip'd
+deterministically, plus a table with the URL, content type and an ETag
+derived from the file's content. src/web_server.cpp serves the table.
+
+Runs as a PlatformIO pre-build script (extra_scripts in platformio.ini), so
+editing a file under web/ is enough; the header is only rewritten when its
+content changes. It can also be run by hand:
+
+    tools/embed_web.py
+"""
+import gzip
+import hashlib
+import os
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+}
+
+
+def symbol(name):
+    return "WEB_" + "".join(c.upper() if c.isalnum() else "_" for c in name)
+
+
+def url(name):
+    return "/" if name == "index.html" else "/" + name
+
+
+def render(web_dir):
+    names = sorted(name for name in os.listdir(web_dir) if os.path.isfile(os.path.join(web_dir, name)))
+    lines = [
+        "// Generated by tools/embed_web.py from web/; do not edit.",
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "    const char *url;",
+        "    const char *contentType;",
+        "    const char *etag;        // quoted, as sent in the ETag header",
+        "    const uint8_t *data;     // gzip",
+        "    size_t length;",
+        "};",
+        "",
+    ]
+    table = []
+    for name in names:
+        extension = os.path.splitext(name)[1].lower()
+        if extension not in CONTENT_TYPES:
+            raise SystemExit("embed_web: no content type for %s" % name)
+        with open(os.path.join(web_dir, name), "rb") as source:
+            data = source.read()
+        packed = gzip.compress(data, compresslevel=9, mtime=0)
+        etag = hashlib.sha256(data).hexdigest()[:16]
+        lines.append("// %s: %d bytes, %d gzip'd" % (name, len(data), len(packed)))
+        lines.append("static const uint8_t %s[] PROGMEM = {" % symbol(name))
+        for i in range(0, len(packed), 16):
+            lines.append("    " + ", ".join("0x%02x" % b for b in packed[i:i + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+        table.append('    {"%s", "%s", "\\"%s\\"", %s, sizeof(%s)},' % (url(name), CONTENT_TYPES[extension], etag,
+                                                                         symbol(name), symbol(name)))
+    lines.append("static const WebAsset WEB_ASSETS[] = {")
+    lines.extend(table)
+    lines.append("};")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def embed(project_dir):
+    web_dir = os.path.join(project_dir, "web")
+    header = os.path.join(project_dir, "include", "web_assets.hpp")
+    text = render(web_dir)
+    try:
+        with open(header) as existing:
+            if existing.read() == text:
+                return
+    except FileNotFoundError:
+        pass
+    with open(header, "w") as out:
+        out.write(text)
+    print("embed_web: wrote %s" % os.path.relpath(header, project_dir))
+
+
+try:
+    Import("env")  # noqa: F821 -- defined when PlatformIO runs this as an extra script
+    embed(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        embed(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
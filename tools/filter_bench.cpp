@@ -0,0 +1,209 @@
+// Scores weight filter pipelines on recorded grind traces.
+//
+// Every trace's fused weight is run through each filter spec (syntax in
+// lib/WeightFilter/src/WeightFilter.h) and compared with a zero-phase
+// reference, a centred moving average that has no lag by construction:
+//
+//   noise   RMS of filter - reference where the weight is still (g)
+//   lag     mean of (reference - filter) / flow while grinding (ms)
+//   cross   how much later than the reference the filter reaches 90% of
+//           the final weight (ms), what a threshold stop would see
+//   spikes  samples where the filter is more than 1 g off the reference
+//   time    host compute time per sample (ns), for relative comparison only
+//
+// Input is the same as tools/decode_traces.py: raw trace files copied from
+// the LittleFS image, or a serial log captured while sending 'D'.
+//
+//   g++ -std=c++17 -O2 -Ilib/WeightFilter/src -Ilib/GrindTrace/src tools/filter_bench.cpp
+//       lib/WeightFilter/src/WeightFilter.cpp lib/GrindTrace/src/GrindTrace.cpp -o filter_bench
+//   ./filter_bench dump.log
+//   ./filter_bench --spec "median:3 kalman" --spec "euro:0.8,0.1" traces/*.bin
+#include "GrindTrace.h"
+#include "WeightFilter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Default candidates: the config.hpp profiles and a few alternatives
+static const char *const DEFAULT_SPECS[] = {
+  "none",
+  "kalman:0.5,0.01,0.01",
+  "median:5 kalman:0.5,0.01,0.01",
+  "median:3 kalman:0.5,0.01,0.01",
+  "average:8",
+  "median:5 average:4",
+  "euro:1,0.05,1",
+  "median:3 euro:1,0.05,1",
+};
+
+static const int REFERENCE_HALF_WINDOW = 3;   // samples each side of the centre
+static const float STILL_FLOW_GPS = 0.2f;     // reference flow below this counts as still
+static const float MOVING_FLOW_GPS = 0.5f;    // and above this as grinding
+static const float SPIKE_G = 1.0f;
+static const float CROSS_FRACTION = 0.9f;
+
+struct Trace {
+  uint32_t shotId;
+  std::vector<uint32_t> timeMs;
+  std::vector<float> fusedG;
+};
+
+struct Score {
+  double noiseSquares = 0;
+  size_t noiseSamples = 0;
+  double lagMs = 0;
+  size_t lagSamples = 0;
+  double crossMs = 0;
+  size_t crossings = 0;
+  size_t spikes = 0;
+  size_t samples = 0;
+  double elapsedNs = 0;
+};
+
+static bool decodeTrace(const std::vector<uint8_t> &blob, Trace &trace) {
+  GrindTraceReader reader;
+  if (!reader.begin(blob.data(), blob.size())) return false;
+  GrindTraceHeader header;
+  memcpy(&header, blob.data(), sizeof(header));
+  trace.shotId = header.shotId;
+  GrindTraceSample sample;
+  while (reader.next(sample)) {
+    trace.timeMs.push_back(sample.timeMs);
+    trace.fusedG.push_back(sample.fusedMg / 1000.0f);
+  }
+  return trace.timeMs.size() > 2 * REFERENCE_HALF_WINDOW + 1;
+}
+
+static void loadTraces(const char *path, std::vector<Trace> &traces) {
+  std::ifstream file(path, std::ios::binary);
+  std::vector<uint8_t> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::vector<std::vector<uint8_t>> blobs;
+  uint32_t magic = 0;
+  if (content.size() >= 4) memcpy(&magic, content.data(), 4);
+  if (magic == GRIND_TRACE_MAGIC) {
+    blobs.push_back(content);
+  } else {
+    // Serial dump: "TRACE <shot> <hex>" lines, one blob per shot
+    std::map<uint32_t, size_t> shots;
+    std::istringstream lines(std::string(content.begin(), content.end()));
+    std::string line;
+    while (std::getline(lines, line)) {
+      std::istringstream words(line);
+      std::string tag, payload;
+      uint32_t shot;
+      if (!(words >> tag >> shot >> payload) || tag != "TRACE") continue;
+      if (!shots.count(shot)) {
+        shots[shot] = blobs.size();
+        blobs.emplace_back();
+      }
+      if (payload == "END") continue;
+      std::vector<uint8_t> &blob = blobs[shots[shot]];
+      for (size_t i = 0; i + 1 < payload.size(); i += 2) {
+        blob.push_back((uint8_t)strtoul(payload.substr(i, 2).c_str(), nullptr, 16));
+      }
+    }
+  }
+  for (const std::vector<uint8_t> &blob : blobs) {
+    Trace trace;
+    if (decodeTrace(blob, trace)) {
+      traces.push_back(trace);
+    } else {
+      fprintf(stderr, "%s: skipping corrupt or short trace\n", path);
+    }
+  }
+}
+
+static void scoreTrace(const Trace &trace, const char *spec, Score &score) {
+  size_t n = trace.fusedG.size();
+  std::vector<float> reference(n);
+  for (size_t i = 0; i < n; i++) {
+    size_t from = i >= (size_t)REFERENCE_HALF_WINDOW ? i - REFERENCE_HALF_WINDOW : 0;
+    size_t to = std::min(n - 1, i + REFERENCE_HALF_WINDOW);
+    double sum = 0;
+    for (size_t j = from; j <= to; j++) sum += trace.fusedG[j];
+    reference[i] = sum / (to - from + 1);
+  }
+
+  FilterPipeline pipeline;
+  pipeline.configure(spec);
+  pipeline.reset(trace.fusedG[0]);
+  std::vector<float> output(n);
+  auto started = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; i++) output[i] = pipeline.update(trace.timeMs[i], trace.fusedG[i]);
+  score.elapsedNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+  score.samples += n;
+
+  // Flow and error only where the centred reference is fully defined
+  for (size_t i = REFERENCE_HALF_WINDOW; i + REFERENCE_HALF_WINDOW < n; i++) {
+    size_t before = i - REFERENCE_HALF_WINDOW, after = i + REFERENCE_HALF_WINDOW;
+    float dt = (trace.timeMs[after] - trace.timeMs[before]) / 1000.0f;
+    float flow = dt > 0 ? (reference[after] - reference[before]) / dt : 0;
+    float error = output[i] - reference[i];
+    if (fabsf(error) > SPIKE_G) score.spikes++;
+    if (fabsf(flow) < STILL_FLOW_GPS) {
+      score.noiseSquares += error * error;
+      score.noiseSamples++;
+    } else if (flow > MOVING_FLOW_GPS) {
+      score.lagMs += -error / flow * 1000.0f;
+      score.lagSamples++;
+    }
+  }
+
+  float level = reference[n - 1 - REFERENCE_HALF_WINDOW] * CROSS_FRACTION;
+  if (level <= 0) return;
+  int64_t referenceCross = -1, filterCross = -1;
+  for (size_t i = 0; i < n; i++) {
+    if (referenceCross < 0 && reference[i] >= level) referenceCross = trace.timeMs[i];
+    if (filterCross < 0 && output[i] >= level) filterCross = trace.timeMs[i];
+  }
+  if (referenceCross >= 0 && filterCross >= 0) {
+    score.crossMs += (double)(filterCross - referenceCross);
+    score.crossings++;
+  }
+}
+
+int main(int argc, char **argv) {
+  std::vector<const char *> specs;
+  std::vector<Trace> traces;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--spec") == 0 && i + 1 < argc) {
+      specs.push_back(argv[++i]);
+    } else {
+      loadTraces(argv[i], traces);
+    }
+  }
+  if (specs.empty()) specs.assign(std::begin(DEFAULT_SPECS), std::end(DEFAULT_SPECS));
+  if (traces.empty()) {
+    fprintf(stderr, "usage: %s [--spec \"<filter spec>\"]... <trace.bin|dump.log>...\n", argv[0]);
+    return 1;
+  }
+
+  size_t totalSamples = 0;
+  for (const Trace &trace : traces) totalSamples += trace.fusedG.size();
+  printf("%zu traces, %zu samples\n\n", traces.size(), totalSamples);
+  printf("%-36s %9s %9s %9s %7s %8s\n", "filter", "noise g", "lag ms", "cross ms", "spikes", "ns/smp");
+  for (const char *spec : specs) {
+    FilterPipeline check;
+    if (!check.configure(spec)) {
+      printf("%-36s invalid spec\n", spec);
+      continue;
+    }
+    Score score;
+    for (const Trace &trace : traces) scoreTrace(trace, spec, score);
+    printf("%-36s %9.4f %9.1f %9.1f %7zu %8.1f\n", spec,
+           score.noiseSamples ? sqrt(score.noiseSquares / score.noiseSamples) : 0.0,
+           score.lagSamples ? score.lagMs / score.lagSamples : 0.0,
+           score.crossings ? score.crossMs / score.crossings : 0.0, score.spikes,
+           score.samples ? score.elapsedNs / score.samples : 0.0);
+  }
+  return 0;
+}
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Load test for the live weight WebSocket (see include/weight_stream.hpp).
+
+Opens several clients on /ws/weight at once, some of them deliberately slow
+(they sleep after every message, so their send queue on the scale fills up
+and the stream coalesces), and reports per client what arrived: messages and
+samples per second, samples the scale reported as dropped, timestamp gaps and
+the longest silence. Fast clients should see every sample at the acquisition
+rate while slow ones only get fewer, larger-gap updates; meanwhile 'P' on the
+serial console shows whether the scale task's sample latency moved.
+
+Needs the websockets package (pip install websockets) and a build with
+WEB_SERVER_ENABLED.
+
+    tools/ws_load_test.py ws://192.168.1.50/ws/weight
+    tools/ws_load_test.py ws://192.168.1.50/ws/weight --clients 4 --slow 2 --duration 30
+    tools/ws_load_test.py ws://192.168.1.50/ws/weight --clients 1 --print
+"""
+import argparse
+import asyncio
+import struct
+import sys
+import time
+
+try:
+    import websockets
+except ImportError:
+    sys.exit("needs the websockets package: pip install websockets")
+
+VERSION = 1
+HEADER = struct.Struct("<BBH")
+SAMPLE = struct.Struct("<IiBB")
+assert SAMPLE.size == 10
+
+STATES = {0: "empty", 1: "grinding", 2: "finished", 3: "failed", 4: "menu", 5: "submenu", 6: "relay test",
+          8: "info"}
+
+
+def decode(message):
+    """Returns (dropped, [(time_ms, grams, state, stable), ...])."""
+    version, count, dropped = HEADER.unpack_from(message, 0)
+    if version != VERSION:
+        raise ValueError("unknown stream version %d" % version)
+    if len(message) != HEADER.size + count * SAMPLE.size:
+        raise ValueError("message of %d bytes for %d samples" % (len(message), count))
+    samples = []
+    for i in range(count):
+        time_ms, mg, state, flags = SAMPLE.unpack_from(message, HEADER.size + i * SAMPLE.size)
+        samples.append((time_ms, mg / 1000.0, state, bool(flags & 1)))
+    return dropped, samples
+
+
+class ClientStats:
+    def __init__(self, name):
+        self.name = name
+        self.messages = 0
+        self.samples = 0
+        self.bytes = 0
+        self.dropped = 0
+        self.gaps = 0
+        self.out_of_order = 0
+        self.max_silence = 0.0
+        self.intervals = []
+        self.last_time_ms = None
+        self.last_sample = None
+        self.error = None
+
+
+async def run_client(url, stats, slow_delay, duration, print_samples):
+    deadline = time.monotonic() + duration
+    try:
+        async with websockets.connect(url, max_queue=None) as socket:
+            last_arrival = time.monotonic()
+            while True:
+                remaining = deadline - time.monotonic()
+                if remaining <= 0:
+                    break
+                try:
+                    message = await asyncio.wait_for(socket.recv(), remaining)
+                except asyncio.TimeoutError:
+                    break
+                now = time.monotonic()
+                stats.max_silence = max(stats.max_silence, now - last_arrival)
+                last_arrival = now
+                if isinstance(message, str):
+                    continue
+                dropped, samples = decode(message)
+                stats.messages += 1
+                stats.bytes += len(message)
+                stats.dropped += dropped
+                for sample in samples:
+                    time_ms = sample[0]
+                    if stats.last_time_ms is not None:
+                        interval = time_ms - stats.last_time_ms
+                        if interval <= 0:
+                            stats.out_of_order += 1
+                        else:
+                            stats.intervals.append(interval)
+                    stats.last_time_ms = time_ms
+                    stats.last_sample = sample
+                    if print_samples:
+                        print("%10d ms %9.3f g  %-10s %s" % (time_ms, sample[1], STATES.get(sample[2], sample[2]),
+                                                             "stable" if sample[3] else ""))
+                stats.samples += len(samples)
+                if slow_delay:
+                    await asyncio.sleep(slow_delay)
+    except Exception as error:  # report and let the other clients finish
+        stats.error = error
+
+
+def summarize(stats, duration):
+    intervals = sorted(stats.intervals)
+    if intervals:
+        median = intervals[len(intervals) // 2]
+        stats.gaps = sum(1 for interval in intervals if interval > 2 * median)
+    else:
+        median = 0
+    line = "%-8s %6.1f msg/s %7.1f smp/s %7.1f kB/s  median %3d ms  dropped %6d  gaps %5d  silence %5.2f s" % (
+        stats.name, stats.messages / duration, stats.samples / duration, stats.bytes / duration / 1000, median,
+        stats.dropped, stats.gaps, stats.max_silence)
+    if stats.out_of_order:
+        line += "  out of order %d" % stats.out_of_order
+    if stats.last_sample:
+        line += "  last %.2f g %s" % (stats.last_sample[1], STATES.get(stats.last_sample[2], stats.last_sample[2]))
+    if stats.error:
+        line += "  ERROR %s" % stats.error
+    print(line)
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("url", help="ws://<scale address>/ws/weight")
+    parser.add_argument("--clients", type=int, default=3, help="number of clients (default 3)")
+    parser.add_argument("--slow", type=int, default=1, help="how many of them are slow (default 1)")
+    parser.add_argument("--slow-delay", type=float, default=0.5, help="seconds a slow client sleeps per message")
+    parser.add_argument("--duration", type=float, default=20, help="seconds to run (default 20)")
+    parser.add_argument("--print", action="store_true", help="print the samples of the first client")
+    args = parser.parse_args()
+
+    clients = []
+    for i in range(args.clients):
+        slow = i >= args.clients - args.slow
+        clients.append((ClientStats(("slow%d" if slow else "fast%d") % i), args.slow_delay if slow else 0))
+    await asyncio.gather(*(run_client(args.url, stats, delay, args.duration, args.print and i == 0)
+                           for i, (stats, delay) in enumerate(clients)))
+    print("\n%d clients on %s for %.0f s" % (args.clients, args.url, args.duration))
+    for stats, _ in clients:
+        summarize(stats, args.duration)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())